@@ -29,6 +29,20 @@
 
 #include <asm-generic/bitops/ffz.h>
 #include <asm-generic/bitops/fls64.h>
+
+/* Two-words-per-load scanning, see arch/arm64/lib/bitmap.c */
+#define find_next_bit find_next_bit
+extern u64 find_next_bit(const u64 *addr, u64 size, u64 offset);
+#define find_next_zero_bit find_next_zero_bit
+extern u64 find_next_zero_bit(const u64 *addr, u64 size, u64 offset);
+#define find_next_and_bit find_next_and_bit
+extern u64 find_next_and_bit(const u64 *addr1, const u64 *addr2, u64 size,
+			     u64 offset);
+
+#ifdef CONFIG_KERNEL_MODE_NEON
+#define __HAVE_ARCH_BITMAP_WEIGHT
+#endif
+
 #include <asm-generic/bitops/find.h>
 
 #include <asm-generic/bitops/sched.h>
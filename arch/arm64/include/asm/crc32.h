@@ -0,0 +1,8 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __ASM_CRC32_H_
+#define __ASM_CRC32_H_
+
+/* Picks the CRC32/CRC32C implementation, see arch/arm64/lib/crc32-glue.c */
+extern void crc32_arm64_init(void);
+
+#endif /* !__ASM_CRC32_H_ */
@@ -139,6 +139,10 @@ typedef struct user_fpsimd_state elf_fpregset_t;
  */
 #define ELF_PLAT_INIT(_r, load_addr)	(_r)->regs[0] = 0
 
+#define ARCH_HAS_SETUP_ADDITIONAL_PAGES
+struct mm_struct;
+extern int arch_setup_additional_pages(struct mm_struct *mm);
+
 #endif /* !__ASSEMBLY__ */
 
 #endif /* !__ASM_ELF_H_ */
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2012 ARM Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __ASM_FP_H_
+#define __ASM_FP_H_
+
+#include <asm/ptrace.h>
+
+#ifndef __ASSEMBLY__
+
+#include <linux/percpu.h>
+
+struct task_struct;
+
+extern void fpsimd_save_state(struct user_fpsimd_state *state);
+extern void fpsimd_load_state(struct user_fpsimd_state *state);
+
+extern void fpsimd_save(void);
+extern void fpsimd_thread_switch(struct task_struct *next);
+extern void fpsimd_flush_task_state(struct task_struct *target);
+extern void fpsimd_flush_cpu_state(void);
+extern void fpsimd_restore_current_state(void);
+
+extern bool system_supports_fpsimd(void);
+extern void fpsimd_init(void);
+
+DECLARE_PER_CPU(bool, kernel_neon_busy);
+
+#endif
+
+#endif
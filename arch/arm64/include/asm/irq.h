@@ -0,0 +1,17 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __ASM_IRQ_H
+#define __ASM_IRQ_H
+
+#ifndef __ASSEMBLY__
+
+/* GIC interrupt IDs 1020 and up are special */
+#define NR_IRQS		1020
+
+struct pt_regs;
+
+extern void (*handle_arch_irq)(struct pt_regs *);
+extern void set_handle_irq(void (*handle_irq)(struct pt_regs *));
+extern void init_IRQ(void);
+
+#endif /* !__ASSEMBLY__ */
+#endif
@@ -25,6 +25,7 @@ struct mm_struct;
 
 typedef struct {
 	atomic64_t id;
+	void		*vdso;
 	u64		flags;
 } mm_context_t;
 
@@ -39,6 +40,7 @@ typedef struct {
 	.pgd = init_pg_dir,
 
 extern void paging_init(void);
+extern void bootmem_init(void);
 extern void mark_rodata_ro(void);
 extern void mark_linear_text_alias_ro(void);
 extern void create_pgd_mapping(struct mm_struct *mm, phys_addr_t phys,
@@ -9,6 +9,8 @@
 
 extern void copy_page(void *to, const void *from);
 extern void clear_page(void *to);
+extern void clear_pages(void *to, unsigned int nr);
+extern void pageops_calibrate(void);
 
 extern int pfn_valid(u64 pfn);
 
@@ -22,8 +22,18 @@
 #ifndef __ASSEMBLY__
 #ifdef __KERNEL__
 
+#include <linux/const.h>
+#include <linux/string.h>
 #include <linux/types.h>
 
+#include <asm/ptrace.h>
+
+/*
+ * TASK_SIZE - the maximum size of a user space task.
+ */
+#define TASK_SIZE_64		(ULL(1) << VA_BITS)
+#define TASK_SIZE		TASK_SIZE_64
+
 static inline void cpu_relax(void)
 {
 	asm volatile("yield" ::: "memory");
@@ -51,10 +61,61 @@ static inline void spin_lock_prefetch(const void *ptr)
 		    : : "p" (ptr));
 }
 
+struct cpu_context {
+	u64 x19;
+	u64 x20;
+	u64 x21;
+	u64 x22;
+	u64 x23;
+	u64 x24;
+	u64 x25;
+	u64 x26;
+	u64 x27;
+	u64 x28;
+	u64 fp;
+	u64 sp;
+	u64 pc;
+};
+
 struct thread_struct {
+	struct cpu_context	cpu_context;	/* cpu context */
+
+	/* Saved user FP/SIMD registers, see arch/arm64/kernel/fpsimd.c */
+	struct {
+		u64			tp_value;	/* TLS register */
+		struct user_fpsimd_state fpsimd_state;
+	} uw;
+
+	unsigned int	fpsimd_cpu;	/* cpu whose registers hold our state */
 	u64		fault_address;	/* fault info */
 };
 
+static inline void start_thread_common(struct pt_regs *regs, u64 pc)
+{
+	memset(regs, 0, sizeof(*regs));
+	regs->syscallno = NO_SYSCALL;
+	regs->pc = pc;
+}
+
+static inline void start_thread(struct pt_regs *regs, u64 pc, u64 sp)
+{
+	start_thread_common(regs, pc);
+	regs->pstate = PSR_MODE_EL0t;
+	regs->sp = sp;
+}
+
+struct task_struct;
+
+extern void copy_thread(struct task_struct *p, u64 pc, u64 sp);
+
+/* The user register frame sits at the very top of the kernel stack */
+#define task_pt_regs(p) \
+	((struct pt_regs *)(THREAD_SIZE + task_stack_page(p)) - 1)
+
+/* Thread switching */
+extern struct task_struct *cpu_switch_to(struct task_struct *prev,
+					 struct task_struct *next);
+
 #endif /* __KERNEL__ */
 #endif /* !__ASSEMBLY__ */
 #endif /* !__ASM_PROCESSOR_H_ */
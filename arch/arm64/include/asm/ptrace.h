@@ -25,6 +25,9 @@
 #define CurrentEL_EL1		(1 << 2)
 #define CurrentEL_EL2		(2 << 2)
 
+/* pt_regs::syscallno when the exception was not an SVC */
+#define NO_SYSCALL		(-1)
+
 #ifndef __ASSEMBLY__
 /*
  * This struct defines the way the registers are stored on the stack during an
@@ -38,10 +38,19 @@ extern size_t strnlen(const char *, size_t);
 
 #define __HAVE_ARCH_MEMCMP
 extern int memcmp(const void *, const void *, size_t);
+extern int __memcmp(const void *, const void *, size_t);
 
 #define __HAVE_ARCH_MEMCHR
 extern void *memchr(const void *, int, size_t);
 
+#ifdef CONFIG_KERNEL_MODE_NEON
+#define __HAVE_ARCH_MEMCHR_INV
+extern void *memchr_inv(const void *, int, size_t);
+
+#define __HAVE_ARCH_MEMZERO_PAGE_CHECK
+extern bool memzero_page_check(const void *);
+#endif
+
 #define __HAVE_ARCH_MEMCPY
 extern void *memcpy(void *, const void *, size_t);
 extern void *__memcpy(void *, const void *, size_t);
@@ -54,4 +63,8 @@ extern void *__memmove(void *, const void *, size_t);
 extern void *memset(void *, int, size_t);
 extern void *__memset(void *, int, size_t);
 
+/* Size-selected variants that bypass the caches for very large buffers */
+extern void memzero_large(void *, size_t);
+extern void memcpy_large(void *, const void *, size_t);
+
 #endif /* !__ASM_STRING_H_ */
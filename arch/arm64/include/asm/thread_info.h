@@ -53,6 +53,20 @@ struct thread_info {
 	};
 };
 
+/*
+ * thread_info is the first member of task_struct, so current's flags can
+ * be reached without pulling in linux/sched.h here.
+ */
+#define current_thread_info()	((struct thread_info *)current)
+
+#define test_ti_thread_flag(ti, flag)	test_bit(flag, &(ti)->flags)
+#define set_ti_thread_flag(ti, flag)	set_bit(flag, &(ti)->flags)
+#define clear_ti_thread_flag(ti, flag)	clear_bit(flag, &(ti)->flags)
+
+#define test_thread_flag(flag)	test_ti_thread_flag(current_thread_info(), flag)
+#define set_thread_flag(flag)	set_ti_thread_flag(current_thread_info(), flag)
+#define clear_thread_flag(flag)	clear_ti_thread_flag(current_thread_info(), flag)
+
 #endif /* !__ASSEMBLY__ */
 
 /*
@@ -101,8 +115,8 @@ struct thread_info {
 #define _TIF_SVE		(1 << TIF_SVE)
 
 #define _TIF_WORK_MASK		(_TIF_NEED_RESCHED | _TIF_SIGPENDING | \
-				 _TIF_NOTIFY_RESUME | _TIF_FOREIGN_FPSTATE | \
-				 _TIF_UPROBE | _TIF_FSCHECK)
+				 _TIF_NOTIFY_RESUME | _TIF_UPROBE | \
+				 _TIF_FSCHECK)
 
 #define _TIF_SYSCALL_WORK	(_TIF_SYSCALL_TRACE | _TIF_SYSCALL_AUDIT | \
 				 _TIF_SYSCALL_TRACEPOINT | _TIF_SECCOMP | \
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2012 ARM Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __ASM_TIMEX_H_
+#define __ASM_TIMEX_H_
+
+#include <asm/arch_timer.h>
+
+typedef u64 cycles_t;
+
+/*
+ * Use the virtual counter as a cycle counter: it is always running,
+ * readable from any exception level and consistent across CPUs.
+ */
+#define get_cycles()	arch_counter_get_cntvct()
+
+#endif /* !__ASM_TIMEX_H_ */
@@ -0,0 +1,89 @@
+/*
+ * Based on arch/arm/include/asm/tlb.h
+ *
+ * Copyright (C) 2002 Russell King
+ * Copyright (C) 2012 ARM Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __ASM_TLB_H_
+#define __ASM_TLB_H_
+
+#include <linux/mm.h>
+
+struct mmu_gather;
+static inline void tlb_flush(struct mmu_gather *tlb);
+
+#include <asm-generic/tlb.h>
+
+static inline void tlb_flush(struct mmu_gather *tlb)
+{
+	struct vm_area_struct vma = { .vm_mm = tlb->mm, };
+	bool last_level = !tlb->freed_tables;
+	u64 stride = tlb_get_unmap_size(tlb);
+
+	/*
+	 * Kernel mappings are global, so there is no ASID to fall back to:
+	 * either invalidate the gathered range or everything.
+	 */
+	if (tlb->mm == &init_mm) {
+		if (tlb->fullmm || tlb->need_flush_all)
+			flush_tlb_all();
+		else
+			__flush_tlb_kernel_range(tlb->start, tlb->end,
+						 stride, last_level);
+		return;
+	}
+
+	/*
+	 * If we're tearing down the address space then we only care about
+	 * invalidating the walk-cache, since the ASID allocator won't
+	 * reallocate our ASID without invalidating the entire TLB.
+	 */
+	if (tlb->fullmm) {
+		if (!last_level)
+			flush_tlb_mm(tlb->mm);
+		return;
+	}
+
+	if (tlb->need_flush_all) {
+		flush_tlb_mm(tlb->mm);
+		return;
+	}
+
+	__flush_tlb_range(&vma, tlb->start, tlb->end, stride, last_level);
+}
+
+static inline void __pte_free_tlb(struct mmu_gather *tlb, pgtable_t pte,
+				  u64 addr)
+{
+	tlb_remove_table(tlb, pte);
+}
+
+#if CONFIG_PGTABLE_LEVELS > 2
+static inline void __pmd_free_tlb(struct mmu_gather *tlb, pmd_t *pmdp,
+				  u64 addr)
+{
+	tlb_remove_table(tlb, virt_to_page(pmdp));
+}
+#endif
+
+#if CONFIG_PGTABLE_LEVELS > 3
+static inline void __pud_free_tlb(struct mmu_gather *tlb, pud_t *pudp,
+				  u64 addr)
+{
+	tlb_remove_table(tlb, virt_to_page(pudp));
+}
+#endif
+
+#endif /* !__ASM_TLB_H_ */
@@ -128,6 +128,10 @@
  *		determined by 'stride' and only affect any walk-cache entries
  *		if 'last_level' is equal to false.
  *
+ *	__flush_tlb_kernel_range(start, end, stride, last_level)
+ *		Same as __flush_tlb_range(), but applies to kernel mappings
+ *		rather than a particular user address space.
+ *
  *
  *	Finally, take a look at asm/tlb.h to see how tlb_flush() is implemented
  *	on top of these routines, since that is our interface to the mmu_gather
@@ -223,25 +227,38 @@ static inline void flush_tlb_range(struct vm_area_struct *vma,
 	__flush_tlb_range(vma, start, end, PAGE_SIZE, false);
 }
 
-static inline void flush_tlb_kernel_range(u64 start, u64 end)
+static inline void __flush_tlb_kernel_range(u64 start, u64 end,
+					    u64 stride, bool last_level)
 {
 	u64 addr;
 
-	if ((end - start) > (MAX_TLBI_OPS * PAGE_SIZE)) {
+	if ((end - start) > (MAX_TLBI_OPS * stride)) {
 		flush_tlb_all();
 		return;
 	}
 
+	/* Convert the stride into units of 4k */
+	stride >>= 12;
+
 	start = __TLBI_VADDR(start, 0);
 	end = __TLBI_VADDR(end, 0);
 
 	dsb(ishst);
-	for (addr = start; addr < end; addr += 1 << (PAGE_SHIFT - 12))
-		__tlbi(vaale1is, addr);
+	for (addr = start; addr < end; addr += stride) {
+		if (last_level)
+			__tlbi(vaale1is, addr);
+		else
+			__tlbi(vaae1is, addr);
+	}
 	dsb(ish);
 	isb();
 }
 
+static inline void flush_tlb_kernel_range(u64 start, u64 end)
+{
+	__flush_tlb_kernel_range(start, end, PAGE_SIZE, true);
+}
+
 /*
  * Used to invalidate the TLB (walk caches) corresponding to intermediate page
  * table levels (pgd/pud/pmd).
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2012 ARM Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __ASM_VDSO_DATAPAGE_H
+#define __ASM_VDSO_DATAPAGE_H
+
+#ifdef __KERNEL__
+
+#ifndef __ASSEMBLY__
+
+/*
+ * Written by the kernel, read by the vDSO. Readers retry while seq is odd
+ * or has changed under them.
+ *
+ * CLOCK_MONOTONIC is mono_ns plus the counter ticks since cs_cycle_last,
+ * times cs_mult >> cs_shift. The product is taken to 128 bits, so nothing
+ * overflows for as long as mono_ns does not.
+ */
+struct vdso_data {
+	u32 seq;		/* Timebase sequence counter */
+	u32 cs_shift;		/* Clocksource shift */
+	u64 cs_mult;		/* Nanoseconds per tick << cs_shift */
+	u64 cs_cycle_last;	/* Counter value at mono_ns */
+	u64 mono_ns;		/* Monotonic time at cs_cycle_last */
+	u64 res_ns;		/* Counter period, rounded up */
+};
+
+#endif /* !__ASSEMBLY__ */
+
+#endif /* __KERNEL__ */
+
+#endif /* __ASM_VDSO_DATAPAGE_H */
@@ -22,13 +22,26 @@
 #include <linux/mm_types.h>
 #include <linux/dma-direction.h>
 
+#include <asm/processor.h>
+#include <asm/ptrace.h>
 #include <asm/smp.h>
 
 int main(void)
 {
+	DEFINE(TSK_TI_FLAGS,		offsetof(struct task_struct, thread_info.flags));
 #ifdef CONFIG_STACKPROTECTOR
 	DEFINE(TSK_STACK_CANARY,	offsetof(struct task_struct, stack_canary));
 #endif
+	DEFINE(THREAD_CPU_CONTEXT,	offsetof(struct task_struct, thread.cpu_context));
+	BLANK();
+	DEFINE(S_X0,			offsetof(struct pt_regs, regs[0]));
+	DEFINE(S_LR,			offsetof(struct pt_regs, regs[30]));
+	DEFINE(S_SP,			offsetof(struct pt_regs, sp));
+	DEFINE(S_PC,			offsetof(struct pt_regs, pc));
+	DEFINE(S_PSTATE,		offsetof(struct pt_regs, pstate));
+	DEFINE(S_SYSCALLNO,		offsetof(struct pt_regs, syscallno));
+	DEFINE(S_STACKFRAME,		offsetof(struct pt_regs, stackframe));
+	DEFINE(S_FRAME_SIZE,		sizeof(struct pt_regs));
 	BLANK();
 	DEFINE(VMA_VM_MM,		offsetof(struct vm_area_struct, vm_mm));
 	BLANK();
@@ -0,0 +1,294 @@
+/*
+ * FP/SIMD context switching and fault handling
+ *
+ * Copyright (C) 2012 ARM Ltd.
+ * Author: Catalin Marinas <catalin.marinas@arm.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <linux/bitops.h>
+#include <linux/bug.h>
+#include <linux/init.h>
+#include <linux/percpu.h>
+#include <linux/preempt.h>
+#include <linux/sched.h>
+#include <linux/smp.h>
+
+#include <asm/current.h>
+#include <asm/cputype.h>
+#include <asm/fpsimd.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+#include <asm/sysreg.h>
+#include <asm/traps.h>
+
+/*
+ * In order to reduce the number of times the FPSIMD state is needlessly saved
+ * and restored, we need to keep track of two things:
+ * (a) for each task, we need to remember which CPU was the last one to have
+ *     the task's FPSIMD state loaded into its FPSIMD registers;
+ * (b) for each CPU, we need to remember which task's userland FPSIMD state has
+ *     been loaded into its FPSIMD registers most recently, or whether it has
+ *     been used to perform kernel mode NEON in the meantime.
+ *
+ * For (a), we add a fpsimd_cpu field to thread_struct, which gets updated to
+ * the id of the current CPU every time the state is loaded onto a CPU. For (b),
+ * we add the per-cpu variable 'fpsimd_last_state' (below), which contains the
+ * address of the userland FPSIMD state of the task that was loaded onto the CPU
+ * the most recently, or NULL if kernel mode NEON has been performed after that.
+ *
+ * With this in place, we no longer have to restore the next FPSIMD state right
+ * when switching between tasks. Instead, we can defer this check to the first
+ * FPSIMD instruction userland executes: CPACR_EL1 traps FPSIMD accesses from
+ * EL0 until then, see do_fpsimd_acc(). At that time we verify whether the
+ * CPU's fpsimd_last_state and the task's fpsimd_cpu are still mutually in
+ * sync. If this is the case, we can omit the FPSIMD restore. A task that never
+ * touches FPSIMD never takes the trap and never has its state loaded.
+ *
+ * As an optimization, we use the thread_info flag TIF_FOREIGN_FPSTATE to
+ * indicate whether or not the userland FPSIMD state of the current task is
+ * present in the registers. The flag is set unless the FPSIMD registers of this
+ * CPU currently contain the most recent userland FPSIMD state of the current
+ * task.
+ *
+ * Only while EL0 access is enabled can the registers get ahead of the copy in
+ * memory, so the state is saved on switching out only then, and access is
+ * disabled again for the next task.
+ */
+static DEFINE_PER_CPU(struct user_fpsimd_state *, fpsimd_last_state);
+
+/* Set while EL0 may use, and so change, this cpu's FPSIMD registers */
+static DEFINE_PER_CPU(bool, fpsimd_el0_enabled);
+
+/*
+ * Set while a kernel_neon_begin()/kernel_neon_end() section owns this cpu's
+ * FPSIMD registers. Callers that may run from interrupt context test it
+ * through may_use_simd() and fall back to scalar code.
+ */
+DEFINE_PER_CPU(bool, kernel_neon_busy);
+
+static bool fpsimd_present __read_mostly;
+
+bool system_supports_fpsimd(void)
+{
+	return fpsimd_present;
+}
+
+static void fpsimd_enable_el0(void)
+{
+	sysreg_clear_set(cpacr_el1, 0, CPACR_EL1_FPEN_EL0EN);
+	this_cpu_write(fpsimd_el0_enabled, true);
+}
+
+/* No isb: the exception return to EL0 synchronises the change */
+static void fpsimd_disable_el0(void)
+{
+	sysreg_clear_set(cpacr_el1, CPACR_EL1_FPEN_EL0EN, 0);
+	this_cpu_write(fpsimd_el0_enabled, false);
+}
+
+/*
+ * Ensure FPSIMD/SVE storage in memory for the loaded context is up to
+ * date with respect to the CPU registers, and trap the next access from
+ * EL0.
+ *
+ * Softirqs (and preemption) must be disabled.
+ */
+void fpsimd_save(void)
+{
+	struct user_fpsimd_state *st = this_cpu_read(fpsimd_last_state);
+
+	/* Not touched since they were loaded: memory is up to date */
+	if (!this_cpu_read(fpsimd_el0_enabled))
+		return;
+
+	if (!test_thread_flag(TIF_FOREIGN_FPSTATE) && st)
+		fpsimd_save_state(st);
+	fpsimd_disable_el0();
+}
+
+/*
+ * Bind the current task's FPSIMD state to this cpu, once it has been
+ * loaded into the registers.
+ */
+static void fpsimd_bind_to_cpu(void)
+{
+	struct user_fpsimd_state *st = &current->thread.uw.fpsimd_state;
+
+	this_cpu_write(fpsimd_last_state, st);
+	current->thread.fpsimd_cpu = smp_processor_id();
+}
+
+/*
+ * Load the userland FPSIMD state of 'current' from memory, but only if the
+ * FPSIMD state already held in the registers is /not/ the most recent FPSIMD
+ * state of 'current'
+ */
+void fpsimd_restore_current_state(void)
+{
+	if (!system_supports_fpsimd())
+		return;
+
+	preempt_disable();
+
+	if (test_and_clear_bit(TIF_FOREIGN_FPSTATE,
+			       &current_thread_info()->flags)) {
+		fpsimd_load_state(&current->thread.uw.fpsimd_state);
+		fpsimd_bind_to_cpu();
+	}
+
+	preempt_enable();
+}
+
+/*
+ * Save the outgoing task's FPSIMD state if it used the registers, and work
+ * out whether the incoming one's is still live in them. Either way the
+ * incoming task traps on its first FPSIMD access.
+ */
+void fpsimd_thread_switch(struct task_struct *next)
+{
+	bool wrong_task, wrong_cpu;
+
+	if (!system_supports_fpsimd())
+		return;
+
+	/* Save unsaved fpsimd state, if any: */
+	fpsimd_save();
+
+	/*
+	 * Fix up TIF_FOREIGN_FPSTATE to correctly describe next's
+	 * state.  For kernel threads, FPSIMD registers are never loaded
+	 * and wrong_task and wrong_cpu will always be true.
+	 */
+	wrong_task = this_cpu_read(fpsimd_last_state) !=
+					&next->thread.uw.fpsimd_state;
+	wrong_cpu = next->thread.fpsimd_cpu != smp_processor_id();
+
+	if (wrong_task || wrong_cpu)
+		set_ti_thread_flag(&next->thread_info, TIF_FOREIGN_FPSTATE);
+	else
+		clear_ti_thread_flag(&next->thread_info, TIF_FOREIGN_FPSTATE);
+}
+
+/*
+ * Trapped FPSIMD access from EL0, the first since current was switched
+ * in: load its state unless the registers still hold it, and let it use
+ * them until it is switched out.
+ */
+asmlinkage void do_fpsimd_acc(unsigned int esr, struct pt_regs *regs)
+{
+	if (!system_supports_fpsimd()) {
+		bad_el0_sync(regs, 0, esr);
+		return;
+	}
+
+	fpsimd_restore_current_state();
+	fpsimd_enable_el0();
+}
+
+/*
+ * Invalidate live CPU copies of task t's FPSIMD state
+ */
+void fpsimd_flush_task_state(struct task_struct *t)
+{
+	t->thread.fpsimd_cpu = NR_CPUS;
+}
+
+/*
+ * Invalidate any task's FPSIMD state that is present on this cpu.
+ * This function must be called with softirqs disabled.
+ */
+void fpsimd_flush_cpu_state(void)
+{
+	this_cpu_write(fpsimd_last_state, NULL);
+	set_thread_flag(TIF_FOREIGN_FPSTATE);
+}
+
+/*
+ * Kernel-side NEON support functions
+ */
+
+/*
+ * kernel_neon_begin(): obtain the CPU FPSIMD registers for use by the calling
+ * context
+ *
+ * Must not be called unless may_use_simd() returns true.
+ * Task context in the FPSIMD registers is saved back to memory as necessary.
+ *
+ * A matching call to kernel_neon_end() must be made before returning from the
+ * calling context.
+ *
+ * The caller may freely use the FPSIMD registers until kernel_neon_end() is
+ * called.
+ */
+void kernel_neon_begin(void)
+{
+	if (WARN_ON(!system_supports_fpsimd()))
+		return;
+
+	BUG_ON(!may_use_simd());
+
+	preempt_disable();
+
+	this_cpu_write(kernel_neon_busy, true);
+
+	/* Save unsaved task fpsimd state, if any: */
+	fpsimd_save();
+
+	/* Invalidate any task state remaining in the fpsimd regs: */
+	fpsimd_flush_cpu_state();
+}
+
+/*
+ * kernel_neon_end(): give the CPU FPSIMD registers back to the current task
+ *
+ * Must be called from a context in which kernel_neon_begin() was previously
+ * called, with no call to kernel_neon_end() in the meantime.
+ *
+ * The caller must not use the FPSIMD registers after this function is called,
+ * unless kernel_neon_begin() is called again in the meantime.
+ */
+void kernel_neon_end(void)
+{
+	bool busy;
+
+	if (!system_supports_fpsimd())
+		return;
+
+	busy = this_cpu_xchg(kernel_neon_busy, false);
+	WARN_ON(!busy);	/* No matching kernel_neon_begin()? */
+
+	preempt_enable();
+}
+
+/*
+ * FP/SIMD support code initialisation, called from setup_arch(). It must
+ * run before any user task does, or its first FP/SIMD access is fatal.
+ */
+void __init fpsimd_init(void)
+{
+	u64 pfr0 = read_cpuid(ID_AA64PFR0_EL1);
+
+	/*
+	 * FP and AdvSIMD are implemented together; a field value of 0xf
+	 * means "not implemented" for either of them.
+	 */
+	if (((pfr0 >> ID_AA64PFR0_FP_SHIFT) & 0xf) == 0xf ||
+	    ((pfr0 >> ID_AA64PFR0_ASIMD_SHIFT) & 0xf) == 0xf) {
+		pr_notice("Floating-point is not implemented\n");
+		return;
+	}
+
+	fpsimd_present = true;
+}
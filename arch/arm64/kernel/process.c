@@ -21,8 +21,130 @@
 #include <stdarg.h>
 #include <linux/types.h>
 #include <linux/cache.h>
+#include <linux/linkage.h>
+#include <linux/mm.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/sched/task_stack.h>
+
+#include <asm/barrier.h>
+#include <asm/fpsimd.h>
+#include <asm/mmu_context.h>
+#include <asm/processor.h>
+#include <asm/switch_to.h>
+#include <asm/thread_info.h>
 
 #if defined(CONFIG_STACKPROTECTOR) && !defined(CONFIG_STACKPROTECTOR_PER_TASK)
 #include <linux/stackprotector.h>
 u64 __stack_chk_guard __read_mostly;
 #endif
+
+asmlinkage void ret_from_fork(void) asm("ret_from_fork");
+
+/*
+ * Set up @p to enter user space at @pc with its stack pointer at @sp the
+ * first time it is switched to. In place of an auxiliary vector, x0 holds
+ * the address of the vDSO, or 0 if its address space has none.
+ */
+void copy_thread(struct task_struct *p, u64 pc, u64 sp)
+{
+	struct pt_regs *childregs = task_pt_regs(p);
+
+	memset(&p->thread.cpu_context, 0, sizeof(struct cpu_context));
+
+	/*
+	 * In case p was allocated the same task_struct pointer as some
+	 * other recently-exited task, make sure p is disassociated from
+	 * any cpu that may have run that now-exited task recently.
+	 * Otherwise we could erroneously skip reloading the FPSIMD
+	 * registers for p.
+	 */
+	fpsimd_flush_task_state(p);
+	memset(&p->thread.uw.fpsimd_state, 0,
+	       sizeof(p->thread.uw.fpsimd_state));
+	p->thread.uw.tp_value = 0;
+
+	start_thread(childregs, pc, sp);
+	childregs->regs[0] = (u64)p->mm->context.vdso;
+
+	p->thread.cpu_context.pc = (u64)ret_from_fork;
+	p->thread.cpu_context.sp = (u64)childregs;
+}
+
+static void tls_preserve_current_state(void)
+{
+	current->thread.uw.tp_value = read_sysreg(tpidr_el0);
+}
+
+/*
+ * TPIDR_EL0 is the user thread pointer and is not saved on exception
+ * entry. TPIDRRO_EL0 holds the cpu number for the vDSO and is left alone.
+ */
+static void tls_thread_switch(struct task_struct *next)
+{
+	tls_preserve_current_state();
+	write_sysreg(next->thread.uw.tp_value, tpidr_el0);
+}
+
+/*
+ * We store our current task in sp_el0, which is clobbered by userspace. Keep a
+ * shadow copy so that we can restore this upon entry from userspace.
+ *
+ * This is *only* for exception entry from EL0, and is not valid until we
+ * __switch_to() a user task.
+ */
+DEFINE_PER_CPU(struct task_struct *, __entry_task);
+
+static void entry_task_switch(struct task_struct *next)
+{
+	this_cpu_write(__entry_task, next);
+}
+
+/*
+ * Thread switching.
+ */
+struct task_struct *__switch_to(struct task_struct *prev,
+				struct task_struct *next)
+{
+	struct task_struct *last;
+
+	fpsimd_thread_switch(next);
+	tls_thread_switch(next);
+	contextidr_thread_switch(next);
+	entry_task_switch(next);
+
+	/*
+	 * Complete any pending TLB or cache maintenance on this CPU in case
+	 * the thread migrates to a different CPU.
+	 * This full barrier is also required by the membarrier system
+	 * call.
+	 */
+	dsb(ish);
+
+	/* the actual thread switch */
+	last = cpu_switch_to(prev, next);
+
+	return last;
+}
+
+/*
+ * Work to do before returning to user space, with interrupts masked; called
+ * from ret_to_user until none of _TIF_WORK_MASK is left.
+ */
+asmlinkage void do_notify_resume(struct pt_regs *regs, u64 thread_flags)
+{
+	do {
+		if (thread_flags & _TIF_NEED_RESCHED) {
+			schedule();
+		} else {
+			/* There are no signals or uprobes to deliver */
+			clear_thread_flag(TIF_SIGPENDING);
+			clear_thread_flag(TIF_NOTIFY_RESUME);
+			clear_thread_flag(TIF_UPROBE);
+			clear_thread_flag(TIF_FSCHECK);
+		}
+
+		local_irq_disable();
+		thread_flags = READ_ONCE(current_thread_info()->flags);
+	} while (thread_flags & _TIF_WORK_MASK);
+}
@@ -21,18 +21,22 @@
 #include <linux/percpu.h>
 #include <linux/smp.h>
 #include <linux/mm_types.h>
+#include <linux/initrd.h>
 #include <linux/memblock.h>
 #include <linux/of.h>
 #include <linux/mm.h>
 
 #include <asm/daifflags.h>
 #include <asm/fixmap.h>
+#include <asm/fpsimd.h>
 #include <asm/early_ioremap.h>
+#include <asm/crc32.h>
 #include <asm/cputype.h>
 #include <asm/sections.h>
 #include <asm/boot.h>
 #include <asm/kernel-pgtable.h>
 #include <asm/mmu_context.h>
+#include <asm/vdso.h>
 
 phys_addr_t __fdt_pointer __initdata;
 
@@ -54,6 +58,9 @@ void __init smp_setup_processor_id(void)
 	 * access percpu variable inside lock_release
 	 */
 	set_my_cpu_offset(0);
+
+	/* The vDSO's getcpu() reads this, see arch/arm64/kernel/vdso/ */
+	write_sysreg(0, tpidrro_el0);
 	pr_info("Booting Linux on physical CPU 0x%010llx [0x%08x]\n",
 		(u64)mpidr, read_cpuid_id());
 }
@@ -130,7 +137,7 @@ void __init arm64_memblock_init(void)
 		memblock_mem_limit_remove_map(memory_limit);
 		memblock_add(__pa_symbol(_text), (u64)(_end - _text));
 	}
-#if 0
+
 	if (IS_ENABLED(CONFIG_BLK_DEV_INITRD) && phys_initrd_size) {
 		/*
 		 * Add back the memory we just removed if it results in the
@@ -152,14 +159,14 @@ void __init arm64_memblock_init(void)
 			 base + size > memblock_start_of_DRAM() +
 				       linear_region_size,
 			"initrd not fully accessible via the linear mapping -- please check your bootloader ...\n")) {
-			initrd_start = 0;
+			phys_initrd_size = 0;
 		} else {
 			memblock_remove(base, size); /* clear MEMBLOCK_ flags */
 			memblock_add(base, size);
 			memblock_reserve(base, size);
 		}
 	}
-
+#if 0
 	if (IS_ENABLED(CONFIG_RANDOMIZE_BASE)) {
 		extern u16 memstart_offset_seed;
 		u64 range = linear_region_size -
@@ -182,13 +189,12 @@ void __init arm64_memblock_init(void)
 	 * pagetables with memblock.
 	 */
 	memblock_reserve(__pa_symbol(_text), _end - _text);
-#if 0
 	if (IS_ENABLED(CONFIG_BLK_DEV_INITRD) && phys_initrd_size) {
 		/* the generic initrd code expects virtual addresses */
 		initrd_start = __phys_to_virt(phys_initrd_start);
 		initrd_end = initrd_start + phys_initrd_size;
 	}
-
+#if 0
 	early_init_fdt_scan_reserved_mem();
 
 	/* 4GB maximum for 32-bit only capable devices */
@@ -228,6 +234,14 @@ void __init setup_arch(char **cmdline_p)
 	 */
 	local_daif_restore(DAIF_PROCCTX_NOIRQ);
 
+	/*
+	 * Long before the first user task: until fpsimd_init() has run,
+	 * do_fpsimd_acc() treats a user FP/SIMD access as an undefined
+	 * instruction, and crc32_arm64_init() needs to know about NEON.
+	 */
+	fpsimd_init();
+	crc32_arm64_init();
+
 	/*
 	 * TTBR0 is only used for the identity mapping at this stage. Make it
 	 * point to zero page to avoid speculatively fetching new entries.
@@ -237,4 +251,9 @@ void __init setup_arch(char **cmdline_p)
 	arm64_memblock_init();
 
 	paging_init();
+
+	bootmem_init();
+
+	asids_init();
+	vdso_init();
 }
@@ -9,6 +9,8 @@
  */
 #include <linux/init.h>
 #include <linux/linkage.h>
+#include <linux/percpu.h>
+#include <linux/smp.h>
 
 #include <asm/smp.h>
 
@@ -27,3 +29,12 @@ asmlinkage void secondary_start_kernel(void)
 {
 
 }
+
+void __init smp_prepare_boot_cpu(void)
+{
+	/*
+	 * Now that setup_per_cpu_areas() has run, point the boot cpu at its
+	 * own copy of the per-cpu data instead of the static template.
+	 */
+	set_my_cpu_offset(per_cpu_offset(smp_processor_id()));
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#include <linux/kernel.h>
+#include <linux/channel.h>
+#include <linux/cnode.h>
+#include <linux/ipc.h>
+#include <linux/linkage.h>
+#include <linux/notification.h>
+#include <linux/panic.h>
+#include <linux/sched.h>
+
+#include <asm/ptrace.h>
+
+/*
+ * The only system calls are the IPC, notification, channel and capability
+ * operations and thread exit; everything else is a message to a server.
+ * The two that make up a round trip are dispatched first.
+ */
+asmlinkage void el0_svc_handler(struct pt_regs *regs)
+{
+	regs->orig_x0 = regs->regs[0];
+	regs->syscallno = regs->regs[IPC_REG_SYSNO];
+
+	switch (regs->syscallno) {
+	case IPC_SYS_CALL:
+		ipc_fastpath_call(regs);
+		break;
+	case IPC_SYS_REPLY_RECV:
+		ipc_fastpath_reply_recv(regs);
+		break;
+	case IPC_SYS_SEND:
+		ipc_send(regs, false, true);
+		break;
+	case IPC_SYS_NBSEND:
+		ipc_send(regs, false, false);
+		break;
+	case IPC_SYS_RECV:
+		ipc_recv(regs);
+		break;
+	case IPC_SYS_REPLY:
+		ipc_reply(regs);
+		break;
+	case IPC_SYS_SIGNAL:
+		ipc_signal(regs);
+		break;
+	case IPC_SYS_WAIT:
+		ipc_wait(regs);
+		break;
+	case IPC_SYS_POLL:
+		ipc_poll(regs);
+		break;
+	case IPC_SYS_IRQ_SET_NTFN:
+		ipc_irq_set_notification(regs);
+		break;
+	case IPC_SYS_IRQ_ACK:
+		ipc_irq_ack(regs);
+		break;
+	case IPC_SYS_CHANNEL_MAP:
+		ipc_channel_map(regs);
+		break;
+	case IPC_SYS_CHANNEL_DOORBELL:
+		ipc_channel_set_doorbell(regs);
+		break;
+	case IPC_SYS_CHANNEL_NOTIFY:
+		ipc_channel_notify(regs);
+		break;
+	case IPC_SYS_CAP_CREATE:
+		ipc_cap_create(regs);
+		break;
+	case IPC_SYS_CAP_MINT:
+		ipc_cap_mint(regs);
+		break;
+	case IPC_SYS_CAP_DELETE:
+		ipc_cap_delete(regs);
+		break;
+	case IPC_SYS_SET_PAGER:
+		ipc_set_pager(regs);
+		break;
+	case IPC_SYS_EXIT:
+		do_exit(regs->regs[0]);
+	default:
+		pr_warn("%s[%lld]: bad syscall %d\n", current->comm,
+			task_pid_nr(current), regs->syscallno);
+	}
+}
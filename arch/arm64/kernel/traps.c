@@ -17,8 +17,16 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <linux/kernel.h>
+#include <linux/linkage.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/smp.h>
 
+#include <asm/esr.h>
 #include <asm/pgtable.h>
+#include <asm/ptrace.h>
+#include <asm/sysreg.h>
+#include <asm/traps.h>
 
 void __pte_error(const char *file, int line, u64 val)
 {
@@ -40,3 +48,74 @@ void __pgd_error(const char *file, int line, u64 val)
 	pr_err("%s:%d: bad pgd %016llx.\n", file, line, val);
 }
 
+
+static const char *handler[]= {
+	"Synchronous Abort",
+	"IRQ",
+	"FIQ",
+	"Error"
+};
+
+/*
+ * bad_mode handles the impossible case in the exception vector. This is always
+ * fatal.
+ */
+asmlinkage void bad_mode(struct pt_regs *regs, int reason, unsigned int esr)
+{
+	local_irq_disable();
+
+	pr_crit("Bad mode in %s handler detected on CPU%d, code 0x%08x\n",
+		handler[reason], smp_processor_id(), esr);
+	pr_crit("pc : %016llx sp : %016llx pstate : %08llx\n",
+		regs->pc, regs->sp, regs->pstate);
+
+	panic("bad mode");
+}
+
+#ifdef CONFIG_VMAP_STACK
+
+DEFINE_PER_CPU(u64 [OVERFLOW_STACK_SIZE/sizeof(u64)], overflow_stack)
+	__aligned(16);
+
+/*
+ * handle_bad_stack is reached on the overflow stack, from kernel_ventry,
+ * when an exception finds the stack pointer in the guard page below a task
+ * stack. This is always fatal.
+ */
+asmlinkage void handle_bad_stack(struct pt_regs *regs)
+{
+	u64 tsk_stk = (u64)current->stack;
+	u64 ovf_stk = (u64)this_cpu_ptr(overflow_stack);
+	unsigned int esr = read_sysreg(esr_el1);
+	u64 far = read_sysreg(far_el1);
+
+	pr_emerg("Insufficient stack space to handle exception!\n");
+
+	pr_emerg("ESR: 0x%08x -- EC 0x%02llx\n", esr, ESR_ELx_EC(esr));
+	pr_emerg("FAR: 0x%016llx\n", far);
+
+	pr_emerg("Task stack:     [0x%016llx..0x%016llx]\n",
+		 tsk_stk, tsk_stk + THREAD_SIZE);
+	pr_emerg("Overflow stack: [0x%016llx..0x%016llx]\n",
+		 ovf_stk, ovf_stk + OVERFLOW_STACK_SIZE);
+	pr_emerg("pc : %016llx sp : %016llx pstate : %08llx\n",
+		 regs->pc, regs->sp, regs->pstate);
+
+	panic("kernel stack overflow");
+}
+#endif
+
+/*
+ * bad_el0_sync handles unexpected, but potentially recoverable synchronous
+ * exceptions taken from EL0. There are no signals to deliver, so the thread
+ * is stopped for good instead.
+ */
+asmlinkage void bad_el0_sync(struct pt_regs *regs, int reason, unsigned int esr)
+{
+	pr_err("%s[%lld]: unhandled exception 0x%02llx (esr 0x%08x) at 0x%016llx\n",
+	       current->comm, task_pid_nr(current), ESR_ELx_EC(esr), esr,
+	       regs->pc);
+
+	current->state = TASK_UNINTERRUPTIBLE;
+	schedule();
+}
@@ -0,0 +1,129 @@
+/*
+ * VDSO implementations.
+ *
+ * Copyright (C) 2012 ARM Limited
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Will Deacon <will.deacon@arm.com>
+ */
+
+#include <linux/kernel.h>
+#include <linux/cache.h>
+#include <linux/errno.h>
+#include <linux/init.h>
+#include <linux/mm.h>
+#include <linux/mm_types.h>
+#include <linux/page_aligned.h>
+#include <linux/string.h>
+#include <linux/time64.h>
+
+#include <asm/arch_timer.h>
+#include <asm/barrier.h>
+#include <asm/elf.h>
+#include <asm/memory.h>
+#include <asm/pgtable.h>
+#include <asm/vdso.h>
+#include <asm/vdso_datapage.h>
+
+extern char vdso_start[], vdso_end[];
+static u64 vdso_pages __ro_after_init;
+
+/*
+ * The vDSO data page.
+ */
+static union {
+	struct vdso_data	data;
+	u8			page[PAGE_SIZE];
+} vdso_data_store __page_aligned_data;
+struct vdso_data *vdso_data = &vdso_data_store.data;
+
+static void vdso_write_begin(struct vdso_data *vdata)
+{
+	++vdata->seq;
+	smp_wmb();
+}
+
+static void vdso_write_end(struct vdso_data *vdata)
+{
+	smp_wmb();
+	++vdata->seq;
+}
+
+/*
+ * Start CLOCK_MONOTONIC at zero now. Nothing steers the counter, so its
+ * nominal frequency is taken as exact and the parameters never change.
+ */
+static void __init vdso_init_clock(u32 freq)
+{
+	vdso_write_begin(vdso_data);
+	vdso_data->cs_shift = 32;
+	vdso_data->cs_mult = ((u64)NSEC_PER_SEC << 32) / freq;
+	vdso_data->res_ns = DIV_ROUND_UP(NSEC_PER_SEC, freq);
+	vdso_data->cs_cycle_last = arch_counter_get_cntvct();
+	vdso_data->mono_ns = 0;
+	vdso_write_end(vdso_data);
+}
+
+/*
+ * Called from setup_arch(); until it has run, address spaces get no vDSO.
+ */
+void __init vdso_init(void)
+{
+	u32 freq = arch_timer_get_cntfrq();
+
+	if (memcmp(vdso_start, "\177ELF", 4)) {
+		pr_err("vDSO is not a valid ELF object!\n");
+		return;
+	}
+
+	if (!freq) {
+		pr_err("vDSO: counter frequency not set by firmware\n");
+		return;
+	}
+
+	vdso_init_clock(freq);
+	vdso_pages = (vdso_end - vdso_start) >> PAGE_SHIFT;
+}
+
+/**
+ * arch_setup_additional_pages - map the vDSO into an address space
+ * @mm: the address space, with nothing mapped at VDSO_BASE
+ *
+ * Sets mm->context.vdso to the vDSO text, unless there is no vDSO to map.
+ *
+ * Return: 0, or an error from map_user_pfn_range().
+ */
+int arch_setup_additional_pages(struct mm_struct *mm)
+{
+	u64 text = VDSO_BASE + PAGE_SIZE;
+	int ret;
+
+	if (!vdso_pages)
+		return 0;
+
+	ret = map_user_pfn_range(mm, VDSO_BASE, sym_to_pfn(&vdso_data_store),
+				 PAGE_SIZE, PAGE_READONLY);
+	if (ret)
+		return ret;
+
+	ret = map_user_pfn_range(mm, text, sym_to_pfn(vdso_start),
+				 vdso_pages << PAGE_SHIFT, PAGE_READONLY_EXEC);
+	if (ret) {
+		unmap_user_range(mm, VDSO_BASE, PAGE_SIZE);
+		return ret;
+	}
+
+	mm->context.vdso = (void *)text;
+	return 0;
+}
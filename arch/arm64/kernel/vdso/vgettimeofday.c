@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Userspace implementations of clock_gettime(), clock_getres() and getcpu()
+ *
+ * None of them enter the kernel. Time is the virtual counter, converted
+ * with the parameters the kernel keeps in the data page just below the
+ * vDSO text. The cpu number is in TPIDRRO_EL0, which every cpu sets to
+ * its own number as it comes up and which is never changed afterwards.
+ *
+ * There is no wall clock, so only the clocks that count from boot are
+ * provided. They all read the same: nothing adjusts the counter, and it
+ * keeps counting through any suspend.
+ */
+
+#include <linux/compiler.h>
+#include <linux/errno.h>
+#include <linux/time64.h>
+#include <linux/types.h>
+
+#include <asm/arch_timer.h>
+#include <asm/barrier.h>
+#include <asm/processor.h>
+#include <asm/sysreg.h>
+#include <asm/vdso_datapage.h>
+
+extern const struct vdso_data _vdso_data __attribute__((visibility("hidden")));
+
+static __always_inline u32 vdso_read_begin(const struct vdso_data *vd)
+{
+	u32 seq;
+
+	while ((seq = READ_ONCE(vd->seq)) & 1)
+		cpu_relax();
+
+	smp_rmb();
+	return seq;
+}
+
+static __always_inline bool vdso_read_retry(const struct vdso_data *vd,
+					    u32 start)
+{
+	smp_rmb();
+	return READ_ONCE(vd->seq) != start;
+}
+
+static __always_inline u64 vdso_mono_ns(const struct vdso_data *vd)
+{
+	u64 cycles, ns;
+	u32 seq;
+
+	do {
+		seq = vdso_read_begin(vd);
+		cycles = arch_counter_get_cntvct() - vd->cs_cycle_last;
+		ns = vd->mono_ns +
+		     (u64)(((unsigned __int128)cycles * vd->cs_mult) >>
+			   vd->cs_shift);
+	} while (unlikely(vdso_read_retry(vd, seq)));
+
+	return ns;
+}
+
+static __always_inline bool vdso_clock_supported(int clock)
+{
+	switch (clock) {
+	case CLOCK_MONOTONIC:
+	case CLOCK_MONOTONIC_RAW:
+	case CLOCK_MONOTONIC_COARSE:
+	case CLOCK_BOOTTIME:
+		return true;
+	default:
+		return false;
+	}
+}
+
+int __kernel_clock_gettime(int clock, struct __kernel_timespec *ts)
+{
+	u64 ns;
+
+	if (!vdso_clock_supported(clock))
+		return -EINVAL;
+
+	ns = vdso_mono_ns(&_vdso_data);
+	ts->tv_sec = ns / NSEC_PER_SEC;
+	ts->tv_nsec = ns % NSEC_PER_SEC;
+	return 0;
+}
+
+int __kernel_clock_getres(int clock, struct __kernel_timespec *res)
+{
+	if (!vdso_clock_supported(clock))
+		return -EINVAL;
+
+	if (res) {
+		res->tv_sec = 0;
+		res->tv_nsec = READ_ONCE(_vdso_data.res_ns);
+	}
+	return 0;
+}
+
+int __kernel_getcpu(unsigned int *cpu, unsigned int *node, void *unused)
+{
+	if (cpu)
+		*cpu = read_sysreg(tpidrro_el0);
+	if (node)
+		*node = 0;
+	return 0;
+}
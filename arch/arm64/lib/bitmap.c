@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * arm64 bitmap scanning and weight
+ *
+ * The generic helpers look at one word per iteration. Long bitmaps, such as
+ * the percpu chunk maps and the page allocator's, are mostly runs of empty
+ * (or full) words, so here the scan fetches two words with a single LDP
+ * and only tests the halves once the pair is known to hold a hit. Finding
+ * the bit within a word is __ffs(), which the compiler turns into
+ * RBIT + CLZ.
+ */
+
+#include <linux/bitmap.h>
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+
+#include <asm/neon.h>
+#include <asm/simd.h>
+
+/* Below this the FPSIMD save in kernel_neon_begin() dominates */
+#define NEON_WEIGHT_MIN_BITS	4096
+#define NEON_WEIGHT_BLOCK_BITS	512
+
+asmlinkage u64 __neon_bitmap_weight(const u64 *bitmap, size_t nblocks);
+
+static __always_inline u64 fetch_word(const u64 *addr1, const u64 *addr2,
+				      u64 idx, u64 invert)
+{
+	u64 tmp = addr1[idx];
+
+	if (addr2)
+		tmp &= addr2[idx];
+	return tmp ^ invert;
+}
+
+static __always_inline u64 _find_next_bit(const u64 *addr1,
+		const u64 *addr2, u64 nbits, u64 start, u64 invert)
+{
+	u64 idx, end, tmp, hi;
+
+	if (unlikely(start >= nbits))
+		return nbits;
+
+	/* Handle 1st word. */
+	idx = start / BITS_PER_LONG;
+	tmp = fetch_word(addr1, addr2, idx, invert) &
+	      BITMAP_FIRST_WORD_MASK(start);
+	if (tmp)
+		goto found;
+
+	end = BITS_TO_LONGS(nbits);
+	for (idx++; idx + 2 <= end; idx += 2) {
+		tmp = fetch_word(addr1, addr2, idx, invert);
+		hi = fetch_word(addr1, addr2, idx + 1, invert);
+		if (!(tmp | hi))
+			continue;
+		if (!tmp) {
+			tmp = hi;
+			idx++;
+		}
+		goto found;
+	}
+
+	if (idx < end) {
+		tmp = fetch_word(addr1, addr2, idx, invert);
+		if (tmp)
+			goto found;
+	}
+	return nbits;
+
+found:
+	return min(idx * BITS_PER_LONG + __ffs(tmp), nbits);
+}
+
+u64 find_next_bit(const u64 *addr, u64 size, u64 offset)
+{
+	return _find_next_bit(addr, NULL, size, offset, 0ULL);
+}
+
+u64 find_next_zero_bit(const u64 *addr, u64 size, u64 offset)
+{
+	return _find_next_bit(addr, NULL, size, offset, ~0ULL);
+}
+
+u64 find_next_and_bit(const u64 *addr1, const u64 *addr2, u64 size,
+		      u64 offset)
+{
+	return _find_next_bit(addr1, addr2, size, offset, 0ULL);
+}
+
+#ifdef CONFIG_KERNEL_MODE_NEON
+int __bitmap_weight(const u64 *bitmap, unsigned int bits)
+{
+	unsigned int k = 0, lim = bits / BITS_PER_LONG;
+	int w = 0;
+
+	if (bits >= NEON_WEIGHT_MIN_BITS && may_use_simd()) {
+		unsigned int nblocks = bits / NEON_WEIGHT_BLOCK_BITS;
+
+		kernel_neon_begin();
+		w = __neon_bitmap_weight(bitmap, nblocks);
+		kernel_neon_end();
+		k = nblocks * (NEON_WEIGHT_BLOCK_BITS / BITS_PER_LONG);
+	}
+
+	for (; k < lim; k++)
+		w += hweight_long(bitmap[k]);
+
+	if (bits % BITS_PER_LONG)
+		w += hweight_long(bitmap[k] & BITMAP_LAST_WORD_MASK(bits));
+
+	return w;
+}
+#endif
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * CRC32 and CRC32C selection for arm64
+ *
+ * Three implementations are available, picked per call from what
+ * ID_AA64ISAR0_EL1 advertised at boot:
+ *  - PMULL folding, 64 bytes per iteration, for buffers long enough to pay
+ *    for kernel_neon_begin();
+ *  - the CRC32 instructions, 8 bytes per step, for everything else;
+ *  - the generic table driven code on cores that have neither.
+ */
+
+#include <linux/kernel.h>
+#include <linux/crc32.h>
+#include <linux/crc32c.h>
+#include <linux/init.h>
+
+#include <asm/crc32.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+#include <asm/sysreg.h>
+
+/*
+ * crc32_pmull_le() wants at least 64 bytes in multiples of 16. Below a few
+ * hundred bytes the CRC32 instructions finish before the FPSIMD state would
+ * have been saved.
+ */
+#define PMULL_MIN_LEN		256
+#define PMULL_ALIGN		16
+
+asmlinkage u32 crc32_le_arm64(u32 crc, unsigned char const *p, size_t len);
+asmlinkage u32 __crc32c_le_arm64(u32 crc, unsigned char const *p, size_t len);
+asmlinkage void __crc32c_le_arm64_x4(u32 *crc, const void * const *p,
+				     size_t len);
+
+asmlinkage u32 crc32_pmull_le(const u8 *buf, u64 len, u32 init_crc);
+asmlinkage u32 crc32c_pmull_le(const u8 *buf, u64 len, u32 init_crc);
+
+static bool have_crc32 __read_mostly;
+static bool have_pmull __read_mostly;
+
+static u32 crc32_scalar(u32 crc, const u8 *p, size_t len)
+{
+	if (have_crc32)
+		return crc32_le_arm64(crc, p, len);
+	return crc32_le_base(crc, p, len);
+}
+
+static u32 crc32c_scalar(u32 crc, const u8 *p, size_t len)
+{
+	if (have_crc32)
+		return __crc32c_le_arm64(crc, p, len);
+	return __crc32c_le_base(crc, p, len);
+}
+
+static __always_inline u32 crc32_fold(u32 crc, const u8 *p, size_t len,
+			u32 (*scalar)(u32, const u8 *, size_t),
+			u32 (*pmull)(const u8 *, u64, u32))
+{
+	size_t l;
+
+	if (!IS_ENABLED(CONFIG_KERNEL_MODE_NEON) || !have_pmull ||
+	    len < PMULL_MIN_LEN + PMULL_ALIGN || !may_use_simd())
+		return scalar(crc, p, len);
+
+	/* Line the loads up on 16 bytes */
+	l = -(u64)p % PMULL_ALIGN;
+	if (l) {
+		crc = scalar(crc, p, l);
+		p += l;
+		len -= l;
+	}
+
+	l = round_down(len, PMULL_ALIGN);
+	kernel_neon_begin();
+	crc = pmull(p, l, crc);
+	kernel_neon_end();
+
+	if (len > l)
+		crc = scalar(crc, p + l, len - l);
+	return crc;
+}
+
+u32 __pure crc32_le(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_fold(crc, p, len, crc32_scalar, crc32_pmull_le);
+}
+
+u32 __pure __crc32c_le(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_fold(crc, p, len, crc32c_scalar, crc32c_pmull_le);
+}
+
+/*
+ * Several short buffers, e.g. the sectors of one request or a batch of
+ * packets, are run through the CRC unit four at a time rather than one
+ * after the other, so that no stream waits on the latency of the last.
+ */
+void crc32c_multi(u32 *crc, const void * const *address, unsigned int nr,
+		  unsigned int length)
+{
+	unsigned int i = 0, body = round_down(length, 8);
+
+	if (have_crc32 && body) {
+		for (; i + 4 <= nr; i += 4) {
+			unsigned int j;
+
+			__crc32c_le_arm64_x4(crc + i, address + i, body);
+			for (j = i; j < i + 4 && body < length; j++)
+				crc[j] = __crc32c_le_arm64(crc[j],
+						address[j] + body,
+						length - body);
+		}
+	}
+
+	for (; i < nr; i++)
+		crc[i] = __crc32c_le(crc[i], address[i], length);
+}
+
+/* Called from setup_arch(); nothing here needs memory */
+void __init crc32_arm64_init(void)
+{
+	u64 isar0 = read_sysreg_s(SYS_ID_AA64ISAR0_EL1);
+
+	have_crc32 = (isar0 >> ID_AA64ISAR0_CRC32_SHIFT) & 0xf;
+	/* AES field: 1 is AES only, 2 adds PMULL/PMULL2 */
+	have_pmull = ((isar0 >> ID_AA64ISAR0_AES_SHIFT) & 0xf) >= 2;
+
+	pr_info("crc32: %s\n", have_pmull ? "pmull folding" :
+		have_crc32 ? "crc32 instructions" : "generic");
+}
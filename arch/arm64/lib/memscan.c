@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * NEON versions of memchr_inv(), memcmp() and memzero_page_check()
+ *
+ * The NEON loops only locate the first 64-byte block that is not clean;
+ * the scalar routines then finish that block, so the result is exactly
+ * what the scalar code alone would have returned.
+ */
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+
+#include <asm/neon.h>
+#include <asm/page.h>
+#include <asm/simd.h>
+
+/*
+ * Below this length the FPSIMD save in kernel_neon_begin() costs more than
+ * the word-at-a-time loops, so short calls stay scalar.
+ */
+#define NEON_SCAN_MIN		512
+#define NEON_SCAN_BLOCK		64
+
+extern size_t __neon_memchr_inv_blocks(const void *src, int c,
+				       size_t nblocks);
+extern size_t __neon_memcmp_blocks(const void *src1, const void *src2,
+				   size_t nblocks);
+
+void *memchr_inv(const void *start, int c, size_t bytes)
+{
+	size_t off;
+
+	if (bytes < NEON_SCAN_MIN || !may_use_simd())
+		return __memchr_inv(start, c, bytes);
+
+	kernel_neon_begin();
+	off = __neon_memchr_inv_blocks(start, c, bytes / NEON_SCAN_BLOCK);
+	kernel_neon_end();
+
+	/* The block holding the mismatch, or the tail past the last block */
+	return __memchr_inv(start + off, c,
+			    min_t(size_t, bytes - off, NEON_SCAN_BLOCK));
+}
+
+int memcmp(const void *cs, const void *ct, size_t count)
+{
+	size_t off;
+
+	if (count < NEON_SCAN_MIN || !may_use_simd())
+		return __memcmp(cs, ct, count);
+
+	kernel_neon_begin();
+	off = __neon_memcmp_blocks(cs, ct, count / NEON_SCAN_BLOCK);
+	kernel_neon_end();
+
+	return __memcmp(cs + off, ct + off,
+			min_t(size_t, count - off, NEON_SCAN_BLOCK));
+}
+
+bool memzero_page_check(const void *addr)
+{
+	size_t off;
+
+	if (!may_use_simd())
+		return !__memchr_inv(addr, 0, PAGE_SIZE);
+
+	kernel_neon_begin();
+	off = __neon_memchr_inv_blocks(addr, 0, PAGE_SIZE / NEON_SCAN_BLOCK);
+	kernel_neon_end();
+
+	return off == PAGE_SIZE;
+}
@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Page and bulk memory clear/copy selection
+ *
+ * clear_page() and copy_page() dispatch to one of the kernels in
+ * clear_page.S and copy_page.S. Which one is fastest depends on the core:
+ * DC ZVA is a single instruction per block on most parts but is slow or
+ * prohibited on some, and the best prefetch distance follows the memory
+ * latency. So rather than guess, each candidate is timed at boot and the
+ * winner is kept.
+ *
+ * Buffers at least as large as the last level cache are always written
+ * with non-temporal stores instead: the data could not stay cached anyway,
+ * and streaming it past the caches keeps the working set of everybody else
+ * resident.
+ */
+
+#define pr_fmt(fmt) "pageops: " fmt
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/gfp.h>
+#include <linux/sizes.h>
+#include <linux/string.h>
+
+#include <asm/barrier.h>
+#include <asm/page.h>
+#include <asm/sysreg.h>
+#include <asm/timex.h>
+
+extern void __clear_pages_zva(void *dst, size_t size);
+extern void __clear_pages_stp(void *dst, size_t size);
+extern void __clear_pages_stnp(void *dst, size_t size);
+
+extern void __copy_pages_stp(void *dst, const void *src, size_t size,
+			     size_t pfdist);
+extern void __copy_pages_stnp(void *dst, const void *src, size_t size,
+			      size_t pfdist);
+
+#define DCZID_DZP		BIT(4)
+#define DCZID_BS_MASK		0xf
+
+/* 64KB: large enough to time, small enough to stay in L2 between runs */
+#define CALIB_ORDER		4
+#define CALIB_SIZE		(PAGE_SIZE << CALIB_ORDER)
+#define CALIB_ROUNDS		8
+
+/* Used when the cache hierarchy cannot be read */
+#define DEFAULT_STREAM_THRESHOLD	SZ_1M
+
+struct clear_page_variant {
+	const char *name;
+	void (*clear)(void *dst, size_t size);
+};
+
+struct copy_page_variant {
+	const char *name;
+	void (*copy)(void *dst, const void *src, size_t size, size_t pfdist);
+	size_t pfdist;
+};
+
+static const struct clear_page_variant clear_page_variants[] = {
+	{ "stp",	__clear_pages_stp },
+	{ "stnp",	__clear_pages_stnp },
+	{ "dc zva",	__clear_pages_zva },	/* must stay last, see below */
+};
+
+static const struct copy_page_variant copy_page_variants[] = {
+	{ "stnp, prefetch 128",		__copy_pages_stnp,	128 },
+	{ "stnp, prefetch 256",		__copy_pages_stnp,	256 },
+	{ "stnp, prefetch 512",		__copy_pages_stnp,	512 },
+	{ "stnp, prefetch 1024",	__copy_pages_stnp,	1024 },
+	{ "stp, prefetch 256",		__copy_pages_stp,	256 },
+	{ "stp, prefetch 512",		__copy_pages_stp,	512 },
+};
+
+/* Safe on every core until calibration has run */
+static const struct clear_page_variant *clear_page_variant __read_mostly =
+	&clear_page_variants[0];
+static const struct copy_page_variant *copy_page_variant __read_mostly =
+	&copy_page_variants[1];
+
+static size_t stream_threshold __read_mostly = DEFAULT_STREAM_THRESHOLD;
+
+void clear_page(void *to)
+{
+	clear_page_variant->clear(to, PAGE_SIZE);
+}
+
+void copy_page(void *to, const void *from)
+{
+	const struct copy_page_variant *v = copy_page_variant;
+
+	v->copy(to, from, PAGE_SIZE, v->pfdist);
+}
+
+/**
+ * clear_pages - clear a run of contiguous pages
+ * @to: page aligned start address
+ * @nr: number of pages
+ *
+ * Runs that would not fit in the last level cache are cleared with
+ * non-temporal stores.
+ */
+void clear_pages(void *to, unsigned int nr)
+{
+	size_t size = (size_t)nr << PAGE_SHIFT;
+
+	if (!nr)
+		return;
+
+	if (size >= stream_threshold)
+		__clear_pages_stnp(to, size);
+	else
+		clear_page_variant->clear(to, size);
+}
+
+/**
+ * memzero_large - zero a buffer, bypassing the caches when it is large
+ * @dst: start of the buffer
+ * @n: size of the buffer
+ *
+ * Behaves like memset(@dst, 0, @n); only buffers of at least the last level
+ * cache size take the non-temporal path.
+ */
+void memzero_large(void *dst, size_t n)
+{
+	size_t head, body;
+
+	if (n < stream_threshold) {
+		memset(dst, 0, n);
+		return;
+	}
+
+	head = PTR_ALIGN(dst, 64) - dst;
+	body = (n - head) & ~63UL;
+
+	memset(dst, 0, head);
+	__clear_pages_stnp(dst + head, body);
+	memset(dst + head + body, 0, n - head - body);
+}
+
+/**
+ * memcpy_large - copy a buffer, bypassing the caches when it is large
+ * @dst: destination
+ * @src: source, which must not overlap @dst
+ * @n: number of bytes
+ *
+ * Behaves like memcpy(); only copies of at least the last level cache size
+ * take the non-temporal path.
+ */
+void memcpy_large(void *dst, const void *src, size_t n)
+{
+	size_t head, body;
+
+	if (n < stream_threshold) {
+		memcpy(dst, src, n);
+		return;
+	}
+
+	/* Align the stores; unaligned loads are cheap on Normal memory */
+	head = PTR_ALIGN(dst, 64) - dst;
+	body = (n - head) & ~63UL;
+
+	memcpy(dst, src, head);
+	__copy_pages_stnp(dst + head, src + head, body,
+			  copy_page_variant->pfdist);
+	memcpy(dst + head + body, src + head + body, n - head - body);
+}
+
+/*
+ * Size of the outermost data or unified cache described by CLIDR_EL1, or 0
+ * if there is none. System level caches beyond the CPU's own hierarchy are
+ * not visible here, which only makes the threshold conservative.
+ */
+static size_t __init llc_size(void)
+{
+	u64 clidr = read_sysreg_s(SYS_CLIDR_EL1);
+	u64 ccsidr, line, ways, sets;
+	int level, last = 0;
+
+	for (level = 1; level <= 7; level++) {
+		u64 ctype = (clidr >> (3 * (level - 1))) & 7;
+
+		if (!ctype)
+			break;
+		/* 2: data only, 3: separate I and D, 4: unified */
+		if (ctype >= 2)
+			last = level;
+	}
+
+	if (!last)
+		return 0;
+
+	write_sysreg_s((last - 1) << 1, SYS_CSSELR_EL1);
+	isb();
+	ccsidr = read_sysreg_s(SYS_CCSIDR_EL1);
+
+	line = 1ULL << ((ccsidr & 7) + 4);
+	ways = ((ccsidr >> 3) & 0x3ff) + 1;
+	sets = ((ccsidr >> 13) & 0x7fff) + 1;
+
+	return line * ways * sets;
+}
+
+static u64 __init time_clear(const struct clear_page_variant *v, void *buf)
+{
+	u64 best = ~0ULL, t;
+	int i;
+
+	for (i = 0; i < CALIB_ROUNDS; i++) {
+		t = get_cycles();
+		v->clear(buf, CALIB_SIZE);
+		/* Non-temporal stores are only done once they have drained */
+		dsb(sy);
+		best = min(best, get_cycles() - t);
+	}
+
+	return best;
+}
+
+static u64 __init time_copy(const struct copy_page_variant *v, void *dst,
+			    const void *src)
+{
+	u64 best = ~0ULL, t;
+	int i;
+
+	for (i = 0; i < CALIB_ROUNDS; i++) {
+		t = get_cycles();
+		v->copy(dst, src, CALIB_SIZE, v->pfdist);
+		dsb(sy);
+		best = min(best, get_cycles() - t);
+	}
+
+	return best;
+}
+
+/*
+ * Called from mem_init(), as soon as the page allocator can hand out the
+ * buffers.
+ */
+void __init pageops_calibrate(void)
+{
+	int nr_clear = ARRAY_SIZE(clear_page_variants);
+	u64 dczid = read_sysreg_s(SYS_DCZID_EL0);
+	u64 t, best;
+	size_t llc;
+	void *src, *dst;
+	int i;
+
+	llc = llc_size();
+	if (llc)
+		stream_threshold = llc;
+
+	/* DC ZVA is prohibited, or its block would not fit in a page */
+	if ((dczid & DCZID_DZP) ||
+	    (4UL << (dczid & DCZID_BS_MASK)) > PAGE_SIZE)
+		nr_clear--;
+
+	src = (void *)__get_free_pages(GFP_KERNEL, CALIB_ORDER);
+	dst = (void *)__get_free_pages(GFP_KERNEL, CALIB_ORDER);
+	if (!src || !dst) {
+		pr_warn("no memory to calibrate, using defaults\n");
+		goto out;
+	}
+
+	best = ~0ULL;
+	for (i = 0; i < nr_clear; i++) {
+		t = time_clear(&clear_page_variants[i], dst);
+		if (t < best) {
+			best = t;
+			clear_page_variant = &clear_page_variants[i];
+		}
+	}
+
+	memset(src, 0x5a, CALIB_SIZE);
+	best = ~0ULL;
+	for (i = 0; i < ARRAY_SIZE(copy_page_variants); i++) {
+		t = time_copy(&copy_page_variants[i], dst, src);
+		if (t < best) {
+			best = t;
+			copy_page_variant = &copy_page_variants[i];
+		}
+	}
+
+	pr_info("clear_page: %s, copy_page: %s, streaming from %zu KB\n",
+		clear_page_variant->name, copy_page_variant->name,
+		stream_threshold >> 10);
+out:
+	if (src)
+		free_pages((u64)src, CALIB_ORDER);
+	if (dst)
+		free_pages((u64)dst, CALIB_ORDER);
+}
@@ -0,0 +1,81 @@
+/*
+ * Based on arch/arm/mm/fault.c
+ *
+ * Copyright (C) 1995  Linus Torvalds
+ * Copyright (C) 1995-2004 Russell King
+ * Copyright (C) 2012 ARM Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <linux/kernel.h>
+#include <linux/ipc.h>
+#include <linux/linkage.h>
+#include <linux/mm.h>
+#include <linux/sched.h>
+
+#include <asm/esr.h>
+#include <asm/processor.h>
+#include <asm/ptrace.h>
+
+static const char *fault_name(unsigned int esr)
+{
+	switch (esr & ESR_ELx_FSC_TYPE) {
+	case ESR_ELx_FSC_FAULT:
+		return "translation fault";
+	case ESR_ELx_FSC_ACCESS:
+		return "access flag fault";
+	case ESR_ELx_FSC_PERM:
+		return "permission fault";
+	case ESR_ELx_FSC_EXTABT:
+		return "synchronous external abort";
+	default:
+		return "unknown fault";
+	}
+}
+
+static inline bool is_el0_write_abort(unsigned int esr)
+{
+	return ESR_ELx_EC(esr) == ESR_ELx_EC_DABT_LOW &&
+	       (esr & ESR_ELx_WNR) && !(esr & ESR_ELx_CM);
+}
+
+/*
+ * Data and instruction aborts taken from EL0. Writes to copy-on-write
+ * pages are resolved here. Other faults a mapping could fix go to the
+ * thread's pager; the rest stop the thread, since there are no signals to
+ * deliver.
+ */
+asmlinkage void do_mem_abort(u64 addr, unsigned int esr,
+			     struct pt_regs *regs)
+{
+	switch (esr & ESR_ELx_FSC_TYPE) {
+	case ESR_ELx_FSC_PERM:
+		if (is_el0_write_abort(esr) && current->mm &&
+		    !do_wp_page(current->mm, addr))
+			return;
+		/* fall through */
+	case ESR_ELx_FSC_FAULT:
+	case ESR_ELx_FSC_ACCESS:
+		if (addr < TASK_SIZE) {
+			ipc_fault(regs, addr, esr);
+			return;
+		}
+	}
+
+	pr_err("%s[%lld]: unhandled %s (0x%08x) at 0x%016llx, pc 0x%016llx\n",
+	       current->comm, task_pid_nr(current), fault_name(esr), esr,
+	       addr, regs->pc);
+
+	current->state = TASK_UNINTERRUPTIBLE;
+	schedule();
+}
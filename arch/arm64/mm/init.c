@@ -8,9 +8,14 @@
 
 #include <linux/cache.h>
 #include <linux/memblock.h>
+#include <linux/mm.h>
+#include <linux/mm_types.h>
+#include <linux/mmzone.h>
+#include <linux/pfn.h>
 
 #include <asm/page.h>
 #include <asm/memory.h>
+#include <asm/mmu.h>
 /*
  * We need to be able to catch inadvertent references to memstart_addr
  * that occur (potentially in generic code) before arm64_memblock_init()
@@ -28,3 +33,46 @@ int pfn_valid(u64 pfn)
 
 	return memblock_is_map_memory(addr);
 }
+
+static void __init zone_sizes_init(u64 min, u64 max)
+{
+	u64 max_zone_pfns[MAX_NR_ZONES] = { 0 };
+
+	max_zone_pfns[ZONE_NORMAL] = max;
+
+	free_area_init_nodes(max_zone_pfns);
+}
+
+void __init bootmem_init(void)
+{
+	u64 min, max;
+
+	min = PFN_UP(memblock_start_of_DRAM());
+	max = PFN_DOWN(memblock_end_of_DRAM());
+
+	max_pfn = max;
+
+	/*
+	 * memmap_init_zone() initialises every struct page the zone spans,
+	 * holes included, so back the whole range.
+	 */
+	if (vmemmap_populate((u64)pfn_to_page(min), (u64)pfn_to_page(max)))
+		panic("Failed to allocate the memory map\n");
+
+	zone_sizes_init(min, max);
+
+	memblock_dump_all();
+}
+
+/*
+ * mem_init() marks the free areas in the mem_map and tells us how much memory
+ * is free.  This is done after various parts of the system have claimed their
+ * memory after the kernel image.
+ */
+void __init mem_init(void)
+{
+	memblock_free_all();
+
+	/* Time the clear/copy kernels now that there are pages to time on */
+	pageops_calibrate();
+}
@@ -627,6 +627,32 @@ void __init paging_init(void)
 	memblock_allow_resize();
 }
 
+/*
+ * Back the struct page array for [start, end) with section blocks taken
+ * from memblock. Only called once from bootmem_init(), so nothing in the
+ * range has been mapped yet.
+ */
+int __init vmemmap_populate(u64 start, u64 end)
+{
+	u64 addr;
+
+	start = round_down(start, PMD_SIZE);
+	end = round_up(end, PMD_SIZE);
+
+	for (addr = start; addr < end; addr += PMD_SIZE) {
+		phys_addr_t phys = memblock_phys_alloc(PMD_SIZE, PMD_SIZE);
+
+		if (!phys)
+			return -ENOMEM;
+
+		__create_pgd_mapping(init_mm.pgd, phys, addr, PMD_SIZE,
+				     PAGE_KERNEL, early_pgtable_alloc,
+				     NO_CONT_MAPPINGS);
+	}
+
+	return 0;
+}
+
 /*
  * Check whether a kernel address is valid (derived from arch/x86/).
  */
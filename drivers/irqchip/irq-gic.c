@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ *  Copyright (C) 2002 ARM Limited, All Rights Reserved.
+ *
+ * Interrupt architecture for the GIC:
+ *
+ * o There is one Interrupt Distributor, which receives interrupts
+ *   from system devices and sends them to the Interrupt Controllers.
+ *
+ * o There is one CPU Interface per CPU, which sends interrupts sent
+ *   by the Distributor, and interrupts generated locally, to the
+ *   associated CPU. The base address of the CPU interface is usually
+ *   aliased so that the same address points to different chips depending
+ *   on the CPU it is accessed from.
+ *
+ * Note that IRQs 0-31 are special - they are local to each CPU.
+ * As such, the enable set/clear, pending set/clear and active bit
+ * registers are banked per-cpu for these sources.
+ */
+#define pr_fmt(fmt) "GIC: " fmt
+
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/init.h>
+#include <linux/io.h>
+#include <linux/irq.h>
+#include <linux/irqchip/arm-gic.h>
+#include <linux/sizes.h>
+
+#include <asm/early_ioremap.h>
+#include <asm/ptrace.h>
+
+struct gic_chip_data {
+	void __iomem	*dist_base;
+	void __iomem	*cpu_base;
+	unsigned int	gic_irqs;
+};
+
+static struct gic_chip_data gic_data __read_mostly;
+
+static inline void __iomem *gic_dist_base(void)
+{
+	return gic_data.dist_base;
+}
+
+static inline void __iomem *gic_cpu_base(void)
+{
+	return gic_data.cpu_base;
+}
+
+/*
+ * Routines to acknowledge, disable and enable interrupts
+ */
+static void gic_poke_irq(unsigned int irq, u32 offset)
+{
+	u32 mask = 1 << (irq % 32);
+
+	writel_relaxed(mask, gic_dist_base() + offset + (irq / 32) * 4);
+}
+
+static void gic_mask_irq(unsigned int irq)
+{
+	gic_poke_irq(irq, GIC_DIST_ENABLE_CLEAR);
+}
+
+static void gic_unmask_irq(unsigned int irq)
+{
+	gic_poke_irq(irq, GIC_DIST_ENABLE_SET);
+}
+
+static struct irq_chip gic_chip = {
+	.name		= "GIC",
+	.irq_mask	= gic_mask_irq,
+	.irq_unmask	= gic_unmask_irq,
+};
+
+/*
+ * Take every interrupt that is pending before returning, so a burst costs
+ * one exception. Each is masked by generic_handle_irq() before its EOI,
+ * and stays masked until the user-space handler acknowledges it.
+ */
+static void gic_handle_irq(struct pt_regs *regs)
+{
+	u32 irqstat, irqnr;
+	void __iomem *cpu_base = gic_cpu_base();
+
+	do {
+		irqstat = readl_relaxed(cpu_base + GIC_CPU_INTACK);
+		irqnr = irqstat & GICC_IAR_INT_ID_MASK;
+
+		if (likely(irqnr > 15 && irqnr < 1020)) {
+			generic_handle_irq(irqnr);
+			writel_relaxed(irqstat, cpu_base + GIC_CPU_EOI);
+			continue;
+		}
+		if (irqnr < 16) {
+			/* No IPIs are sent yet */
+			writel_relaxed(irqstat, cpu_base + GIC_CPU_EOI);
+			continue;
+		}
+		break;
+	} while (1);
+}
+
+static void __init gic_dist_init(void)
+{
+	void __iomem *base = gic_dist_base();
+	unsigned int gic_irqs = gic_data.gic_irqs;
+	u32 cpumask;
+	unsigned int i;
+
+	writel_relaxed(GICD_DISABLE, base + GIC_DIST_CTRL);
+
+	/*
+	 * Set all global interrupts to this CPU only.
+	 */
+	cpumask = readl_relaxed(base + GIC_DIST_TARGET + 0);
+	cpumask |= cpumask << 8;
+	cpumask |= cpumask << 16;
+	for (i = 32; i < gic_irqs; i += 4)
+		writel_relaxed(cpumask, base + GIC_DIST_TARGET + i * 4 / 4);
+
+	/*
+	 * Set all global interrupts to be level triggered, active low.
+	 */
+	for (i = 32; i < gic_irqs; i += 16)
+		writel_relaxed(GICD_INT_ACTLOW_LVLTRIG,
+			       base + GIC_DIST_CONFIG + i / 4);
+
+	/*
+	 * Set priority on all global interrupts.
+	 */
+	for (i = 32; i < gic_irqs; i += 4)
+		writel_relaxed(GICD_INT_DEF_PRI_X4, base + GIC_DIST_PRI + i);
+
+	/*
+	 * Deactivate and disable all SPIs. Leave the PPI and SGIs alone
+	 * as they are enabled by redistributor registers.
+	 */
+	for (i = 32; i < gic_irqs; i += 32) {
+		writel_relaxed(GICD_INT_EN_CLR_X32,
+			       base + GIC_DIST_ACTIVE_CLEAR + i / 8);
+		writel_relaxed(GICD_INT_EN_CLR_X32,
+			       base + GIC_DIST_ENABLE_CLEAR + i / 8);
+	}
+
+	writel_relaxed(GICD_ENABLE, base + GIC_DIST_CTRL);
+}
+
+static void gic_cpu_init(void)
+{
+	void __iomem *dist_base = gic_dist_base();
+	void __iomem *base = gic_cpu_base();
+	unsigned int i;
+
+	/*
+	 * Deal with the banked PPI and SGI interrupts - disable all
+	 * PPI interrupts, ensure all SGI interrupts are enabled.
+	 * Make sure everything is deactivated.
+	 */
+	writel_relaxed(GICD_INT_EN_CLR_X32, dist_base + GIC_DIST_ACTIVE_CLEAR);
+	writel_relaxed(GICD_INT_EN_CLR_PPI, dist_base + GIC_DIST_ENABLE_CLEAR);
+	writel_relaxed(GICD_INT_EN_SET_SGI, dist_base + GIC_DIST_ENABLE_SET);
+
+	/*
+	 * Set priority on PPI and SGI interrupts
+	 */
+	for (i = 0; i < 32; i += 4)
+		writel_relaxed(GICD_INT_DEF_PRI_X4,
+			       dist_base + GIC_DIST_PRI + i * 4 / 4);
+
+	writel_relaxed(GICC_INT_PRI_THRESHOLD, base + GIC_CPU_PRIMASK);
+	writel_relaxed(GICC_ENABLE, base + GIC_CPU_CTRL);
+}
+
+/**
+ * gic_init - bring up the distributor and the boot CPU's interface
+ * @dist_phys: physical address of the distributor
+ * @cpu_phys: physical address of the CPU interface
+ *
+ * Return: 0, or -ENOMEM if the registers cannot be mapped.
+ */
+int __init gic_init(phys_addr_t dist_phys, phys_addr_t cpu_phys)
+{
+	unsigned int gic_irqs;
+
+	gic_data.dist_base = early_ioremap(dist_phys, SZ_4K);
+	gic_data.cpu_base = early_ioremap(cpu_phys, SZ_4K);
+	if (!gic_data.dist_base || !gic_data.cpu_base)
+		return -ENOMEM;
+
+	/*
+	 * Find out how many interrupts are supported.
+	 * The GIC only supports up to 1020 interrupt sources.
+	 */
+	gic_irqs = readl_relaxed(gic_dist_base() + GIC_DIST_CTR) & 0x1f;
+	gic_irqs = (gic_irqs + 1) * 32;
+	if (gic_irqs > 1020)
+		gic_irqs = 1020;
+	gic_data.gic_irqs = gic_irqs;
+
+	gic_dist_init();
+	gic_cpu_init();
+
+	irq_set_chip(&gic_chip);
+	set_handle_irq(gic_handle_irq);
+
+	pr_info("%u interrupts\n", gic_irqs);
+	return 0;
+}
+
+void gic_secondary_init(void)
+{
+	gic_cpu_init();
+}
@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Interrupt controller bring-up
+ *
+ * Like the console UART, the controller is found at the address of the
+ * QEMU virt machine, which has a GICv2.
+ */
+
+#include <linux/init.h>
+#include <linux/irqchip.h>
+#include <linux/irqchip/arm-gic.h>
+#include <linux/printk.h>
+
+#define VIRT_GIC_DIST_BASE	0x08000000
+#define VIRT_GIC_CPU_BASE	0x08010000
+
+void __init irqchip_init(void)
+{
+	if (IS_ENABLED(CONFIG_ARM_GIC) &&
+	    !gic_init(VIRT_GIC_DIST_BASE, VIRT_GIC_CPU_BASE))
+		return;
+
+	pr_err("no interrupt controller\n");
+}
@@ -9,6 +9,7 @@
 #define pr_fmt(fmt)	"OF: fdt: " fmt
 
 #include <linux/crc32.h>
+#include <linux/initrd.h>
 #include <linux/kernel.h>
 #include <linux/memblock.h>
 #include <linux/mm.h>
@@ -83,6 +84,49 @@ const void *__init of_get_flat_dt_prop(u64 node, const char *name,
 	return fdt_getprop(initial_boot_params, node, name, size);
 }
 
+/* Helper to read a big number; size is in cells (not bytes) */
+static inline u64 of_read_number(const __be32 *cell, int size)
+{
+	u64 r = 0;
+	while (size--)
+		r = (r << 32) | be32_to_cpu(*(cell++));
+	return r;
+}
+
+#ifdef CONFIG_BLK_DEV_INITRD
+/**
+ * early_init_dt_check_for_initrd - Decode initrd location from flat tree
+ * @node: reference to node containing initrd location ('chosen')
+ */
+static void __init early_init_dt_check_for_initrd(u64 node)
+{
+	u64 start, end;
+	int len;
+	const __be32 *prop;
+
+	pr_debug("Looking for initrd properties... ");
+
+	prop = of_get_flat_dt_prop(node, "linux,initrd-start", &len);
+	if (!prop)
+		return;
+	start = of_read_number(prop, len/4);
+
+	prop = of_get_flat_dt_prop(node, "linux,initrd-end", &len);
+	if (!prop)
+		return;
+	end = of_read_number(prop, len/4);
+
+	phys_initrd_start = start;
+	phys_initrd_size = end - start;
+
+	pr_debug("initrd_start=0x%llx  initrd_end=0x%llx\n", start, end);
+}
+#else
+static inline void early_init_dt_check_for_initrd(u64 node)
+{
+}
+#endif /* CONFIG_BLK_DEV_INITRD */
+
 int __init early_init_dt_scan_chosen(u64 node, const char *uname,
 				     int depth, void *data)
 {
@@ -95,7 +139,7 @@ int __init early_init_dt_scan_chosen(u64 node, const char *uname,
 	    (strcmp(uname, "chosen") != 0 && strcmp(uname, "chosen@0") != 0))
 		return 0;
 
-	//early_init_dt_check_for_initrd(node);
+	early_init_dt_check_for_initrd(node);
 
 	/* Retrieve command line */
 	p = of_get_flat_dt_prop(node, "bootargs", &l);
@@ -126,15 +170,6 @@ int __init early_init_dt_scan_chosen(u64 node, const char *uname,
 	return 1;
 }
 
-/* Helper to read a big number; size is in cells (not bytes) */
-static inline u64 of_read_number(const __be32 *cell, int size)
-{
-	u64 r = 0;
-	while (size--)
-		r = (r << 32) | be32_to_cpu(*(cell++));
-	return r;
-}
-
 u64 __init dt_mem_next_cell(int s, const __be32 **cellp)
 {
 	const __be32 *p = *cellp;
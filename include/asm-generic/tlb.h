@@ -0,0 +1,247 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * include/asm-generic/tlb.h
+ *
+ *	Generic TLB shootdown code
+ *
+ * Copyright 2001 Red Hat, Inc.
+ * Based on code from mm/memory.c Copyright Linus Torvalds and others.
+ *
+ * Copyright 2011 Red Hat, Inc., Peter Zijlstra
+ */
+#ifndef __ASM_GENERIC_TLB_H_
+#define __ASM_GENERIC_TLB_H_
+
+#include <linux/mm_types.h>
+
+#include <asm/pgalloc.h>
+#include <asm/tlbflush.h>
+
+/*
+ * Generic MMU-gather implementation.
+ *
+ * The mmu_gather data structure is used by the mm code to implement the
+ * correct and efficient ordering of freeing pages and TLB invalidations.
+ *
+ * This correct ordering is:
+ *
+ *  1) unhook page
+ *  2) TLB invalidate page
+ *  3) free page
+ *
+ * That is, we must never free a page before we have ensured there are no live
+ * translations left to it. Otherwise it might be possible to observe (or
+ * worse, change) the page content after it has been reused.
+ *
+ * The mmu_gather API consists of:
+ *
+ *  - tlb_gather_mmu() / tlb_finish_mmu(); start and finish a mmu_gather
+ *
+ *    Finish in particular will issue a (final) TLB invalidate and free
+ *    all (remaining) queued pages.
+ *
+ *  - tlb_flush_pte_range() / tlb_flush_pmd_range() / tlb_flush_pud_range()
+ *
+ *    Record that entries at the given level have been cleared for a range;
+ *    the union of all ranges is what gets invalidated, with a stride that
+ *    matches the smallest level that was cleared.
+ *
+ *  - tlb_remove_page() / tlb_remove_table()
+ *
+ *    Queue a data page or a page-table page for freeing once the TLB has
+ *    been invalidated. Removing a table additionally forces the walk caches
+ *    to be invalidated.
+ *
+ *  - tlb_flush_mmu() / tlb_flush_mmu_tlbonly()
+ *
+ *    tlb_flush_mmu_tlbonly() will only do the TLBI invalidate and reset the
+ *    gathered range; tlb_flush_mmu() additionally frees the queued pages.
+ *    Both are called implicitly when the page batches fill up.
+ *
+ * The architecture provides tlb_flush(), which turns the gathered state into
+ * the cheapest sufficient invalidation: a by-VA range, the whole ASID, or a
+ * full flush.
+ */
+
+/*
+ * If we can't allocate a page to make a big batch of page pointers
+ * to work on, then just handle a few from the on-stack structure.
+ */
+#define MMU_GATHER_BUNDLE	8
+
+struct mmu_gather_batch {
+	struct mmu_gather_batch	*next;
+	unsigned int		nr;
+	unsigned int		max;
+	struct page		*pages[0];
+};
+
+#define MAX_GATHER_BATCH	\
+	((PAGE_SIZE - sizeof(struct mmu_gather_batch)) / sizeof(void *))
+
+/*
+ * Limit the maximum number of mmu_gather batches to reduce a risk of soft
+ * lockups for non-preemptible kernels on huge machines when a lot of memory
+ * is zapped during unmapping.
+ * 10K pages freed at once should be safe even without a preemption point.
+ */
+#define MAX_GATHER_BATCH_COUNT	(10000UL / MAX_GATHER_BATCH)
+
+/*
+ * struct mmu_gather is an opaque type used by the mm code for passing around
+ * any data needed by arch specific code for tlb_remove_page.
+ */
+struct mmu_gather {
+	struct mm_struct	*mm;
+	u64			start;
+	u64			end;
+	/*
+	 * we are in the middle of an operation to clear
+	 * a full mm and can make some optimizations
+	 */
+	unsigned int		fullmm : 1;
+
+	/*
+	 * we have performed an operation which
+	 * requires a complete flush of the tlb
+	 */
+	unsigned int		need_flush_all : 1;
+
+	/*
+	 * we have removed page directories
+	 */
+	unsigned int		freed_tables : 1;
+
+	/*
+	 * at which levels have we cleared entries?
+	 */
+	unsigned int		cleared_ptes : 1;
+	unsigned int		cleared_pmds : 1;
+	unsigned int		cleared_puds : 1;
+
+	unsigned int		batch_count;
+
+	struct mmu_gather_batch	*active;
+	struct mmu_gather_batch	local;
+	struct page		*__pages[MMU_GATHER_BUNDLE];
+};
+
+extern void tlb_gather_mmu(struct mmu_gather *tlb, struct mm_struct *mm,
+			   u64 start, u64 end);
+extern void tlb_finish_mmu(struct mmu_gather *tlb);
+extern void tlb_flush_mmu(struct mmu_gather *tlb);
+extern bool __tlb_remove_page(struct mmu_gather *tlb, struct page *page);
+
+static inline void __tlb_adjust_range(struct mmu_gather *tlb,
+				      u64 address, u64 range_size)
+{
+	tlb->start = min(tlb->start, address);
+	tlb->end = max(tlb->end, address + range_size);
+}
+
+static inline void __tlb_reset_range(struct mmu_gather *tlb)
+{
+	if (tlb->fullmm) {
+		tlb->start = tlb->end = ~0ULL;
+	} else {
+		tlb->start = ~0ULL;
+		tlb->end = 0;
+	}
+	tlb->freed_tables = 0;
+	tlb->cleared_ptes = 0;
+	tlb->cleared_pmds = 0;
+	tlb->cleared_puds = 0;
+}
+
+static inline void tlb_flush_mmu_tlbonly(struct mmu_gather *tlb)
+{
+	/*
+	 * Anything calling __tlb_adjust_range() also sets at least one of
+	 * these bits.
+	 */
+	if (!(tlb->freed_tables || tlb->cleared_ptes || tlb->cleared_pmds ||
+	      tlb->cleared_puds || tlb->need_flush_all))
+		return;
+
+	tlb_flush(tlb);
+	__tlb_reset_range(tlb);
+}
+
+static inline void tlb_remove_page(struct mmu_gather *tlb, struct page *page)
+{
+	if (__tlb_remove_page(tlb, page))
+		tlb_flush_mmu(tlb);
+}
+
+/*
+ * Page-table pages are only returned once the walk caches that may still
+ * reference them have been invalidated, so removing one forces a
+ * non-leaf invalidation of the gathered range.
+ */
+static inline void tlb_remove_table(struct mmu_gather *tlb, struct page *page)
+{
+	tlb->freed_tables = 1;
+	tlb_remove_page(tlb, page);
+}
+
+static inline void tlb_flush_pte_range(struct mmu_gather *tlb,
+				       u64 address, u64 size)
+{
+	__tlb_adjust_range(tlb, address, size);
+	tlb->cleared_ptes = 1;
+}
+
+static inline void tlb_flush_pmd_range(struct mmu_gather *tlb,
+				       u64 address, u64 size)
+{
+	__tlb_adjust_range(tlb, address, size);
+	tlb->cleared_pmds = 1;
+}
+
+static inline void tlb_flush_pud_range(struct mmu_gather *tlb,
+				       u64 address, u64 size)
+{
+	__tlb_adjust_range(tlb, address, size);
+	tlb->cleared_puds = 1;
+}
+
+/*
+ * tlb_get_unmap_{shift,size}() - obtain the smallest level that was
+ * cleared, so the invalidation can step over the range at that granule.
+ */
+static inline u64 tlb_get_unmap_shift(struct mmu_gather *tlb)
+{
+	if (tlb->cleared_ptes)
+		return PAGE_SHIFT;
+	if (tlb->cleared_pmds)
+		return PMD_SHIFT;
+	if (tlb->cleared_puds)
+		return PUD_SHIFT;
+
+	return PAGE_SHIFT;
+}
+
+static inline u64 tlb_get_unmap_size(struct mmu_gather *tlb)
+{
+	return 1ULL << tlb_get_unmap_shift(tlb);
+}
+
+#define pte_free_tlb(tlb, ptep, address)			\
+	do {							\
+		tlb_flush_pmd_range(tlb, address, PAGE_SIZE);	\
+		__pte_free_tlb(tlb, ptep, address);		\
+	} while (0)
+
+#define pmd_free_tlb(tlb, pmdp, address)			\
+	do {							\
+		tlb_flush_pud_range(tlb, address, PAGE_SIZE);	\
+		__pmd_free_tlb(tlb, pmdp, address);		\
+	} while (0)
+
+#define pud_free_tlb(tlb, pudp, address)			\
+	do {							\
+		__tlb_adjust_range(tlb, address, PAGE_SIZE);	\
+		__pud_free_tlb(tlb, pudp, address);		\
+	} while (0)
+
+#endif /* !__ASM_GENERIC_TLB_H_ */
@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Shared-memory ring channels
+ *
+ * A channel moves bulk data between two services without copying it
+ * through IPC messages. The data sits in a single-producer,
+ * single-consumer ring of physical pages mapped into both address spaces.
+ * Each side maps it once, with IPC_SYS_CHANNEL_MAP, and the capability
+ * used decides the role: CAP_RIGHT_SEND maps the producer side and
+ * CAP_RIGHT_RECV the consumer side. Both sides see the same layout from
+ * the address they chose:
+ *
+ *	page 0		producer control, written by the producer
+ *	page 1		consumer control, written by the consumer
+ *	page 2...	data, 2^order pages, written by the producer
+ *
+ * Each side can write only its own control page. Only the producer can
+ * write the data. All of it is normal cacheable memory with execute
+ * permission removed, mapped the same way into both sides.
+ *
+ * The indices are free-running byte counts, so the ring is empty when
+ * they are equal, and byte i lives at data[i & (size - 1)]. Neither side
+ * needs the kernel to move data. A side that runs out of work sets its
+ * waiting flag, checks the other index again, and waits on its doorbell
+ * notification. The other side calls IPC_SYS_CHANNEL_NOTIFY only when it
+ * sees the flag set after publishing its index. The kernel clears the
+ * flag as it rings the doorbell, so a burst of notifies for one wait
+ * costs one signal.
+ */
+#ifndef __LINUX_CHANNEL_H
+#define __LINUX_CHANNEL_H
+
+#include <linux/spinlock_types.h>
+#include <linux/types.h>
+
+#include <asm/page.h>
+
+struct mm_struct;
+struct notification;
+struct page;
+struct pt_regs;
+
+enum channel_side {
+	CHANNEL_PRODUCER,
+	CHANNEL_CONSUMER,
+	CHANNEL_SIDES,
+};
+
+#define CHANNEL_CTRL_PAGES	CHANNEL_SIDES
+#define CHANNEL_MAX_ORDER	(MAX_ORDER - 1)
+
+/* The start of each control page */
+struct channel_ctrl {
+	u32	index;		/* bytes produced or consumed */
+	u32	waiting;	/* set before waiting on the doorbell */
+};
+
+struct channel {
+	struct page		*ctrl_pages;
+	struct page		*data_pages;
+	unsigned int		order;		/* of the data pages */
+	struct channel_ctrl	*ctrl[CHANNEL_SIDES];
+	raw_spinlock_t		lock;		/* protects the fields below */
+	struct mm_struct	*mm[CHANNEL_SIDES];
+	u64			vaddr[CHANNEL_SIDES];
+	struct notification	*doorbell[CHANNEL_SIDES];
+	u64			badge[CHANNEL_SIDES];
+};
+
+static inline u64 channel_data_size(const struct channel *ch)
+{
+	return PAGE_SIZE << ch->order;
+}
+
+static inline u64 channel_map_size(const struct channel *ch)
+{
+	return (CHANNEL_CTRL_PAGES * PAGE_SIZE) + channel_data_size(ch);
+}
+
+void channel_init(void);
+struct channel *channel_create(unsigned int order);
+void channel_destroy(struct channel *ch);
+void channel_set_doorbell(struct channel *ch, enum channel_side side,
+			  struct notification *ntfn, u64 badge);
+int channel_map(struct channel *ch, enum channel_side side,
+		struct mm_struct *mm, u64 addr);
+void channel_unmap(struct channel *ch, enum channel_side side);
+void channel_notify(struct channel *ch, enum channel_side side);
+
+void ipc_channel_map(struct pt_regs *regs);
+void ipc_channel_set_doorbell(struct pt_regs *regs);
+void ipc_channel_notify(struct pt_regs *regs);
+
+#endif /* __LINUX_CHANNEL_H */
@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Capability spaces
+ *
+ * A thread names kernel objects by capability pointers (cptrs): 64-bit
+ * addresses into its capability space. The space is a tree of CNodes,
+ * arrays of 2^radix_bits capability slots. The capability that refers to
+ * a CNode also carries a guard, a bit string of guard_bits bits. Decoding
+ * a cptr walks the tree from the thread's root CNode capability, most
+ * significant bits first. At each level the next guard_bits bits must
+ * equal the guard, and the radix_bits bits after them pick a slot. The
+ * walk stops when the address bits run out or at a slot that does not
+ * hold a CNode capability.
+ *
+ * Guards let a sparse space stay shallow. A root CNode of 2^8 slots with
+ * a 56-bit zero guard decodes cptrs 0-255 in one step.
+ *
+ * Every syscall decodes at least one cptr. To save the walk, each thread
+ * keeps a small cache of the slots it looked up last. Entries point at
+ * slots, not copies of them, so changing what a slot holds needs no
+ * invalidation. Only changes that could make a cptr decode to a different
+ * slot do: writing a CNode capability into a slot or removing one bumps
+ * cspace_generation, and entries from an older generation are ignored.
+ */
+#ifndef __LINUX_CNODE_H
+#define __LINUX_CNODE_H
+
+#include <linux/compiler.h>
+#include <linux/sizes.h>
+#include <linux/types.h>
+
+#include <asm/barrier.h>
+
+struct channel;
+struct endpoint;
+struct notification;
+struct pt_regs;
+
+enum cap_type {
+	CAP_NULL,
+	CAP_ENDPOINT,
+	CAP_CNODE,
+	CAP_NOTIFICATION,
+	CAP_IRQ_HANDLER,
+	CAP_CHANNEL,
+};
+
+#define CAP_RIGHT_SEND		0x1
+#define CAP_RIGHT_RECV		0x2
+#define CAP_RIGHT_GRANT		0x4
+#define CAP_RIGHTS_ALL		(CAP_RIGHT_SEND | CAP_RIGHT_RECV | \
+				 CAP_RIGHT_GRANT)
+
+#define CNODE_MIN_RADIX_BITS	1
+#define CNODE_MAX_RADIX_BITS	8
+
+/*
+ * A capability slot. Updates are made under cspace_lock with seq odd;
+ * lockless readers copy the slot with cap_load(), never field by field,
+ * so that they cannot pair one capability's rights with another's object.
+ */
+struct cap {
+	u8		type;		/* enum cap_type */
+	u8		rights;		/* CAP_RIGHT_* */
+	u8		radix_bits;	/* CAP_CNODE */
+	u8		guard_bits;	/* CAP_CNODE */
+	u32		seq;		/* odd while the slot is rewritten */
+	void		*obj;
+	u64		data;		/* badge, guard of a CNode, or irq */
+};
+
+struct cnode {
+	unsigned int	radix_bits;
+	struct cap	slots[];
+};
+
+#define CAP_CACHE_SIZE		4
+
+struct cap_cache_entry {
+	u64		cptr;
+	struct cap	*slot;
+	u64		gen;
+};
+
+/* Bytes of kernel memory a thread may turn into objects, see ipc_cap_create() */
+#define CSPACE_QUOTA		SZ_1M
+
+struct cspace {
+	struct cap		root;
+	struct cap_cache_entry	cache[CAP_CACHE_SIZE];
+	unsigned long		quota;
+};
+
+extern u64 cspace_generation;
+
+void cnode_init(void);
+struct cnode *cnode_create(unsigned int radix_bits);
+void cnode_destroy(struct cnode *cnode);
+
+void cap_cnode_init(struct cap *cap, struct cnode *cnode,
+		    unsigned int guard_bits, u64 guard);
+void cap_endpoint_init(struct cap *cap, struct endpoint *ep,
+		       unsigned int rights, u64 badge);
+void cap_notification_init(struct cap *cap, struct notification *ntfn,
+			   unsigned int rights, u64 badge);
+void cap_irq_handler_init(struct cap *cap, unsigned int irq);
+void cap_channel_init(struct cap *cap, struct channel *ch,
+		      unsigned int rights);
+
+void cspace_init(struct cspace *cs);
+void cspace_set_root(struct cspace *cs, const struct cap *root);
+struct cap *__cspace_lookup(struct cspace *cs, u64 cptr);
+int cspace_insert(struct cspace *cs, u64 cptr, unsigned int depth,
+		  const struct cap *cap);
+int cspace_mint(struct cspace *dst, u64 dst_cptr, unsigned int dst_depth,
+		struct cspace *src, u64 src_cptr, unsigned int rights,
+		u64 badge);
+int cspace_delete(struct cspace *cs, u64 cptr, unsigned int depth);
+
+void ipc_cap_create(struct pt_regs *regs);
+void ipc_cap_mint(struct pt_regs *regs);
+void ipc_cap_delete(struct pt_regs *regs);
+
+/**
+ * cap_load - take a consistent copy of a capability slot
+ * @slot: the slot, which may be rewritten concurrently
+ * @cap: where to copy it
+ *
+ * Retries for as long as an update overlaps the copy.
+ */
+static __always_inline void cap_load(const struct cap *slot, struct cap *cap)
+{
+	u32 seq;
+
+	for (;;) {
+		seq = smp_load_acquire(&slot->seq);
+		if (likely(!(seq & 1))) {
+			*cap = *slot;
+			smp_rmb();
+			if (likely(READ_ONCE(slot->seq) == seq))
+				return;
+		}
+	}
+}
+
+/**
+ * cspace_lookup - find the slot a capability pointer names
+ * @cs: the capability space, normally &current->cspace
+ * @cptr: capability pointer, decoded to its full 64 bits
+ *
+ * Return: the slot, which may be empty, or NULL if @cptr does not decode.
+ */
+static __always_inline struct cap *cspace_lookup(struct cspace *cs, u64 cptr)
+{
+	struct cap_cache_entry *ce = &cs->cache[cptr & (CAP_CACHE_SIZE - 1)];
+
+	if (likely(ce->cptr == cptr && ce->slot &&
+		   ce->gen == READ_ONCE(cspace_generation)))
+		return ce->slot;
+
+	return __cspace_lookup(cs, cptr);
+}
+
+#endif /* __LINUX_CNODE_H */
@@ -6,6 +6,8 @@ enum cpuhp_state {
 	CPUHP_OFFLINE = 0,
 };
 
+void cpu_startup_entry(void);
+
 int __cpu_setup_state(enum cpuhp_state state, const char *name, bool invoke,
 			int (*startup)(unsigned int cpu),
 			int (*teardown)(unsigned int cpu), bool multi_instance);
@@ -143,6 +143,11 @@ static inline int cpumask_test_and_set(int cpu, cpumask_t *dstp)
 	return test_and_set_bit(cpu, cpumask_bits(dstp));
 }
 
+static inline int cpumask_test_and_clear(int cpu, cpumask_t *dstp)
+{
+	return test_and_clear_bit(cpu, cpumask_bits(dstp));
+}
+
 static inline int cpumask_empty(const cpumask_t *srcp)
 {
 	return bitmap_empty(cpumask_bits(srcp), nr_cpumask_bits);
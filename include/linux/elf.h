@@ -29,4 +29,9 @@ extern Elf64_Dyn _DYNAMIC [];
 
 #endif
 
+struct mm_struct;
+
+int elf_map_image(struct mm_struct *mm, const void *image, u64 size,
+		  u64 *entry);
+
 #endif /* !__LINUX_ELF_H_ */
@@ -15,8 +15,9 @@
 
 #define ___GFP_ZERO				BIT(3)
 #define ___GFP_NOWARN			BIT(4)
+#define ___GFP_ATOMIC			BIT(5)
 
-#define ___GFP_BITS_SHIFT		5
+#define ___GFP_BITS_SHIFT		6
 
 /* If the above are modified, __GFP_BITS_SHIFT may need updating */
 
@@ -36,12 +37,14 @@
 
 #define __GFP_ZERO	((__force gfp_t)___GFP_ZERO)	/* Return zeroed page on success */
 #define __GFP_NOWARN	((__force gfp_t)___GFP_NOWARN)
+#define __GFP_ATOMIC	((__force gfp_t)___GFP_ATOMIC)	/* Caller cannot sleep */
 
 #define __GFP_BITS_SHIFT ___GFP_BITS_SHIFT
 #define __GFP_BITS_MASK ((__force gfp_t)((1 << __GFP_BITS_SHIFT) - 1))
 
 #define GFP_DMA		(__GFP_DMA)
 #define GFP_KERNEL	(__GFP_NORMAL)
+#define GFP_ATOMIC	(__GFP_ATOMIC)
 #define GFP_MOVABLE		(__GFP_MOVABLE)
 
 #define GFP_USER	(GFP_KERNEL)
@@ -73,6 +76,7 @@ extern u64 get_zeroed_page(gfp_t gfp_mask);
 
 extern void __free_pages(struct page *page, unsigned int order);
 extern void free_pages(u64 addr, unsigned int order);
+extern void release_pages(struct page **pages, int nr);
 extern void free_unref_page(struct page *page);
 extern void page_frag_free(void *addr);
 
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __LINUX_INITRD_H
+#define __LINUX_INITRD_H
+
+#include <linux/init.h>
+#include <linux/types.h>
+
+/* Set by the device tree, see early_init_dt_check_for_initrd() */
+extern phys_addr_t phys_initrd_start;
+extern u64 phys_initrd_size;
+
+/* Linear map addresses of the initrd, set once it is reserved */
+extern u64 initrd_start, initrd_end;
+
+/* Capabilities a boot service starts with, as cptrs into its cspace */
+#define BOOT_CAP_NULL		0	/* always empty */
+#define BOOT_CAP_CNODE		1	/* its root CNode */
+#define BOOT_CAP_ENDPOINT	2	/* the endpoint shared by all services */
+
+#ifdef CONFIG_BLK_DEV_INITRD
+void __init load_boot_services(void);
+void __init boot_services_work(void);
+#else
+static inline void load_boot_services(void)
+{
+}
+static inline void boot_services_work(void)
+{
+}
+#endif
+
+#endif /* __LINUX_INITRD_H */
@@ -0,0 +1,249 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Synchronous IPC through endpoints
+ *
+ * An endpoint holds no messages, only the threads blocked on it: either
+ * senders waiting for a receiver or receivers waiting for a sender, never
+ * both. A message is a message info word and up to IPC_MSG_MAX_LENGTH
+ * words. The first IPC_MSG_REGS words travel in registers; the rest are
+ * copied from the sender's IPC buffer into the receiver's.
+ *
+ * A call is a send that also hands the receiver the right to reply once.
+ * The caller stays blocked until the reply. Servers answer and wait for
+ * the next request in one step with reply_recv. Call and reply_recv
+ * messages that fit in registers, going to a thread that is already
+ * waiting, take the fast path in kernel/ipc/fastpath.c. It copies the
+ * registers and switches straight to the other thread.
+ *
+ * A server runs on behalf of its callers: until it replies it runs at
+ * the caller's priority if that is better than its own, and at that of
+ * the most important sender queued on the endpoint it serves. Senders
+ * queue in priority order. See kernel/ipc/prio.c.
+ *
+ * Syscall ABI (svc #0):
+ *	x8	IPC_SYS_*
+ *	x0	in: capability pointer; out: badge of the sender
+ *	x1	message info, see ipc_msginfo()
+ *	x2-x5	message registers 0-3
+ */
+#ifndef __LINUX_IPC_H
+#define __LINUX_IPC_H
+
+#include <linux/list.h>
+#include <linux/spinlock_types.h>
+#include <linux/types.h>
+
+struct pt_regs;
+struct task_struct;
+
+#define IPC_SYS_CALL		1
+#define IPC_SYS_REPLY_RECV	2
+#define IPC_SYS_SEND		3
+#define IPC_SYS_NBSEND		4
+#define IPC_SYS_RECV		5
+#define IPC_SYS_REPLY		6
+#define IPC_SYS_SIGNAL		7
+#define IPC_SYS_WAIT		8
+#define IPC_SYS_POLL		9
+#define IPC_SYS_IRQ_SET_NTFN	10	/* x0 irq handler, x2 notification */
+#define IPC_SYS_IRQ_ACK		11
+#define IPC_SYS_CHANNEL_MAP	12	/* x0 channel, x2 address */
+#define IPC_SYS_CHANNEL_DOORBELL 13	/* x0 channel, x2 notification */
+#define IPC_SYS_CHANNEL_NOTIFY	14
+#define IPC_SYS_CAP_CREATE	15	/* x0 slot, x2 type, x3-x4 arguments */
+#define IPC_SYS_CAP_MINT	16	/* x0 source, x2 slot, x3 rights, x4 badge */
+#define IPC_SYS_CAP_DELETE	17	/* x0 slot */
+#define IPC_SYS_SET_PAGER	18	/* x0 endpoint, or none to clear */
+#define IPC_SYS_EXIT		19	/* x0 status; ends the calling thread */
+
+/* Where the syscall arguments live in pt_regs::regs[] */
+#define IPC_REG_CPTR		0
+#define IPC_REG_BADGE		0
+#define IPC_REG_INFO		1
+#define IPC_REG_MR0		2
+#define IPC_REG_SYSNO		8
+
+#define IPC_MSG_REGS		4
+#define IPC_MSG_MAX_LENGTH	120
+#define IPC_MSG_MAX_EXTRA_CAPS	3
+
+/*
+ * Message info word:
+ *	[6:0]	length in words
+ *	[8:7]	number of extra capabilities
+ *	[11:9]	capabilities unwrapped into badges
+ *	[63:12]	label, not interpreted by the kernel
+ */
+#define IPC_MSGINFO_LENGTH_MASK		0x7f
+#define IPC_MSGINFO_EXTRA_CAPS_SHIFT	7
+#define IPC_MSGINFO_EXTRA_CAPS_MASK	0x3
+#define IPC_MSGINFO_UNWRAPPED_SHIFT	9
+#define IPC_MSGINFO_UNWRAPPED_MASK	0x7
+#define IPC_MSGINFO_LABEL_SHIFT		12
+
+static inline u64 ipc_msginfo(u64 label, unsigned int unwrapped,
+			      unsigned int extra_caps, unsigned int length)
+{
+	return (label << IPC_MSGINFO_LABEL_SHIFT) |
+	       ((u64)(unwrapped & IPC_MSGINFO_UNWRAPPED_MASK) <<
+		IPC_MSGINFO_UNWRAPPED_SHIFT) |
+	       ((u64)(extra_caps & IPC_MSGINFO_EXTRA_CAPS_MASK) <<
+		IPC_MSGINFO_EXTRA_CAPS_SHIFT) |
+	       (length & IPC_MSGINFO_LENGTH_MASK);
+}
+
+static inline unsigned int ipc_msginfo_length(u64 info)
+{
+	return info & IPC_MSGINFO_LENGTH_MASK;
+}
+
+static inline unsigned int ipc_msginfo_extra_caps(u64 info)
+{
+	return (info >> IPC_MSGINFO_EXTRA_CAPS_SHIFT) &
+	       IPC_MSGINFO_EXTRA_CAPS_MASK;
+}
+
+static inline u64 ipc_msginfo_label(u64 info)
+{
+	return info >> IPC_MSGINFO_LABEL_SHIFT;
+}
+
+/*
+ * One per thread, mapped both into its address space and into the
+ * kernel. msg[0..IPC_MSG_REGS) is unused: those words are in registers.
+ *
+ * A sender holding the endpoint with CAP_RIGHT_GRANT passes a capability
+ * by naming it in caps_or_badges[0] and setting one extra cap in the
+ * message info. It is copied into the receiver's slot receive_index,
+ * decoded at receive_depth; receive_cnode is not used yet.
+ */
+struct ipc_buffer {
+	u64	tag;
+	u64	msg[IPC_MSG_MAX_LENGTH];
+	u64	user_data;
+	u64	caps_or_badges[IPC_MSG_MAX_EXTRA_CAPS];
+	u64	receive_cnode;
+	u64	receive_index;
+	u64	receive_depth;
+};
+
+/*
+ * Page faults. A thread that faults in user space sends a fault message
+ * to its pager, as a call made on its behalf:
+ *	label	IPC_LABEL_VM_FAULT
+ *	MR0	faulting address
+ *	MR1	pc
+ *	MR2	ESR_EL1: read, write or instruction fetch, and the fault type
+ *	MR3	which of the IPC_FAULT_AROUND_PAGES pages in the aligned
+ *		window around the address are not mapped, one bit per page
+ *
+ * The thread's registers are left alone. The pager's reply is a list of
+ * map items, IPC_MAP_ITEM_WORDS words each, naming pages of the pager's
+ * own address space to map into the thread's:
+ *	word 0	source address | IPC_MAP_* flags
+ *	word 1	destination address | (number of pages - 1)
+ *
+ * Mapping a run of pages, or the unmapped neighbours MR3 reports, in one
+ * reply saves a round trip per page for the faults the thread would
+ * otherwise take next. Destination pages that are already mapped are
+ * left as they are. A reply with a label of 0 resumes the thread at the
+ * faulting instruction; any other label stops it.
+ */
+#define IPC_LABEL_VM_FAULT	(~0ULL >> IPC_MSGINFO_LABEL_SHIFT)
+#define IPC_FAULT_MSG_LENGTH	4
+#define IPC_FAULT_AROUND_PAGES	64
+
+#define IPC_MAP_ITEM_WORDS	2
+#define IPC_MAP_WRITE		0x1	/* only if the source is writable */
+#define IPC_MAP_EXEC		0x2	/* only if the source is executable */
+
+enum endpoint_state {
+	EP_IDLE,
+	EP_SEND,		/* queue holds senders */
+	EP_RECV,		/* queue holds receivers */
+};
+
+struct endpoint {
+	raw_spinlock_t		lock;
+	unsigned int		state;
+	struct list_head	queue;
+	struct list_head	servers;	/* threads serving it */
+};
+
+enum ipc_thread_state {
+	IPC_RUNNING,
+	IPC_BLOCKED_ON_SEND,
+	IPC_BLOCKED_ON_RECV,
+	IPC_BLOCKED_ON_REPLY,
+	IPC_BLOCKED_ON_NOTIFICATION,
+};
+
+struct ipc_fault {
+	u64			addr;
+	u64			pc;
+	u64			esr;
+	u64			unmapped;	/* fault-around window */
+	bool			pending;	/* waiting for the pager */
+};
+
+struct ipc_thread {
+	unsigned int		state;
+	bool			do_call;	/* blocked send is a call */
+	struct endpoint		*ep;		/* blocked on this endpoint */
+	struct list_head	ep_link;	/* in ep->queue or ntfn->waiters */
+	u64			badge;		/* of the cap a blocked send used */
+	struct task_struct	*caller;	/* blocked on our reply */
+	struct task_struct	*server;	/* holds our reply right */
+	struct endpoint		*serving;	/* last received from */
+	struct list_head	serve_link;	/* in serving->servers */
+	struct ipc_buffer	*buffer;	/* kernel alias of the IPC buffer */
+	u64			buffer_uaddr;
+	struct endpoint		*pager;		/* gets our page faults */
+	u64			pager_badge;
+	struct ipc_fault	fault;
+};
+
+void ipc_init(void);
+struct endpoint *endpoint_create(void);
+void endpoint_destroy(struct endpoint *ep);
+struct endpoint *ipc_lookup_endpoint(u64 cptr, unsigned int rights,
+				     u64 *badge);
+void ipc_thread_init(struct task_struct *tsk);
+void ipc_thread_exit(void);
+void ipc_set_buffer(struct task_struct *tsk, struct ipc_buffer *buffer,
+		    u64 uaddr);
+
+void ipc_set_pager(struct pt_regs *regs);
+void ipc_thread_set_pager(struct task_struct *tsk, struct endpoint *pager,
+			  u64 badge);
+void ipc_fault(struct pt_regs *regs, u64 addr, unsigned int esr);
+void ipc_fault_message(struct task_struct *src, struct task_struct *dst,
+		       u64 badge);
+void ipc_fault_reply(struct task_struct *pager, struct task_struct *tsk,
+		     u64 info);
+
+void __ipc_send(struct endpoint *ep, u64 badge, u64 info, bool call,
+		bool blocking);
+void ipc_send(struct pt_regs *regs, bool call, bool blocking);
+void ipc_recv(struct pt_regs *regs);
+void ipc_reply(struct pt_regs *regs);
+void ipc_reply_recv(struct pt_regs *regs);
+
+void ipc_serve(struct task_struct *tsk, struct endpoint *ep);
+void ipc_unserve(struct task_struct *tsk);
+void ipc_enqueue_sender(struct endpoint *ep, struct task_struct *tsk);
+void ipc_prio_update(struct task_struct *tsk);
+void ipc_prio_update_servers(struct endpoint *ep);
+void ipc_prio_inherit(struct task_struct *tsk);
+void ipc_thread_set_prio(struct task_struct *tsk, unsigned int prio);
+
+#ifdef CONFIG_IPC_PRIO_TEST
+void ipc_prio_test(void);
+#else
+static inline void ipc_prio_test(void) { }
+#endif
+
+void ipc_fastpath_call(struct pt_regs *regs);
+void ipc_fastpath_reply_recv(struct pt_regs *regs);
+
+#endif /* __LINUX_IPC_H */
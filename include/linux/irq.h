@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_IRQ_H
+#define _LINUX_IRQ_H
+
+/*
+ * Interrupts are not handled in the kernel. Each one can be bound to a
+ * notification, which is signalled when it fires. The interrupt is then
+ * masked until the user-space handler acknowledges it with irq_ack(), so
+ * a level-triggered line does not fire again while it is still being
+ * serviced.
+ */
+
+#include <linux/types.h>
+
+#include <asm/irq.h>
+
+struct notification;
+
+/**
+ * struct irq_chip - hardware interrupt chip descriptor
+ * @name:	name for diagnostics
+ * @irq_mask:	stop an interrupt from being signalled
+ * @irq_unmask:	let it be signalled again
+ */
+struct irq_chip {
+	const char	*name;
+	void		(*irq_mask)(unsigned int irq);
+	void		(*irq_unmask)(unsigned int irq);
+};
+
+void irq_set_chip(struct irq_chip *chip);
+int generic_handle_irq(unsigned int irq);
+
+int irq_bind_notification(unsigned int irq, struct notification *ntfn,
+			  u64 badge);
+int irq_unbind_notification(unsigned int irq);
+int irq_ack(unsigned int irq);
+
+#endif /* _LINUX_IRQ_H */
@@ -392,6 +392,43 @@ extern u64 memparse(const char *ptr, char **retptr);
 extern bool parse_option_str(const char *str, const char *option);
 extern char *next_arg(char *args, char **param, char **val);
 
+#ifdef CONFIG_TRACE_PRINTK
+/**
+ * trace_printk - printf formatting in the trace_printk() buffers
+ * @fmt: the printf format, which must be a string literal
+ *
+ * Only the format pointer and the binary arguments are recorded; the text
+ * is produced when the buffer is read or dumped. %s arguments are copied,
+ * every other argument is stored by value, so pointers passed to %p style
+ * specifiers must still be valid when the buffer is formatted.
+ */
+#define trace_printk(fmt, ...)					\
+	__trace_bprintk(_THIS_IP_, fmt, ##__VA_ARGS__)
+
+extern __printf(2, 3)
+int __trace_bprintk(u64 ip, const char *fmt, ...);
+extern __printf(2, 0)
+int __trace_vbprintk(u64 ip, const char *fmt, va_list args);
+extern int trace_printk_read(char *buf, size_t size);
+extern void trace_printk_dump(void);
+extern void trace_printk_init(void);
+#else
+#define trace_printk(fmt, ...)	no_printk(fmt, ##__VA_ARGS__)
+
+static inline int trace_printk_read(char *buf, size_t size)
+{
+	return 0;
+}
+
+static inline void trace_printk_dump(void)
+{
+}
+
+static inline void trace_printk_init(void)
+{
+}
+#endif /* CONFIG_TRACE_PRINTK */
+
 extern int core_kernel_text(u64 addr);
 extern int init_kernel_text(u64 addr);
 extern int core_kernel_data(u64 addr);
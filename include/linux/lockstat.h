@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Lock contention statistics
+ *
+ * With CONFIG_LOCK_STAT every raw spinlock and rwlock carries a
+ * lockstat_map naming its class: the static lock_class_key of the
+ * spin_lock_init() call site, or the lock itself for DEFINE_SPINLOCK().
+ * The acquire paths try the lock once before queueing on it; when that
+ * fails the acquisition is counted as contended, the wait is timed, and
+ * both the call site that waited and the last one to take the lock are
+ * charged to the class. Counters are kept per cpu and only summed by
+ * lockstat_dump() and lockstat_snapshot().
+ *
+ * Without CONFIG_LOCK_STAT the map is not there and LOCK_CONTENDED() is
+ * the plain lock call.
+ */
+#ifndef __LINUX_LOCKSTAT_H
+#define __LINUX_LOCKSTAT_H
+
+#include <linux/types.h>
+
+/* Call sites remembered per class, on each side of a contention */
+#define LOCKSTAT_POINTS		4
+
+/* Bucket n counts waits of [2^(n-1), 2^n) cycles, the last one the rest */
+#define LOCKSTAT_HIST_BUCKETS	20
+
+/*
+ * Only the address matters: it is what locks initialised from the same
+ * call site have in common.
+ */
+struct lock_class_key {
+	char __one_byte;
+};
+
+struct lock_class_stats {
+	u64 acquisitions;
+	u64 contentions;
+	u64 wait_total;			/* in get_cycles() units */
+	u64 wait_max;
+	u64 wait_hist[LOCKSTAT_HIST_BUCKETS];
+	u64 contention_point[LOCKSTAT_POINTS];	/* waited from here */
+	u64 contending_point[LOCKSTAT_POINTS];	/* while held from here */
+};
+
+#ifdef CONFIG_LOCK_STAT
+
+struct lock_class;
+
+struct lockstat_map {
+	const void		*key;
+	const char		*name;
+	struct lock_class	*class;		/* looked up on first use */
+	u64			holder_ip;	/* last acquirer */
+};
+
+#define STATIC_LOCKSTAT_MAP_INIT(_name, _key) \
+	{ .name = (_name), .key = (void *)(_key), }
+
+void lockstat_init_map(struct lockstat_map *map, const char *name,
+		       struct lock_class_key *key);
+u64 lock_contended(struct lockstat_map *map, u64 ip);
+void lock_acquired(struct lockstat_map *map, u64 ip, u64 waitstart);
+
+void lockstat_dump(void);
+void lockstat_clear(void);
+int lockstat_snapshot(const char *name, struct lock_class_stats *stats);
+
+/*
+ * Acquire @_lock with @lock, but first see whether @try gets it without
+ * waiting. _RET_IP_ is the caller of the out of line _raw_*_lock().
+ */
+#define LOCK_CONTENDED(_lock, try, lock)				\
+do {									\
+	u64 __waitstart = 0;						\
+									\
+	if (!try(_lock)) {						\
+		__waitstart = lock_contended(&(_lock)->stat_map, _RET_IP_); \
+		lock(_lock);						\
+	}								\
+	lock_acquired(&(_lock)->stat_map, _RET_IP_, __waitstart);	\
+} while (0)
+
+#define LOCK_CONTENDED_FLAGS(_lock, try, lock, lockfl, flags)		\
+do {									\
+	u64 __waitstart = 0;						\
+									\
+	if (!try(_lock)) {						\
+		__waitstart = lock_contended(&(_lock)->stat_map, _RET_IP_); \
+		lockfl((_lock), (flags));				\
+	}								\
+	lock_acquired(&(_lock)->stat_map, _RET_IP_, __waitstart);	\
+} while (0)
+
+#define LOCK_ACQUIRED(_lock)						\
+	lock_acquired(&(_lock)->stat_map, _RET_IP_, 0)
+
+#else /* !CONFIG_LOCK_STAT */
+
+#define LOCK_CONTENDED(_lock, try, lock)	lock(_lock)
+#define LOCK_CONTENDED_FLAGS(_lock, try, lock, lockfl, flags) \
+	lockfl((_lock), (flags))
+#define LOCK_ACQUIRED(_lock)			do { } while (0)
+
+static inline void lockstat_dump(void) { }
+static inline void lockstat_clear(void) { }
+
+#endif /* CONFIG_LOCK_STAT */
+
+#endif /* __LINUX_LOCKSTAT_H */
@@ -348,6 +348,7 @@ void memblock_set_current_limit(phys_addr_t limit);
 phys_addr_t memblock_get_current_limit(void);
 void __memblock_dump_all(void);
 void memblock_allow_resize(void);
+void memblock_free_all(void);
 
 /* We are using top down, so it is safe to use 0 here */
 #define MEMBLOCK_LOW_LIMIT 0
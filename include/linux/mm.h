@@ -53,6 +53,18 @@
 
 #define offset_in_page(p)	((u64)(p) & ~PAGE_MASK)
 
+struct mm_struct;
+
+extern void mem_init(void);
+int vmemmap_populate(u64 start, u64 end);
+
+pte_t *user_pte_lookup(struct mm_struct *mm, u64 addr);
+int map_user_pfn_range(struct mm_struct *mm, u64 addr, u64 pfn, u64 size,
+		       pgprot_t prot);
+void unmap_user_range(struct mm_struct *mm, u64 addr, u64 size);
+void free_user_pgtables(struct mm_struct *mm, bool free_mapped);
+int do_wp_page(struct mm_struct *mm, u64 addr);
+
 void kvfree(const void *addr);
 void *kvmalloc(size_t size, gfp_t flags);
 
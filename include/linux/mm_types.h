@@ -6,6 +6,7 @@
 #include <linux/rbtree.h>
 #include <linux/atomic.h>
 #include <linux/list.h>
+#include <linux/spinlock_types.h>
 
 #include <asm/page.h>
 #include <asm/mmu.h>
@@ -86,6 +87,9 @@ struct mm_struct {
 
 		pgd_t * pgd;
 
+		/* Serialises filling in page table entries */
+		spinlock_t page_table_lock;
+
 		/* Architecture-specific MM context */
 		mm_context_t context;
 
@@ -0,0 +1,44 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Notification objects
+ *
+ * A notification is a word of pending bits. Signalling ORs the badge of
+ * the capability used into the word. Waiting returns the accumulated
+ * bits and clears them, blocking while there are none. Signals that
+ * arrive before the waiter gets to them are merged into one word. A
+ * driver woken once for an interrupt and three completions sees all four
+ * bits at once, instead of taking four IPCs.
+ *
+ * Interrupts are delivered this way too, see irq_bind_notification().
+ */
+#ifndef __LINUX_NOTIFICATION_H
+#define __LINUX_NOTIFICATION_H
+
+#include <linux/atomic.h>
+#include <linux/list.h>
+#include <linux/spinlock_types.h>
+#include <linux/types.h>
+
+struct pt_regs;
+
+struct notification {
+	atomic64_t		word;		/* pending bits */
+	raw_spinlock_t		lock;		/* protects waiters */
+	struct list_head	waiters;
+};
+
+void notification_init(void);
+struct notification *notification_create(void);
+void notification_destroy(struct notification *ntfn);
+void notification_signal(struct notification *ntfn, u64 badge);
+u64 notification_poll(struct notification *ntfn);
+
+struct notification *ipc_lookup_notification(u64 cptr, unsigned int rights,
+					     u64 *badge);
+void ipc_signal(struct pt_regs *regs);
+void ipc_wait(struct pt_regs *regs);
+void ipc_poll(struct pt_regs *regs);
+void ipc_irq_set_notification(struct pt_regs *regs);
+void ipc_irq_ack(struct pt_regs *regs);
+
+#endif /* __LINUX_NOTIFICATION_H */
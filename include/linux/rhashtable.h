@@ -0,0 +1,681 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Resizable, Scalable, Concurrent Hash Table
+ *
+ * Copyright (c) 2015-2016 Herbert Xu <herbert@gondor.apana.org.au>
+ * Copyright (c) 2014-2015 Thomas Graf <tgraf@suug.ch>
+ * Copyright (c) 2008-2014 Patrick McHardy <kaber@trash.net>
+ *
+ * Code partially derived from nft_hash
+ * Rewritten with rehash code from br_multicast plus single list
+ * pointer as suggested by Josh Triplett
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _LINUX_RHASHTABLE_H
+#define _LINUX_RHASHTABLE_H
+
+#include <linux/atomic.h>
+#include <linux/bit_spinlock.h>
+#include <linux/compiler.h>
+#include <linux/err.h>
+#include <linux/errno.h>
+#include <linux/jhash.h>
+#include <linux/list.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+/*
+ * Objects are chained through an embedded struct rhash_head. Each bucket
+ * is a single word: the first object of its chain, with bit 0 used as the
+ * bucket's bit spinlock. An empty bucket holds 0.
+ *
+ * The last object of a chain does not point to NULL but to the "nulls"
+ * marker of its bucket, the bucket's address with bit 0 set. An object
+ * that is moved to another table while a lockless reader stands on it
+ * leads that reader into a different chain; the reader notices because
+ * the chain ends in somebody else's marker, and starts over.
+ */
+struct rhash_head {
+	struct rhash_head __rcu		*next;
+};
+
+#define RHT_LOCK_BIT		0
+#define RHT_NULLS_MARKER(bkt)	((struct rhash_head *)(1UL | (u64)(bkt)))
+
+/**
+ * struct bucket_table - Table of hash buckets
+ * @size: Number of hash buckets, a power of two
+ * @hash_rnd: Random seed to fold into hash
+ * @rehash: Number of buckets already moved to @future_tbl
+ * @future_tbl: Table under construction during rehashing
+ * @next_retired: Next table waiting to be freed once rehashed
+ * @buckets: size * hash buckets
+ */
+struct bucket_table {
+	unsigned int		size;
+	u32			hash_rnd;
+	unsigned int		rehash;
+	struct bucket_table __rcu *future_tbl;
+	struct bucket_table	*next_retired;
+
+	u64			buckets[] ____cacheline_aligned_in_smp;
+};
+
+/**
+ * struct rhashtable_compare_arg - Key for the function rhashtable_compare
+ * @ht: Hash table
+ * @key: Key to compare against
+ */
+struct rhashtable_compare_arg {
+	struct rhashtable *ht;
+	const void *key;
+};
+
+typedef u32 (*rht_hashfn_t)(const void *data, u32 len, u32 seed);
+typedef u32 (*rht_obj_hashfn_t)(const void *data, u32 len, u32 seed);
+typedef int (*rht_obj_cmpfn_t)(struct rhashtable_compare_arg *arg,
+			       const void *obj);
+
+/**
+ * struct rhashtable_params - Hash table construction parameters
+ * @nelem_hint: Hint on number of elements, should be 75% of desired size
+ * @key_len: Length of key
+ * @key_offset: Offset of key in struct to be hashed
+ * @head_offset: Offset of rhash_head in struct to be hashed
+ * @max_size: Maximum size while expanding
+ * @min_size: Minimum size while shrinking
+ * @automatic_shrinking: Enable automatic shrinking of tables
+ * @hashfn: Hash function (default: jhash2 if !(key_len % 4), or jhash)
+ * @obj_hashfn: Function to hash object
+ * @obj_cmpfn: Function to compare key with object
+ */
+struct rhashtable_params {
+	u16			nelem_hint;
+	u16			key_len;
+	u16			key_offset;
+	u16			head_offset;
+	unsigned int		max_size;
+	u16			min_size;
+	bool			automatic_shrinking;
+	rht_hashfn_t		hashfn;
+	rht_obj_hashfn_t	obj_hashfn;
+	rht_obj_cmpfn_t		obj_cmpfn;
+};
+
+/**
+ * struct rhashtable - Hash table handle
+ * @tbl: Bucket table
+ * @key_len: Key length for hashfn
+ * @max_elems: Maximum number of elements in table
+ * @p: Configuration parameters
+ * @lock: Serialises attaching a future table and moving buckets into it
+ * @nelems: Number of elements in table
+ * @readers: Per-cpu count of lookups and updates walking the tables
+ * @retired: Tables replaced by their future table, not yet freed
+ */
+struct rhashtable {
+	struct bucket_table __rcu	*tbl;
+	unsigned int			key_len;
+	unsigned int			max_elems;
+	struct rhashtable_params	p;
+	spinlock_t			lock;
+	atomic_t			nelems;
+	int __percpu			*readers;
+	struct bucket_table		*retired;
+};
+
+int rhashtable_init(struct rhashtable *ht,
+		    const struct rhashtable_params *params);
+void rhashtable_free_and_destroy(struct rhashtable *ht,
+				 void (*free_fn)(void *ptr, void *arg),
+				 void *arg);
+void rhashtable_destroy(struct rhashtable *ht);
+
+int rhashtable_insert_rehash(struct rhashtable *ht, struct bucket_table *tbl);
+void rhashtable_resize(struct rhashtable *ht, struct bucket_table *tbl,
+		       bool grow);
+void rhashtable_rehash_step(struct rhashtable *ht);
+void rhashtable_free_retired(struct rhashtable *ht);
+
+#define rht_dereference(p, ht) \
+	rcu_dereference_protected(p, 1)
+
+#define rht_dereference_rcu(p, ht) \
+	rcu_dereference(p)
+
+/*
+ * call_rcu() does not wait for a grace period in this tree, so a table
+ * that has been replaced cannot be freed that way while somebody may
+ * still be walking it. Instead every lookup and update is counted in
+ * ht->readers while it walks the tables, with preemption disabled by
+ * rcu_read_lock(), and replaced tables wait on ht->retired until the
+ * count drops to zero.
+ *
+ * The barriers pair with the one in rhashtable_free_retired(): either the
+ * freer sees the reader's count, or the reader sees the new ht->tbl.
+ */
+static inline void rht_read_enter(struct rhashtable *ht)
+{
+	this_cpu_inc(*ht->readers);
+	smp_mb();
+}
+
+static inline void rht_read_exit(struct rhashtable *ht)
+{
+	smp_mb();
+	this_cpu_dec(*ht->readers);
+}
+
+/* Free the replaced tables if nobody can be walking them any more */
+static inline void rht_free_retired(struct rhashtable *ht)
+{
+	if (unlikely(READ_ONCE(ht->retired)))
+		rhashtable_free_retired(ht);
+}
+
+static inline void *rht_obj(const struct rhashtable *ht,
+			    const struct rhash_head *he)
+{
+	return (char *)he - ht->p.head_offset;
+}
+
+static inline bool rht_is_a_nulls(const struct rhash_head *ptr)
+{
+	return ((u64)ptr & 1);
+}
+
+static inline unsigned int rht_bucket_index(const struct bucket_table *tbl,
+					    unsigned int hash)
+{
+	return hash & (tbl->size - 1);
+}
+
+static inline unsigned int rht_key_get_hash(struct rhashtable *ht,
+	const void *key, const struct rhashtable_params params,
+	unsigned int hash_rnd)
+{
+	unsigned int key_len = params.key_len ?: ht->key_len;
+
+	if (params.hashfn)
+		return params.hashfn(key, key_len, hash_rnd);
+	if (__builtin_constant_p(params.key_len) && params.key_len) {
+		if (key_len & (sizeof(u32) - 1))
+			return jhash(key, key_len, hash_rnd);
+		return jhash2(key, key_len / sizeof(u32), hash_rnd);
+	}
+	return ht->p.hashfn(key, key_len, hash_rnd);
+}
+
+static inline unsigned int rht_key_hashfn(
+	struct rhashtable *ht, const struct bucket_table *tbl,
+	const void *key, const struct rhashtable_params params)
+{
+	return rht_bucket_index(tbl, rht_key_get_hash(ht, key, params,
+						      tbl->hash_rnd));
+}
+
+static inline unsigned int rht_head_hashfn(
+	struct rhashtable *ht, const struct bucket_table *tbl,
+	const struct rhash_head *he, const struct rhashtable_params params)
+{
+	const char *ptr = rht_obj(ht, he);
+
+	return likely(params.obj_hashfn) ?
+	       rht_bucket_index(tbl, params.obj_hashfn(ptr, params.key_len ?:
+							      ht->p.key_len,
+						       tbl->hash_rnd)) :
+	       rht_key_hashfn(ht, tbl, ptr + params.key_offset, params);
+}
+
+/**
+ * rht_grow_above_75 - returns true if nelems > 0.75 * table-size
+ * @ht:		hash table
+ * @tbl:	current table
+ */
+static inline bool rht_grow_above_75(const struct rhashtable *ht,
+				     const struct bucket_table *tbl)
+{
+	/* Expand table when exceeding 75% load */
+	return atomic_read(&ht->nelems) > (tbl->size / 4 * 3) &&
+	       (!ht->p.max_size || tbl->size < ht->p.max_size);
+}
+
+/**
+ * rht_shrink_below_30 - returns true if nelems < 0.3 * table-size
+ * @ht:		hash table
+ * @tbl:	current table
+ */
+static inline bool rht_shrink_below_30(const struct rhashtable *ht,
+				       const struct bucket_table *tbl)
+{
+	/* Shrink table beneath 30% load */
+	return atomic_read(&ht->nelems) < (tbl->size * 3 / 10) &&
+	       tbl->size > ht->p.min_size;
+}
+
+/**
+ * rht_grow_above_100 - returns true if nelems > table-size
+ * @ht:		hash table
+ * @tbl:	current table
+ */
+static inline bool rht_grow_above_100(const struct rhashtable *ht,
+				      const struct bucket_table *tbl)
+{
+	return atomic_read(&ht->nelems) > tbl->size &&
+		(!ht->p.max_size || tbl->size < ht->p.max_size);
+}
+
+/**
+ * rht_grow_above_max - returns true if table is above maximum
+ * @ht:		hash table
+ * @tbl:	current table
+ */
+static inline bool rht_grow_above_max(const struct rhashtable *ht,
+				      const struct bucket_table *tbl)
+{
+	return atomic_read(&ht->nelems) >= ht->max_elems;
+}
+
+/*
+ * Bucket accessors. The bucket word is only written with its lock bit
+ * held; readers mask the bit off and see either the old or the new head.
+ */
+static inline struct rhash_head *rht_ptr(const struct bucket_table *tbl,
+					 unsigned int hash)
+{
+	const u64 *bkt = &tbl->buckets[hash];
+	u64 v = READ_ONCE(*bkt) & ~BIT(RHT_LOCK_BIT);
+
+	return v ? (struct rhash_head *)v : RHT_NULLS_MARKER(bkt);
+}
+
+static inline void rht_lock(struct bucket_table *tbl, unsigned int hash)
+{
+	bit_spin_lock(RHT_LOCK_BIT, &tbl->buckets[hash]);
+}
+
+static inline void rht_unlock(struct bucket_table *tbl, unsigned int hash)
+{
+	bit_spin_unlock(RHT_LOCK_BIT, &tbl->buckets[hash]);
+}
+
+/*
+ * Publish @obj as the new head of a locked bucket. A nulls marker stands
+ * for the empty chain. The release orders the object's initialisation
+ * before it becomes reachable.
+ */
+static inline void rht_assign_locked(struct bucket_table *tbl,
+				     unsigned int hash, struct rhash_head *obj)
+{
+	u64 *bkt = &tbl->buckets[hash];
+
+	if (rht_is_a_nulls(obj))
+		obj = NULL;
+	smp_store_release(bkt, (u64)obj | BIT(RHT_LOCK_BIT));
+}
+
+/*
+ * A bucket of an old table whose contents have been moved into the
+ * future table. Updates must be applied to the future table instead.
+ */
+static inline bool rht_bucket_moved(const struct bucket_table *tbl,
+				    unsigned int hash)
+{
+	return hash < READ_ONCE(tbl->rehash);
+}
+
+/**
+ * rht_for_each_rcu - iterate over rcu hash chain
+ * @pos:	the &struct rhash_head to use as a loop cursor.
+ * @tbl:	the &struct bucket_table
+ * @hash:	the hash value / bucket index
+ *
+ * This hash chain list-traversal primitive may safely run concurrently with
+ * the _rcu mutation primitives such as rhashtable_insert() as long as the
+ * traversal is guarded by rcu_read_lock().
+ */
+#define rht_for_each_rcu(pos, tbl, hash)				\
+	for (pos = rht_ptr(tbl, hash);					\
+	     !rht_is_a_nulls(pos);					\
+	     pos = rcu_dereference_raw(pos->next))
+
+static inline int rhashtable_compare(struct rhashtable_compare_arg *arg,
+				     const void *obj)
+{
+	struct rhashtable *ht = arg->ht;
+	const char *ptr = obj;
+
+	return memcmp(ptr + ht->p.key_offset, arg->key, ht->p.key_len);
+}
+
+/*
+ * Find the table, of @tbl and the tables being built behind it, whose
+ * bucket for @obj currently holds the updates, and return it with that
+ * bucket locked.
+ */
+static inline struct bucket_table *rht_lock_obj_bucket(
+	struct rhashtable *ht, struct bucket_table *tbl,
+	struct rhash_head *obj, const struct rhashtable_params params,
+	unsigned int *hashp)
+{
+	struct bucket_table *new_tbl;
+	unsigned int hash;
+
+	for (;;) {
+		hash = rht_head_hashfn(ht, tbl, obj, params);
+		rht_lock(tbl, hash);
+
+		new_tbl = rht_dereference_rcu(tbl->future_tbl, ht);
+		if (!new_tbl || !rht_bucket_moved(tbl, hash))
+			break;
+
+		rht_unlock(tbl, hash);
+		tbl = new_tbl;
+	}
+
+	*hashp = hash;
+	return tbl;
+}
+
+/* Internal function, do not use. */
+static inline struct rhash_head *__rhashtable_lookup(
+	struct rhashtable *ht, const void *key,
+	const struct rhashtable_params params)
+{
+	struct rhashtable_compare_arg arg = {
+		.ht = ht,
+		.key = key,
+	};
+	struct bucket_table *tbl;
+	struct rhash_head *he;
+	unsigned int hash;
+
+	rht_read_enter(ht);
+
+	tbl = rht_dereference_rcu(ht->tbl, ht);
+restart:
+	hash = rht_key_hashfn(ht, tbl, key, params);
+	rht_for_each_rcu(he, tbl, hash) {
+		if (params.obj_cmpfn ?
+		    params.obj_cmpfn(&arg, rht_obj(ht, he)) :
+		    rhashtable_compare(&arg, rht_obj(ht, he)))
+			continue;
+		goto out;
+	}
+
+	/* The chain ended in another bucket: an object we stood on moved */
+	if (unlikely(he != RHT_NULLS_MARKER(&tbl->buckets[hash])))
+		goto restart;
+
+	/* Ensure we see any new tables. */
+	smp_rmb();
+
+	tbl = rht_dereference_rcu(tbl->future_tbl, ht);
+	if (unlikely(tbl))
+		goto restart;
+
+	he = NULL;
+out:
+	rht_read_exit(ht);
+	return he;
+}
+
+/**
+ * rhashtable_lookup - search hash table
+ * @ht:		hash table
+ * @key:	the pointer to the key
+ * @params:	hash table parameters
+ *
+ * Computes the hash value for the key and traverses the bucket chain looking
+ * for a entry with an identical key. The first matching entry is returned.
+ *
+ * This must only be called under the RCU read lock.
+ *
+ * Returns the first entry on which the compare function returned true.
+ */
+static inline void *rhashtable_lookup(
+	struct rhashtable *ht, const void *key,
+	const struct rhashtable_params params)
+{
+	struct rhash_head *he = __rhashtable_lookup(ht, key, params);
+
+	return he ? rht_obj(ht, he) : NULL;
+}
+
+/**
+ * rhashtable_lookup_fast - search hash table, without RCU read lock
+ * @ht:		hash table
+ * @key:	the pointer to the key
+ * @params:	hash table parameters
+ *
+ * Computes the hash value for the key and traverses the bucket chain looking
+ * for a entry with an identical key. The first matching entry is returned.
+ *
+ * Only use this function when you have other mechanisms guaranteeing
+ * that the object won't go away after the RCU read lock is released.
+ *
+ * Returns the first entry on which the compare function returned true.
+ */
+static inline void *rhashtable_lookup_fast(
+	struct rhashtable *ht, const void *key,
+	const struct rhashtable_params params)
+{
+	void *obj;
+
+	rcu_read_lock();
+	obj = rhashtable_lookup(ht, key, params);
+	rcu_read_unlock();
+
+	return obj;
+}
+
+/*
+ * After an update: move a few buckets along if a rehash is in flight, and
+ * start one if the load has drifted out of bounds.
+ */
+static inline void rht_update_done(struct rhashtable *ht,
+				   struct bucket_table *tbl, bool grow)
+{
+	if (unlikely(rcu_access_pointer(tbl->future_tbl)))
+		rhashtable_rehash_step(ht);
+	else if (grow ? rht_grow_above_75(ht, tbl) :
+		 (ht->p.automatic_shrinking && rht_shrink_below_30(ht, tbl)))
+		rhashtable_resize(ht, tbl, grow);
+}
+
+/* Internal function, please use rhashtable_insert_fast() instead. */
+static inline int __rhashtable_insert_fast(
+	struct rhashtable *ht, const void *key, struct rhash_head *obj,
+	const struct rhashtable_params params)
+{
+	struct rhashtable_compare_arg arg = {
+		.ht = ht,
+		.key = key,
+	};
+	struct bucket_table *tbl, *first;
+	struct rhash_head *head, *pos;
+	unsigned int hash;
+	int err = 0;
+
+	rcu_read_lock();
+	rht_read_enter(ht);
+
+	first = tbl = rht_dereference_rcu(ht->tbl, ht);
+	tbl = rht_lock_obj_bucket(ht, tbl, obj, params, &hash);
+
+	if (unlikely(rht_grow_above_max(ht, tbl))) {
+		err = -E2BIG;
+		goto out;
+	}
+
+	/*
+	 * The table is badly overloaded and nobody has started on a bigger
+	 * one, e.g. because the last attempt could not allocate: try again
+	 * before adding to an already long chain.
+	 */
+	if (unlikely(rht_grow_above_100(ht, tbl)) &&
+	    !rcu_access_pointer(tbl->future_tbl)) {
+		rht_unlock(tbl, hash);
+		/* On failure the insert still goes ahead, into a longer chain */
+		rhashtable_insert_rehash(ht, tbl);
+		tbl = rht_lock_obj_bucket(ht, tbl, obj, params, &hash);
+	}
+
+	head = rht_ptr(tbl, hash);
+	if (key) {
+		for (pos = head; !rht_is_a_nulls(pos);
+		     pos = rht_dereference(pos->next, ht)) {
+			if (params.obj_cmpfn ?
+			    params.obj_cmpfn(&arg, rht_obj(ht, pos)) :
+			    rhashtable_compare(&arg, rht_obj(ht, pos)))
+				continue;
+			err = -EEXIST;
+			goto out;
+		}
+	}
+
+	RCU_INIT_POINTER(obj->next, head);
+	rht_assign_locked(tbl, hash, obj);
+	atomic_inc(&ht->nelems);
+
+out:
+	rht_unlock(tbl, hash);
+	if (!err)
+		rht_update_done(ht, first, true);
+	rht_read_exit(ht);
+	rcu_read_unlock();
+
+	rht_free_retired(ht);
+
+	return err;
+}
+
+/**
+ * rhashtable_insert_fast - insert object into hash table
+ * @ht:		hash table
+ * @obj:	pointer to hash head inside object
+ * @params:	hash table parameters
+ *
+ * Will take the per bucket bitlock to protect against mutual mutations
+ * on the same bucket. Multiple insertions may occur in parallel unless
+ * they map to the same bucket.
+ *
+ * It is safe to call this function from atomic context.
+ *
+ * Will start growing the table if residency in the table grows beyond
+ * 75%.
+ */
+static inline int rhashtable_insert_fast(
+	struct rhashtable *ht, struct rhash_head *obj,
+	const struct rhashtable_params params)
+{
+	return __rhashtable_insert_fast(ht, NULL, obj, params);
+}
+
+/**
+ * rhashtable_lookup_insert_fast - lookup and insert object into hash table
+ * @ht:		hash table
+ * @obj:	pointer to hash head inside object
+ * @params:	hash table parameters
+ *
+ * This lookup function may only be used for fixed key hash table (key_len
+ * parameter set). It will BUG() if used inappropriately.
+ *
+ * It is safe to call this function from atomic context.
+ *
+ * Returns -EEXIST if an object with the same key is already present.
+ */
+static inline int rhashtable_lookup_insert_fast(
+	struct rhashtable *ht, struct rhash_head *obj,
+	const struct rhashtable_params params)
+{
+	const char *key = rht_obj(ht, obj);
+
+	BUG_ON(ht->p.obj_hashfn);
+
+	return __rhashtable_insert_fast(ht, key + ht->p.key_offset, obj,
+					params);
+}
+
+/* Internal function, please use rhashtable_remove_fast() instead */
+static inline int __rhashtable_remove_fast(
+	struct rhashtable *ht, struct rhash_head *obj,
+	const struct rhashtable_params params)
+{
+	struct bucket_table *tbl, *first;
+	struct rhash_head __rcu **pprev;
+	struct rhash_head *he;
+	unsigned int hash;
+	int err = -ENOENT;
+
+	rcu_read_lock();
+	rht_read_enter(ht);
+
+	first = tbl = rht_dereference_rcu(ht->tbl, ht);
+	tbl = rht_lock_obj_bucket(ht, tbl, obj, params, &hash);
+
+	pprev = NULL;
+	for (he = rht_ptr(tbl, hash); !rht_is_a_nulls(he);
+	     he = rht_dereference(he->next, ht)) {
+		if (he != obj) {
+			pprev = &he->next;
+			continue;
+		}
+
+		he = rht_dereference(obj->next, ht);
+		if (pprev)
+			rcu_assign_pointer(*pprev, he);
+		else
+			rht_assign_locked(tbl, hash, he);
+		atomic_dec(&ht->nelems);
+		err = 0;
+		break;
+	}
+
+	rht_unlock(tbl, hash);
+
+	if (!err)
+		rht_update_done(ht, first, false);
+	rht_read_exit(ht);
+	rcu_read_unlock();
+
+	rht_free_retired(ht);
+
+	return err;
+}
+
+/**
+ * rhashtable_remove_fast - remove object from hash table
+ * @ht:		hash table
+ * @obj:	pointer to hash head inside object
+ * @params:	hash table parameters
+ *
+ * Since the hash chain is single linked, the removal operation needs to
+ * walk the bucket chain upon removal. The removal operation is thus
+ * considerable slow if the hash table is not correctly sized.
+ *
+ * Will automatically shrink the table if permitted when residency drops
+ * below 30%.
+ *
+ * Returns zero on success, -ENOENT if the entry could not be found.
+ */
+static inline int rhashtable_remove_fast(
+	struct rhashtable *ht, struct rhash_head *obj,
+	const struct rhashtable_params params)
+{
+	return __rhashtable_remove_fast(ht, obj, params);
+}
+
+#ifdef CONFIG_RHASHTABLE_BENCH
+void rhashtable_bench(void);
+#else
+static inline void rhashtable_bench(void) { }
+#endif
+
+#endif /* _LINUX_RHASHTABLE_H */
@@ -13,8 +13,19 @@
  * portions Copyright 2005, Red Hat, Inc., Ingo Molnar
  * Released under the General Public License (GPL).
  */
-#define rwlock_init(lock)					\
+#ifdef CONFIG_LOCK_STAT
+extern void __rwlock_init(rwlock_t *lock, const char *name,
+			  struct lock_class_key *key);
+# define rwlock_init(lock)					\
+do {								\
+	static struct lock_class_key __key;			\
+								\
+	__rwlock_init((lock), #lock, &__key);			\
+} while (0)
+#else
+# define rwlock_init(lock)					\
 	do { *(lock) = __RW_LOCK_UNLOCKED(lock); } while (0)
+#endif
 
 #ifndef arch_read_lock_flags
 #define arch_read_lock_flags(lock, flags)	arch_read_lock(lock)
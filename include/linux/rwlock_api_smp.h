@@ -38,8 +38,10 @@ _raw_write_unlock_irqrestore(rwlock_t *lock, u64 flags)
 static inline int __raw_read_trylock(rwlock_t *lock)
 {
 	preempt_disable();
-	if (do_raw_read_trylock(lock))
+	if (do_raw_read_trylock(lock)) {
+		LOCK_ACQUIRED(lock);
 		return 1;
+	}
 	preempt_enable();
 	return 0;
 }
@@ -47,8 +49,10 @@ static inline int __raw_read_trylock(rwlock_t *lock)
 static inline int __raw_write_trylock(rwlock_t *lock)
 {
 	preempt_disable();
-	if (do_raw_write_trylock(lock))
+	if (do_raw_write_trylock(lock)) {
+		LOCK_ACQUIRED(lock);
 		return 1;
+	}
 	preempt_enable();
 	return 0;
 }
@@ -56,7 +60,7 @@ static inline int __raw_write_trylock(rwlock_t *lock)
 static inline void __raw_read_lock(rwlock_t *lock)
 {
 	preempt_disable();
-	do_raw_read_lock(lock);
+	LOCK_CONTENDED(lock, do_raw_read_trylock, do_raw_read_lock);
 }
 
 static inline u64 __raw_read_lock_irqsave(rwlock_t *lock)
@@ -65,7 +69,8 @@ static inline u64 __raw_read_lock_irqsave(rwlock_t *lock)
 
 	local_irq_save(flags);
 	preempt_disable();
-	do_raw_read_lock_flags(lock, &flags);
+	LOCK_CONTENDED_FLAGS(lock, do_raw_read_trylock, do_raw_read_lock,
+			     do_raw_read_lock_flags, &flags);
 
 	return flags;
 }
@@ -74,7 +79,7 @@ static inline void __raw_read_lock_irq(rwlock_t *lock)
 {
 	local_irq_disable();
 	preempt_disable();
-	do_raw_read_lock(lock);
+	LOCK_CONTENDED(lock, do_raw_read_trylock, do_raw_read_lock);
 }
 
 static inline u64 __raw_write_lock_irqsave(rwlock_t *lock)
@@ -83,7 +88,8 @@ static inline u64 __raw_write_lock_irqsave(rwlock_t *lock)
 
 	local_irq_save(flags);
 	preempt_disable();
-	do_raw_write_lock_flags(lock, &flags);
+	LOCK_CONTENDED_FLAGS(lock, do_raw_write_trylock, do_raw_write_lock,
+			     do_raw_write_lock_flags, &flags);
 
 	return flags;
 }
@@ -92,13 +98,13 @@ static inline void __raw_write_lock_irq(rwlock_t *lock)
 {
 	local_irq_disable();
 	preempt_disable();
-	do_raw_write_lock(lock);
+	LOCK_CONTENDED(lock, do_raw_write_trylock, do_raw_write_lock);
 }
 
 static inline void __raw_write_lock(rwlock_t *lock)
 {
 	preempt_disable();
-	do_raw_write_lock(lock);
+	LOCK_CONTENDED(lock, do_raw_write_trylock, do_raw_write_lock);
 }
 
 static inline void __raw_write_unlock(rwlock_t *lock)
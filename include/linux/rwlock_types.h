@@ -10,10 +10,21 @@
  */
 typedef struct {
 	arch_rwlock_t raw_lock;
+#ifdef CONFIG_LOCK_STAT
+	struct lockstat_map stat_map;
+#endif
 } rwlock_t;
 
+#ifdef CONFIG_LOCK_STAT
+# define RW_STAT_MAP_INIT(lockname)	\
+	.stat_map = STATIC_LOCKSTAT_MAP_INIT(#lockname, &lockname)
+#else
+# define RW_STAT_MAP_INIT(lockname)
+#endif
+
 #define __RW_LOCK_UNLOCKED(lockname) \
 	(rwlock_t)	{	.raw_lock = __ARCH_RW_LOCK_UNLOCKED,	\
+				RW_STAT_MAP_INIT(lockname)		\
 	}
 
 #define DEFINE_RWLOCK(x)	rwlock_t x = __RW_LOCK_UNLOCKED(x)
@@ -3,9 +3,14 @@
 #define __LINUX_SCHED_H_
 
 #include <linux/atomic.h>
+#include <linux/cnode.h>
+#include <linux/ipc.h>
+#include <linux/list.h>
 #include <linux/spinlock.h>
 #include <linux/mm_types.h>
+#include <linux/sched/prio.h>
 
+#include <asm/current.h>
 #include <asm/thread_info.h>
 
 /*
@@ -13,6 +18,12 @@
  * APIs (schedule(), wakeup variants, etc.)
  */
 
+/* Used in tsk->state: */
+#define TASK_RUNNING			0x0000
+#define TASK_INTERRUPTIBLE		0x0001
+#define TASK_UNINTERRUPTIBLE		0x0002
+#define TASK_DEAD			0x0080
+
 /* Task command name length: */
 #define TASK_COMM_LEN			16
 
@@ -33,6 +44,23 @@ struct task_struct {
 	randomized_struct_fields_start
 
 	void				*stack;
+#ifdef CONFIG_VMAP_STACK
+	struct vm_struct		*stack_vm_area;
+#endif
+
+	/* Runqueue linkage, and the cpu whose runqueue that is: */
+	struct list_head		run_list;
+	unsigned int			cpu;
+	/* Set from the switch to the task until it is fully switched out: */
+	int				on_cpu;
+
+	/*
+	 * Priority the task runs at, which can be better than its own
+	 * static_prio while it serves IPC for a more important thread:
+	 */
+	unsigned int			prio;
+	unsigned int			static_prio;
+
 	atomic_t			usage;
 
 	struct mm_struct		*mm;
@@ -57,6 +85,12 @@ struct task_struct {
 	/* A live task holds one reference: */
 	atomic_t			stack_refcount;
 
+	/* Endpoint IPC state, see kernel/ipc/: */
+	struct ipc_thread		ipc;
+
+	/* Capability space and its lookup cache, see kernel/cnode.c: */
+	struct cspace			cspace;
+
 	/*
 	 * New fields for task_struct should be added above here, so that
 	 * they are included in the randomized portion of task_struct.
@@ -69,6 +103,31 @@ struct task_struct {
 
 extern u64 init_stack[THREAD_SIZE / sizeof(u64)];
 
+#define set_current_state(state_value)				\
+	smp_store_mb(current->state, (state_value))
+
+extern void sched_init(void);
+extern void schedule(void);
+extern void sched_switch_to(struct task_struct *next);
+extern bool sched_may_switch(unsigned int prio);
+extern void sched_set_prio(struct task_struct *p, unsigned int prio);
+extern int wake_up_process(struct task_struct *tsk);
+
+static inline void set_tsk_need_resched(struct task_struct *tsk)
+{
+	set_ti_thread_flag(&tsk->thread_info, TIF_NEED_RESCHED);
+}
+
+static inline void clear_tsk_need_resched(struct task_struct *tsk)
+{
+	clear_ti_thread_flag(&tsk->thread_info, TIF_NEED_RESCHED);
+}
+
+static inline int need_resched(void)
+{
+	return unlikely(test_thread_flag(TIF_NEED_RESCHED));
+}
+
 extern int __cond_resched_lock(spinlock_t *lock);
 
 #define cond_resched_lock(lock) ({				\
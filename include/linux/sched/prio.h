@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_SCHED_PRIO_H
+#define _LINUX_SCHED_PRIO_H
+
+/*
+ * Priorities run from 0, the most important, to MAX_PRIO - 1. Each
+ * runqueue keeps a list per priority and a word with a bit for each list
+ * that is not empty, so there are at most 64 of them.
+ */
+#define MAX_PRIO		64
+#define DEFAULT_PRIO		(MAX_PRIO / 2)
+
+#endif /* _LINUX_SCHED_PRIO_H */
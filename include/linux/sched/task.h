@@ -2,6 +2,22 @@
 #ifndef __LINUX_SCHED_TASK_H_
 #define __LINUX_SCHED_TASK_H_
 
+#include <linux/init.h>
+#include <linux/linkage.h>
+#include <linux/types.h>
+
+struct mm_struct;
+struct task_struct;
+
 extern struct task_struct init_task;
 
+extern asmlinkage void schedule_tail(struct task_struct *prev);
+
+extern void __init fork_init(void);
+extern struct mm_struct *mm_alloc(void);
+extern void mm_free(struct mm_struct *mm, bool free_mapped);
+extern struct task_struct *create_user_thread(struct mm_struct *mm, u64 pc,
+					      u64 sp, const char *name);
+extern void free_task(struct task_struct *tsk);
+
 #endif /* !__LINUX_SCHED_TASK_H_ */
@@ -10,11 +10,26 @@
 #include <linux/magic.h>
 
 
+static inline void *task_stack_page(const struct task_struct *task)
+{
+	return task->stack;
+}
+
 static inline u64 *end_of_stack(const struct task_struct *task)
 {
 	return task->stack;
 }
 
+static inline struct vm_struct *task_stack_vm_area(const struct task_struct *t)
+{
+#ifdef CONFIG_VMAP_STACK
+	return t->stack_vm_area;
+#else
+	return NULL;
+#endif
+}
+
+extern void put_task_stack(struct task_struct *tsk);
 extern void set_task_stack_end_magic(struct task_struct *tsk);
 
 #endif /* !__LINUX_SCHED_TASK_STACK_H_ */
@@ -13,17 +13,63 @@
  * (C) 2007 SGI, Christoph Lameter
  */
 enum stat_item {
+	ALLOC_FASTPATH,		/* Allocation from cpu slab */
+	ALLOC_SLOWPATH,		/* Allocation by getting a new cpu slab */
+	FREE_FASTPATH,		/* Free to cpu slab */
+	FREE_SLOWPATH,		/* Freeing not to cpu slab */
+	FREE_FROZEN,		/* Freeing to frozen slab */
+	FREE_ADD_PARTIAL,	/* Freeing moves slab to partial list */
+	FREE_REMOVE_PARTIAL,	/* Freeing removes last object */
+	ALLOC_FROM_PARTIAL,	/* Cpu slab acquired from node partial list */
+	ALLOC_SLAB,		/* Cpu slab acquired from page allocator */
+	ALLOC_REFILL,		/* Refill cpu slab from slab freelist */
+	FREE_SLAB,		/* Slab freed to the page allocator */
+	CPUSLAB_FLUSH,		/* Abandoning of the cpu slab */
+	DEACTIVATE_FULL,	/* Cpu slab was full when deactivated */
+	DEACTIVATE_EMPTY,	/* Cpu slab was empty when deactivated */
 	DEACTIVATE_TO_HEAD,	/* Cpu slab was moved to the head of partials */
 	DEACTIVATE_TO_TAIL,	/* Cpu slab was moved to the tail of partials */
+	DEACTIVATE_REMOTE_FREES,/* Slab contained remotely freed objects */
+	DEACTIVATE_BYPASS,	/* Implicit deactivation */
+	ORDER_FALLBACK,		/* Number of times fallback was necessary */
+	CMPXCHG_DOUBLE_CPU_FAIL,/* Failure of this_cpu_cmpxchg_double */
+	CMPXCHG_DOUBLE_FAIL,	/* Number of times that cmpxchg double did not match */
+	CPU_PARTIAL_ALLOC,	/* Used cpu partial on alloc */
+	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
+	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
+	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
 	NR_SLUB_STAT_ITEMS
 };
 
 struct kmem_cache_cpu {
 	void **freelist;
 	u64 tid;
-	struct page *page;
+	struct page *page;	/* The slab from which we are allocating */
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	struct page *partial;	/* Partially allocated frozen slabs */
+#endif
+#ifdef CONFIG_SLUB_STATS
+	unsigned int stat[NR_SLUB_STAT_ITEMS];
+#endif
 };
 
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+#define slub_percpu_partial(c)		((c)->partial)
+
+#define slub_set_percpu_partial(c, p)		\
+({						\
+	slub_percpu_partial(c) = (p)->next;	\
+})
+
+#define slub_percpu_partial_read_once(c)     READ_ONCE(slub_percpu_partial(c))
+#else
+#define slub_percpu_partial(c)			NULL
+
+#define slub_set_percpu_partial(c, p)
+
+#define slub_percpu_partial_read_once(c)	NULL
+#endif /* CONFIG_SLUB_CPU_PARTIAL */
+
 struct kmem_cache_order_objects {
 	unsigned int x;
 };
@@ -37,6 +83,10 @@ struct kmem_cache {
 	unsigned int size;	/* The size of an object including meta data */
 	unsigned int object_size;/* The size of an object without meta data */
 	unsigned int offset;	/* Free pointer offset. */
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	/* Number of per cpu partial objects to keep around */
+	unsigned int cpu_partial;
+#endif
 
 	struct kmem_cache_order_objects oo;
 
@@ -58,8 +108,41 @@ struct kmem_cache {
 	struct kmem_cache_node *node;
 };
 
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+#define slub_cpu_partial(s)		((s)->cpu_partial)
+#define slub_set_cpu_partial(s, n)		\
+({						\
+	slub_cpu_partial(s) = (n);		\
+})
+#else
 #define slub_cpu_partial(s)		(0)
+#define slub_set_cpu_partial(s, n)
+#endif /* CONFIG_SLUB_CPU_PARTIAL */
 
 void *fixup_red_left(struct kmem_cache *s, void *p);
 
+/*
+ * Point-in-time view of a cache, as returned by kmem_cache_stats_snapshot().
+ * The object and slab counts are always maintained; @stat is the sum of the
+ * per cpu counters and reads as all zeroes without CONFIG_SLUB_STATS.
+ */
+struct kmem_cache_stats {
+	const char *name;
+	unsigned int object_size;
+	unsigned int size;
+	unsigned int order;
+	unsigned int objects_per_slab;
+	unsigned int cpu_partial;
+	u64 min_partial;
+	u64 active_objs;
+	u64 num_objs;
+	u64 num_slabs;
+	u64 partial_slabs;
+	u64 stat[NR_SLUB_STAT_ITEMS];
+};
+
+void kmem_cache_stats_snapshot(struct kmem_cache *s,
+			       struct kmem_cache_stats *st);
+void dump_slabinfo(void);
+
 #endif /* !__LINUX_SLUB_DEF_H_ */
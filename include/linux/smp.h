@@ -7,6 +7,7 @@
 #define smp_processor_id() 0
 
 void smp_setup_processor_id(void);
+void smp_prepare_boot_cpu(void);
 
 extern int __boot_cpu_id;
 
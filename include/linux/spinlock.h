@@ -68,8 +68,19 @@
 #include <linux/spinlock_up.h>
 #endif
 
-#define raw_spin_lock_init(lock)				\
+#ifdef CONFIG_LOCK_STAT
+extern void __raw_spin_lock_init(raw_spinlock_t *lock, const char *name,
+				 struct lock_class_key *key);
+# define raw_spin_lock_init(lock)				\
+do {								\
+	static struct lock_class_key __key;			\
+								\
+	__raw_spin_lock_init((lock), #lock, &__key);		\
+} while (0)
+#else
+# define raw_spin_lock_init(lock)				\
 	do { *(lock) = __RAW_SPIN_LOCK_UNLOCKED(lock); } while (0)
+#endif
 
 #define raw_spin_is_locked(lock)	arch_spin_is_locked(&(lock)->raw_lock)
 
@@ -234,11 +245,22 @@ static __always_inline raw_spinlock_t *spinlock_check(spinlock_t *lock)
 	return &lock->rlock;
 }
 
+#ifdef CONFIG_LOCK_STAT
+/* Name the class after the spinlock_t, not its embedded raw lock */
+#define spin_lock_init(_lock)				\
+do {							\
+	static struct lock_class_key __key;		\
+							\
+	__raw_spin_lock_init(spinlock_check(_lock),	\
+			     #_lock, &__key);		\
+} while (0)
+#else
 #define spin_lock_init(_lock)				\
 do {							\
 	spinlock_check(_lock);				\
 	raw_spin_lock_init(&(_lock)->rlock);		\
 } while (0)
+#endif
 
 static __always_inline void spin_lock(spinlock_t *lock)
 {
@@ -35,8 +35,10 @@ _raw_spin_unlock_irqrestore(raw_spinlock_t *lock, u64 flags)
 static inline int __raw_spin_trylock(raw_spinlock_t *lock)
 {
 	preempt_disable();
-	if (do_raw_spin_trylock(lock))
+	if (do_raw_spin_trylock(lock)) {
+		LOCK_ACQUIRED(lock);
 		return 1;
+	}
 	preempt_enable();
 	return 0;
 }
@@ -52,7 +54,8 @@ static inline u64 __raw_spin_lock_irqsave(raw_spinlock_t *lock)
 	 * do_raw_spin_lock_flags() code, because lockdep assumes
 	 * that interrupts are not re-enabled during lock-acquire:
 	 */
-	do_raw_spin_lock_flags(lock, &flags);
+	LOCK_CONTENDED_FLAGS(lock, do_raw_spin_trylock, do_raw_spin_lock,
+				do_raw_spin_lock_flags, &flags);
 
 	return flags;
 }
@@ -61,13 +64,13 @@ static inline void __raw_spin_lock_irq(raw_spinlock_t *lock)
 {
 	local_irq_disable();
 	preempt_disable();
-	do_raw_spin_lock(lock);
+	LOCK_CONTENDED(lock, do_raw_spin_trylock, do_raw_spin_lock);
 }
 
 static inline void __raw_spin_lock(raw_spinlock_t *lock)
 {
 	preempt_disable();
-	do_raw_spin_lock(lock);
+	LOCK_CONTENDED(lock, do_raw_spin_trylock, do_raw_spin_lock);
 }
 
 static inline void __raw_spin_unlock(raw_spinlock_t *lock)
@@ -14,13 +14,26 @@
 # include <linux/spinlock_types_up.h>
 #endif
 
+#include <linux/lockstat.h>
+
 typedef struct raw_spinlock {
 	arch_spinlock_t raw_lock;
+#ifdef CONFIG_LOCK_STAT
+	struct lockstat_map stat_map;
+#endif
 } raw_spinlock_t;
 
+#ifdef CONFIG_LOCK_STAT
+# define SPIN_STAT_MAP_INIT(lockname)	\
+	.stat_map = STATIC_LOCKSTAT_MAP_INIT(#lockname, &lockname)
+#else
+# define SPIN_STAT_MAP_INIT(lockname)
+#endif
+
 #define __RAW_SPIN_LOCK_INITIALIZER(lockname)	\
 	{					\
 	.raw_lock = __ARCH_SPIN_LOCK_UNLOCKED,	\
+	SPIN_STAT_MAP_INIT(lockname)		\
 	}
 
 #define __RAW_SPIN_LOCK_UNLOCKED(lockname)	\
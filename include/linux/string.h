@@ -115,7 +115,9 @@ extern int bcmp(const void *,const void *,size_t);
 extern void * memchr(const void *,int,size_t);
 #endif
 
+void *__memchr_inv(const void *s, int c, size_t n);
 void *memchr_inv(const void *s, int c, size_t n);
+bool memzero_page_check(const void *addr);
 char *strreplace(char *s, char old, char new);
 
 int match_string(const char * const *array, size_t n, const char *string);
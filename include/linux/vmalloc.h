@@ -11,6 +11,8 @@
 
 #include <asm/page.h>
 
+struct mmu_gather;
+
 /* bits in flags of vmalloc's vm_struct below */
 #define VM_IOREMAP		0x00000001	/* ioremap() and friends */
 #define VM_ALLOC		0x00000002	/* vmalloc() */
@@ -96,6 +98,8 @@ extern int map_kernel_range_noflush(u64 start, u64 size,
 				    pgprot_t prot, struct page **pages);
 extern void unmap_kernel_range_noflush(u64 addr, u64 size);
 extern void unmap_kernel_range(u64 addr, u64 size);
+extern void unmap_kernel_range_gather(struct mmu_gather *tlb, u64 addr,
+				      u64 size);
 
 extern struct vm_struct *get_vm_area(u64 size, u64 flags);
 extern struct vm_struct *get_vm_area_caller(u64 size,
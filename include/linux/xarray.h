@@ -290,6 +290,8 @@ void *xa_store(struct xarray *, u64 index, void *entry, gfp_t);
 void *xa_erase(struct xarray *, u64 index);
 void *xa_store_range(struct xarray *, u64 first, u64 last,
 			void *entry, gfp_t);
+unsigned int xa_load_batch(struct xarray *, u64 start, void **dst,
+			unsigned int nr);
 bool xa_get_mark(struct xarray *, u64 index, xa_mark_t);
 void xa_set_mark(struct xarray *, u64 index, xa_mark_t);
 void xa_clear_mark(struct xarray *, u64 index, xa_mark_t);
@@ -1208,8 +1210,15 @@ static inline void xas_set(struct xa_state *xas, u64 index)
 static inline void xas_set_order(struct xa_state *xas, u64 index,
 					unsigned int order)
 {
+#ifdef CONFIG_XARRAY_MULTI
+	xas->xa_index = order < BITS_PER_LONG ? (index >> order) << order : 0;
+	xas->xa_shift = order - (order % XA_CHUNK_SHIFT);
+	xas->xa_sibs = (1 << (order % XA_CHUNK_SHIFT)) - 1;
+	xas->xa_node = XAS_RESTART;
+#else
 	BUG_ON(order > 0);
 	xas_set(xas, index);
+#endif
 }
 
 /**
@@ -1434,5 +1443,6 @@ static inline void *xas_next(struct xa_state *xas)
 /* Move the radix tree node cache here */
 extern struct kmem_cache *radix_tree_node_cachep;
 extern void radix_tree_node_rcu_free(struct rcu_head *head);
+extern struct xa_node *radix_tree_node_cache_get(void);
 
 #endif /* !__LINUX_XARRAY_H_ */
@@ -15,8 +15,16 @@ __init_task_data
 	.thread_info	= INIT_THREAD_INFO(init_task),
 	.stack_refcount	= ATOMIC_INIT(1),
 	.state		= 0,
+	.on_cpu		= 1,
 	.stack		= init_stack,
+	.run_list	= LIST_HEAD_INIT(init_task.run_list),
+	.prio		= MAX_PRIO - 1,
+	.static_prio	= MAX_PRIO - 1,
 	.active_mm	= &init_mm,
 	.comm		= INIT_TASK_COMM,
 	.usage		= ATOMIC_INIT(2),
+	.ipc		= {
+		.ep_link	= LIST_HEAD_INIT(init_task.ipc.ep_link),
+		.serve_link	= LIST_HEAD_INIT(init_task.ipc.serve_link),
+	},
 };
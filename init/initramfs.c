@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Starting the boot services from the initrd
+ *
+ * The initrd is an uncompressed newc cpio archive. Every regular file
+ * under BOOT_SERVICES_DIR in it is a static ELF executable, started as a
+ * thread in an address space of its own. The services run from the
+ * initrd pages themselves, see elf_map_image(); for the text and
+ * read-only data of a service to be shared rather than copied, its file
+ * has to start on a page boundary in the archive.
+ *
+ * Loading is split into one work item per service, so that any cpu can
+ * take part: boot_services_work() claims items until none are left. The
+ * services are started only once all are loaded, in archive order, so
+ * the order they start in does not depend on which cpu loaded what.
+ *
+ * A service whose file name starts with a number and a dash, such as
+ * "sbin/8-console", runs at that static priority; any other service runs
+ * at DEFAULT_PRIO. Calls pass the priority on to the servers they reach,
+ * see kernel/ipc/prio.c.
+ *
+ * Each service starts with a root CNode of 2^BOOT_CNODE_RADIX_BITS slots
+ * that decodes cptrs 0-255 in one step, holding the capabilities listed
+ * in <linux/initrd.h>. All of them share one boot endpoint to find each
+ * other through, each with its own badge: its index in the archive plus
+ * one.
+ */
+
+#include <linux/kernel.h>
+#include <linux/atomic.h>
+#include <linux/cnode.h>
+#include <linux/ctype.h>
+#include <linux/earlycpio.h>
+#include <linux/elf.h>
+#include <linux/errno.h>
+#include <linux/gfp.h>
+#include <linux/init.h>
+#include <linux/initrd.h>
+#include <linux/ipc.h>
+#include <linux/mm.h>
+#include <linux/mm_types.h>
+#include <linux/sched.h>
+#include <linux/sched/task.h>
+
+#include <asm/page.h>
+#include <asm/pgtable.h>
+#include <asm/processor.h>
+
+phys_addr_t phys_initrd_start __initdata;
+u64 phys_initrd_size __initdata;
+
+u64 initrd_start, initrd_end;
+
+#define BOOT_SERVICES_DIR	"sbin/"
+#define MAX_BOOT_SERVICES	32
+
+#define BOOT_STACK_ORDER	2
+#define BOOT_STACK_SIZE		(PAGE_SIZE << BOOT_STACK_ORDER)
+#define BOOT_STACK_TOP		TASK_SIZE
+
+#define BOOT_CNODE_RADIX_BITS	8
+
+struct boot_service {
+	struct cpio_data	file;
+	struct task_struct	*task;
+	int			err;
+};
+
+static struct boot_service boot_services[MAX_BOOT_SERVICES] __initdata;
+static unsigned int nr_boot_services __initdata;
+
+/* Next item to claim, and the number of items finished */
+static atomic_t boot_services_next __initdata = ATOMIC_INIT(0);
+static atomic_t boot_services_done __initdata = ATOMIC_INIT(0);
+
+static struct endpoint *boot_endpoint __initdata;
+
+/*
+ * Page by page, so that on failure mm_free() can give back the pages
+ * already mapped one at a time.
+ */
+static int __init map_boot_stack(struct mm_struct *mm)
+{
+	struct page *page;
+	u64 addr;
+	int err;
+
+	for (addr = BOOT_STACK_TOP - BOOT_STACK_SIZE; addr < BOOT_STACK_TOP;
+	     addr += PAGE_SIZE) {
+		page = alloc_page(GFP_KERNEL | __GFP_ZERO);
+		if (!page)
+			return -ENOMEM;
+
+		err = map_user_pfn_range(mm, addr, page_to_pfn(page),
+					 PAGE_SIZE, PAGE_SHARED);
+		if (err) {
+			__free_page(page);
+			return err;
+		}
+	}
+	return 0;
+}
+
+/* Give @tsk its root CNode and the capabilities every service starts with */
+static void __init seed_boot_cspace(struct task_struct *tsk,
+				    struct cnode *cnode, u64 badge)
+{
+	struct cap cap;
+
+	cap_cnode_init(&cap, cnode, 64 - BOOT_CNODE_RADIX_BITS, 0);
+	cspace_set_root(&tsk->cspace, &cap);
+	cspace_insert(&tsk->cspace, BOOT_CAP_CNODE, 64, &cap);
+
+	cap_endpoint_init(&cap, boot_endpoint, CAP_RIGHTS_ALL, badge);
+	cspace_insert(&tsk->cspace, BOOT_CAP_ENDPOINT, 64, &cap);
+}
+
+static int __init load_boot_service(struct boot_service *bs)
+{
+	struct mm_struct *mm;
+	struct cnode *cnode;
+	u64 entry;
+	int err;
+
+	mm = mm_alloc();
+	if (!mm)
+		return -ENOMEM;
+
+	err = elf_map_image(mm, bs->file.data, bs->file.size, &entry);
+	if (err)
+		goto free_mm;
+
+	err = map_boot_stack(mm);
+	if (err)
+		goto free_mm;
+
+	err = -ENOMEM;
+	cnode = cnode_create(BOOT_CNODE_RADIX_BITS);
+	if (!cnode)
+		goto free_mm;
+
+	bs->task = create_user_thread(mm, entry, BOOT_STACK_TOP,
+				      bs->file.name);
+	if (!bs->task)
+		goto free_cnode;
+
+	seed_boot_cspace(bs->task, cnode, bs - boot_services + 1);
+	return 0;
+
+free_cnode:
+	cnode_destroy(cnode);
+free_mm:
+	/* Nothing else has seen @mm; the initrd and vDSO pages are reserved */
+	mm_free(mm, true);
+	return err;
+}
+
+/**
+ * boot_services_work - load boot services until all are claimed
+ *
+ * Runs on the boot cpu, and on any other cpu that is up and idle while
+ * the services are being loaded.
+ */
+void __init boot_services_work(void)
+{
+	unsigned int i;
+
+	while ((i = atomic_inc_return(&boot_services_next) - 1) <
+	       READ_ONCE(nr_boot_services)) {
+		struct boot_service *bs = &boot_services[i];
+
+		bs->err = load_boot_service(bs);
+		smp_mb__before_atomic();
+		atomic_inc(&boot_services_done);
+	}
+}
+
+/* Collect the services in the archive, in order */
+static void __init find_boot_services(void)
+{
+	void *data = (void *)initrd_start;
+	size_t len = initrd_end - initrd_start;
+	struct cpio_data cd;
+	long offset;
+
+	for (;;) {
+		cd = find_cpio_data(BOOT_SERVICES_DIR, data, len, &offset);
+		if (!cd.data)
+			break;
+
+		if (nr_boot_services == MAX_BOOT_SERVICES) {
+			pr_warn("initrd: more than %d boot services, ignoring %s\n",
+				MAX_BOOT_SERVICES, cd.name);
+			break;
+		}
+		boot_services[nr_boot_services++].file = cd;
+
+		data += offset;
+		len -= offset;
+	}
+}
+
+/* The static priority the name of @bs asks for, see the top of this file */
+static unsigned int __init boot_service_prio(struct boot_service *bs)
+{
+	const char *name = bs->file.name;
+	char *end;
+	u64 prio;
+
+	if (!isdigit(*name))
+		return DEFAULT_PRIO;
+
+	prio = simple_strtoul(name, &end, 10);
+	if (*end != '-')
+		return DEFAULT_PRIO;
+
+	if (prio >= MAX_PRIO) {
+		pr_warn("initrd: %s: priority %llu out of range, using %d\n",
+			name, prio, DEFAULT_PRIO);
+		return DEFAULT_PRIO;
+	}
+	return prio;
+}
+
+/**
+ * load_boot_services - load and start the services in the initrd
+ */
+void __init load_boot_services(void)
+{
+	unsigned int i;
+
+	if (!initrd_start)
+		return;
+
+	/* Before find_boot_services(): other cpus may start loading then */
+	boot_endpoint = endpoint_create();
+	if (!boot_endpoint) {
+		pr_err("initrd: no memory for the boot endpoint\n");
+		return;
+	}
+
+	find_boot_services();
+	if (!nr_boot_services) {
+		pr_warn("initrd: no boot services in " BOOT_SERVICES_DIR "\n");
+		endpoint_destroy(boot_endpoint);
+		return;
+	}
+
+	boot_services_work();
+	while (atomic_read(&boot_services_done) < nr_boot_services)
+		cpu_relax();
+	smp_rmb();
+
+	for (i = 0; i < nr_boot_services; i++) {
+		struct boot_service *bs = &boot_services[i];
+
+		if (bs->err) {
+			pr_err("initrd: cannot load %s: %d\n", bs->file.name,
+			       bs->err);
+			continue;
+		}
+
+		ipc_thread_set_prio(bs->task, boot_service_prio(bs));
+		pr_info("initrd: starting %s[%lld] at priority %u\n",
+			bs->file.name, task_pid_nr(bs->task),
+			bs->task->static_prio);
+		wake_up_process(bs->task);
+	}
+}
@@ -15,12 +15,26 @@
 #include <linux/sched/task.h>
 #include <linux/sched/task_stack.h>
 #include <linux/irqflags.h>
+#include <linux/irq.h>
 #include <linux/cache.h>
+#include <linux/channel.h>
+#include <linux/cnode.h>
 #include <linux/smp.h>
 #include <linux/jump_label.h>
 #include <linux/cpu.h>
 #include <linux/params.h>
-
+#include <linux/initrd.h>
+#include <linux/ipc.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/notification.h>
+#include <linux/slab.h>
+#include <linux/percpu.h>
+#include <linux/percpu_counter.h>
+#include <linux/rhashtable.h>
+
+#include <asm/pgtable.h>
 #include <asm/sections.h>
 
 /* Untouched command line saved by arch-specific code. */
@@ -89,6 +103,17 @@ void __init __weak smp_setup_processor_id(void)
 {
 }
 
+/*
+ * Set up kernel memory allocators
+ */
+static void __init mm_init(void)
+{
+	mem_init();
+	kmem_cache_init();
+	pgtable_cache_init();
+	vmalloc_init();
+}
+
 asmlinkage __visible void __init start_kernel(void)
 {
 	char *command_line;
@@ -108,6 +133,42 @@ asmlinkage __visible void __init start_kernel(void)
 	boot_cpu_init();
 
 	setup_arch(&command_line);
+	setup_per_cpu_areas();
+	smp_prepare_boot_cpu();	/* arch-specific boot-cpu hooks */
+	percpu_counter_startup();
+
+	build_all_zone(NODE_DATA());
+	mm_init();
+	setup_per_cpu_pageset();
+	trace_printk_init();
+
+	/*
+	 * Set up the scheduler prior starting any interrupts (such as the
+	 * timer interrupt). Its per-cpu runqueues must not be touched before
+	 * setup_per_cpu_areas() has copied the per-cpu template.
+	 */
+	sched_init();
+
+	fork_init();
+
+	/* Object caches, needed before load_boot_services() hands out caps */
+	ipc_init();
+	cnode_init();
+	notification_init();
+	channel_init();
+
+	init_IRQ();
+
+	early_boot_irqs_disabled = false;
+	local_irq_enable();
 
 	pr_notice("%s", linux_banner);
+
+	rhashtable_bench();
+	ipc_prio_test();
+
+	load_boot_services();
+
+	/* The boot task is this cpu's idle task from here on */
+	cpu_startup_entry();
 }
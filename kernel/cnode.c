@@ -0,0 +1,380 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Capability space decoding and update
+ *
+ * Lookups take no locks: they run on every syscall and only ever read
+ * slots. Updates are rare and serialise on cspace_lock. Another cpu may
+ * rewrite a slot while it is being read, so readers go through
+ * cap_load(), which checks the slot's sequence count around its copy.
+ *
+ * Objects are not reference counted yet: deleting a capability never
+ * frees what it refers to, and a CNode is never freed, so a slot pointer
+ * found by a lookup always points at valid memory.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cnode.h>
+#include <linux/errno.h>
+#include <linux/init.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#define NR_CNODE_CACHES	(CNODE_MAX_RADIX_BITS - CNODE_MIN_RADIX_BITS + 1)
+
+static struct kmem_cache *cnode_cachep[NR_CNODE_CACHES];
+
+static const char * const cnode_cache_names[NR_CNODE_CACHES] = {
+	"cnode-1", "cnode-2", "cnode-3", "cnode-4",
+	"cnode-5", "cnode-6", "cnode-7", "cnode-8",
+};
+
+static DEFINE_RAW_SPINLOCK(cspace_lock);
+
+/* Bumped whenever a cptr may have started to decode to a different slot */
+u64 cspace_generation;
+
+static inline u64 cap_bits_mask(unsigned int bits)
+{
+	return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+/*
+ * Rewrite @slot with @cap, or empty it if @cap is NULL. Called with
+ * cspace_lock held.
+ */
+static void cap_store(struct cap *slot, const struct cap *cap)
+{
+	WRITE_ONCE(slot->seq, slot->seq + 1);
+	smp_wmb();
+
+	if (cap) {
+		slot->type = cap->type;
+		slot->rights = cap->rights;
+		slot->radix_bits = cap->radix_bits;
+		slot->guard_bits = cap->guard_bits;
+		slot->obj = cap->obj;
+		slot->data = cap->data;
+	} else {
+		slot->type = CAP_NULL;
+	}
+
+	smp_store_release(&slot->seq, slot->seq + 1);
+}
+
+/* Called with cspace_lock held, after the slot update is complete */
+static void cspace_changed(void)
+{
+	smp_wmb();
+	WRITE_ONCE(cspace_generation, cspace_generation + 1);
+}
+
+/**
+ * cnode_create - allocate an empty CNode
+ * @radix_bits: log2 of the number of slots
+ *
+ * Return: the CNode, or NULL if @radix_bits is out of range or there is
+ * no memory.
+ */
+struct cnode *cnode_create(unsigned int radix_bits)
+{
+	struct cnode *cnode;
+
+	if (radix_bits < CNODE_MIN_RADIX_BITS ||
+	    radix_bits > CNODE_MAX_RADIX_BITS)
+		return NULL;
+
+	cnode = kmem_cache_zalloc(cnode_cachep[radix_bits - CNODE_MIN_RADIX_BITS],
+				  GFP_KERNEL);
+	if (cnode)
+		cnode->radix_bits = radix_bits;
+	return cnode;
+}
+
+/* Free a CNode no capability refers to */
+void cnode_destroy(struct cnode *cnode)
+{
+	kmem_cache_free(cnode_cachep[cnode->radix_bits - CNODE_MIN_RADIX_BITS],
+			cnode);
+}
+
+void cap_cnode_init(struct cap *cap, struct cnode *cnode,
+		    unsigned int guard_bits, u64 guard)
+{
+	memset(cap, 0, sizeof(*cap));
+	cap->type = CAP_CNODE;
+	cap->rights = CAP_RIGHTS_ALL;
+	cap->radix_bits = cnode->radix_bits;
+	cap->guard_bits = guard_bits;
+	cap->obj = cnode;
+	cap->data = guard & cap_bits_mask(guard_bits);
+}
+
+void cap_endpoint_init(struct cap *cap, struct endpoint *ep,
+		       unsigned int rights, u64 badge)
+{
+	memset(cap, 0, sizeof(*cap));
+	cap->type = CAP_ENDPOINT;
+	cap->rights = rights;
+	cap->obj = ep;
+	cap->data = badge;
+}
+
+void cap_notification_init(struct cap *cap, struct notification *ntfn,
+			   unsigned int rights, u64 badge)
+{
+	memset(cap, 0, sizeof(*cap));
+	cap->type = CAP_NOTIFICATION;
+	cap->rights = rights;
+	cap->obj = ntfn;
+	cap->data = badge;
+}
+
+void cap_irq_handler_init(struct cap *cap, unsigned int irq)
+{
+	memset(cap, 0, sizeof(*cap));
+	cap->type = CAP_IRQ_HANDLER;
+	cap->rights = CAP_RIGHTS_ALL;
+	cap->data = irq;
+}
+
+/* @rights is CAP_RIGHT_SEND for a producer, CAP_RIGHT_RECV for a consumer */
+void cap_channel_init(struct cap *cap, struct channel *ch,
+		      unsigned int rights)
+{
+	memset(cap, 0, sizeof(*cap));
+	cap->type = CAP_CHANNEL;
+	cap->rights = rights;
+	cap->obj = ch;
+}
+
+/*
+ * Decode the low @depth bits of @cptr starting at the CNode @root refers
+ * to. On success @left is set to the number of bits that were not used,
+ * which is non-zero only if the walk ended early at a slot not holding a
+ * CNode capability.
+ */
+static struct cap *cspace_resolve(const struct cap *root, u64 cptr,
+				  unsigned int depth, unsigned int *left)
+{
+	unsigned int bits = depth;
+	struct cap node, *slot;
+
+	cap_load(root, &node);
+	if (node.type != CAP_CNODE)
+		return NULL;
+
+	do {
+		unsigned int radix_bits = node.radix_bits;
+		unsigned int guard_bits = node.guard_bits;
+		struct cnode *cnode = node.obj;
+
+		if (unlikely(radix_bits + guard_bits > bits))
+			return NULL;
+
+		if (guard_bits) {
+			u64 guard = cptr >> (bits - guard_bits);
+
+			if ((guard & cap_bits_mask(guard_bits)) != node.data)
+				return NULL;
+		}
+		bits -= radix_bits + guard_bits;
+
+		slot = &cnode->slots[(cptr >> bits) & cap_bits_mask(radix_bits)];
+		if (!bits)
+			break;
+
+		cap_load(slot, &node);
+	} while (node.type == CAP_CNODE);
+
+	*left = bits;
+	return slot;
+}
+
+/*
+ * The out of line half of cspace_lookup(): walk the tree and remember the
+ * slot in @cs's cache under the generation the walk started in.
+ */
+struct cap *__cspace_lookup(struct cspace *cs, u64 cptr)
+{
+	struct cap_cache_entry *ce = &cs->cache[cptr & (CAP_CACHE_SIZE - 1)];
+	u64 gen = READ_ONCE(cspace_generation);
+	unsigned int left;
+	struct cap *slot;
+
+	smp_rmb();
+	slot = cspace_resolve(&cs->root, cptr, 64, &left);
+	if (slot) {
+		ce->cptr = cptr;
+		ce->slot = slot;
+		ce->gen = gen;
+	}
+	return slot;
+}
+
+void cspace_init(struct cspace *cs)
+{
+	memset(cs, 0, sizeof(*cs));
+	cs->quota = CSPACE_QUOTA;
+}
+
+/**
+ * cspace_set_root - give a capability space a new root
+ * @cs: the capability space
+ * @root: a CNode capability, or a null one to empty the space
+ */
+void cspace_set_root(struct cspace *cs, const struct cap *root)
+{
+	raw_spin_lock(&cspace_lock);
+	cap_store(&cs->root, root);
+	cspace_changed();
+	raw_spin_unlock(&cspace_lock);
+}
+
+/* Called with cspace_lock held */
+static int __cspace_insert(struct cspace *cs, u64 cptr, unsigned int depth,
+			   const struct cap *cap)
+{
+	unsigned int left;
+	struct cap *slot;
+
+	slot = cspace_resolve(&cs->root, cptr, depth, &left);
+	if (!slot || left)
+		return -EINVAL;
+	if (slot->type != CAP_NULL)
+		return -EBUSY;
+
+	cap_store(slot, cap);
+	/* cptrs that used to stop at this slot now go on past it */
+	if (cap->type == CAP_CNODE)
+		cspace_changed();
+	return 0;
+}
+
+/**
+ * cspace_insert - store a capability in an empty slot
+ * @cs: the capability space
+ * @cptr: address of the slot
+ * @depth: number of low bits of @cptr to decode
+ * @cap: the capability, copied into the slot
+ *
+ * Return: 0, -EINVAL if @cptr does not name a slot at exactly @depth, or
+ * -EBUSY if the slot is in use.
+ */
+int cspace_insert(struct cspace *cs, u64 cptr, unsigned int depth,
+		  const struct cap *cap)
+{
+	int ret;
+
+	if (cap->type == CAP_NULL || depth > 64)
+		return -EINVAL;
+
+	raw_spin_lock(&cspace_lock);
+	ret = __cspace_insert(cs, cptr, depth, cap);
+	raw_spin_unlock(&cspace_lock);
+
+	return ret;
+}
+
+/**
+ * cspace_mint - copy a capability into an empty slot
+ * @dst: capability space of the new slot
+ * @dst_cptr: address of the new slot
+ * @dst_depth: number of low bits of @dst_cptr to decode
+ * @src: capability space holding the original
+ * @src_cptr: address of the original, decoded as by cspace_lookup()
+ * @rights: CAP_RIGHT_* to keep; the copy never has more than the original
+ * @badge: badge for a copy of an unbadged endpoint or notification
+ *	capability, or 0 to keep the original's
+ *
+ * The original is read under cspace_lock, so a concurrent delete cannot
+ * hand back half of one capability and half of the next.
+ *
+ * Return: 0, -EINVAL if either address does not name a slot or the
+ * original is empty, -EPERM for a new badge on anything but an unbadged
+ * endpoint or notification capability, or -EBUSY if the new slot is in
+ * use.
+ */
+int cspace_mint(struct cspace *dst, u64 dst_cptr, unsigned int dst_depth,
+		struct cspace *src, u64 src_cptr, unsigned int rights,
+		u64 badge)
+{
+	unsigned int left;
+	struct cap *slot;
+	struct cap cap;
+	int ret;
+
+	if (dst_depth > 64)
+		return -EINVAL;
+
+	raw_spin_lock(&cspace_lock);
+	slot = cspace_resolve(&src->root, src_cptr, 64, &left);
+	if (!slot || slot->type == CAP_NULL) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	cap = *slot;
+	cap.rights &= rights;
+	if (badge) {
+		if ((cap.type != CAP_ENDPOINT &&
+		     cap.type != CAP_NOTIFICATION) || cap.data) {
+			ret = -EPERM;
+			goto out;
+		}
+		cap.data = badge;
+	}
+
+	ret = __cspace_insert(dst, dst_cptr, dst_depth, &cap);
+out:
+	raw_spin_unlock(&cspace_lock);
+
+	return ret;
+}
+
+/**
+ * cspace_delete - empty a slot
+ * @cs: the capability space
+ * @cptr: address of the slot
+ * @depth: number of low bits of @cptr to decode
+ *
+ * Return: 0, or -EINVAL if @cptr does not name a slot at exactly @depth.
+ */
+int cspace_delete(struct cspace *cs, u64 cptr, unsigned int depth)
+{
+	unsigned int left;
+	struct cap *slot;
+	int ret = 0;
+
+	if (depth > 64)
+		return -EINVAL;
+
+	raw_spin_lock(&cspace_lock);
+	slot = cspace_resolve(&cs->root, cptr, depth, &left);
+	if (!slot || left) {
+		ret = -EINVAL;
+	} else if (slot->type != CAP_NULL) {
+		bool was_cnode = slot->type == CAP_CNODE;
+
+		cap_store(slot, NULL);
+		if (was_cnode)
+			cspace_changed();
+	}
+	raw_spin_unlock(&cspace_lock);
+
+	return ret;
+}
+
+void __init cnode_init(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < NR_CNODE_CACHES; i++) {
+		unsigned int radix_bits = i + CNODE_MIN_RADIX_BITS;
+
+		cnode_cachep[i] = kmem_cache_create(cnode_cache_names[i],
+				sizeof(struct cnode) +
+				(sizeof(struct cap) << radix_bits),
+				0, SLAB_HWCACHE_ALIGN | SLAB_PANIC, NULL);
+	}
+}
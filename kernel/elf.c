@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Mapping ELF executables that are already in memory
+ *
+ * Boot services are linked as static ELF executables and sit in the
+ * initrd, which stays in memory for good. Their segments are not copied
+ * out of it: pages entirely covered by file data are mapped straight from
+ * the image, read-only. Pages of writable segments are marked PTE_COW
+ * too, so .data is only copied page by page as it is first written, see
+ * do_wp_page(). Only the page straddling the end of the file data, and
+ * the .bss after it, get fresh pages.
+ *
+ * Mapping a page of the image needs it to sit at the same offset within
+ * a page as the virtual address it is mapped at. Segments of an image
+ * that does not start on a page boundary in memory are copied instead.
+ */
+
+#include <linux/kernel.h>
+#include <linux/elf.h>
+#include <linux/errno.h>
+#include <linux/gfp.h>
+#include <linux/mm.h>
+#include <linux/mm_types.h>
+#include <linux/overflow.h>
+#include <linux/string.h>
+
+#include <asm/cacheflush.h>
+#include <asm/page.h>
+#include <asm/pgtable.h>
+#include <asm/processor.h>
+
+static pgprot_t elf_segment_prot(u32 p_flags)
+{
+	if (p_flags & PF_W)
+		return (p_flags & PF_X) ? PAGE_SHARED_EXEC : PAGE_SHARED;
+	return (p_flags & PF_X) ? PAGE_READONLY_EXEC : PAGE_READONLY;
+}
+
+/* Writable pages shared with the image start out read-only */
+static pgprot_t elf_shared_prot(u32 p_flags)
+{
+	pgprot_t prot = (p_flags & PF_X) ? PAGE_READONLY_EXEC : PAGE_READONLY;
+
+	if (p_flags & PF_W)
+		prot = __pgprot(pgprot_val(prot) | PTE_COW);
+	return prot;
+}
+
+/*
+ * Map a fresh page at @addr holding the image bytes that belong in
+ * [@from, @to) of it, and zeroes around them.
+ */
+static int elf_map_copy(struct mm_struct *mm, u64 addr, const void *src,
+			u64 from, u64 to, u32 p_flags)
+{
+	u64 kaddr = get_zeroed_page(GFP_KERNEL);
+	int ret;
+
+	if (!kaddr)
+		return -ENOMEM;
+
+	if (to > from)
+		memcpy((void *)(kaddr + (from - addr)), src, to - from);
+	if (p_flags & PF_X)
+		__flush_icache_range(kaddr, kaddr + PAGE_SIZE);
+
+	ret = map_user_pfn_range(mm, addr, __pa(kaddr) >> PAGE_SHIFT,
+				 PAGE_SIZE, elf_segment_prot(p_flags));
+	if (ret)
+		free_page(kaddr);
+	return ret;
+}
+
+static int elf_map_segment(struct mm_struct *mm, const u8 *image,
+			   const struct elf_phdr *phdr)
+{
+	u64 vaddr = phdr->p_vaddr;
+	u64 file_end = vaddr + phdr->p_filesz;
+	u64 mem_end = PAGE_ALIGN(vaddr + phdr->p_memsz);
+	const u8 *data = image + phdr->p_offset;
+	bool shared = PAGE_ALIGNED(image) &&
+		      !((phdr->p_offset - vaddr) & ~PAGE_MASK);
+	u64 addr;
+	int ret;
+
+	for (addr = vaddr & PAGE_MASK; addr < mem_end; addr += PAGE_SIZE) {
+		u64 from = max(addr, vaddr);
+		u64 to = min(addr + PAGE_SIZE, file_end);
+
+		if (shared && addr + PAGE_SIZE <= file_end) {
+			const u8 *src = data + (addr - vaddr);
+
+			if (phdr->p_flags & PF_X)
+				__flush_icache_range((u64)src,
+						     (u64)src + PAGE_SIZE);
+			ret = map_user_pfn_range(mm, addr,
+						 __pa(src) >> PAGE_SHIFT,
+						 PAGE_SIZE,
+						 elf_shared_prot(phdr->p_flags));
+		} else {
+			ret = elf_map_copy(mm, addr, data + (from - vaddr),
+					   from, to, phdr->p_flags);
+		}
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static bool elf_phdr_ok(const struct elf_phdr *phdr, u64 size)
+{
+	u64 end;
+
+	if (phdr->p_filesz > phdr->p_memsz)
+		return false;
+	if (check_add_overflow(phdr->p_offset, phdr->p_filesz, &end) ||
+	    end > size)
+		return false;
+	if (check_add_overflow(phdr->p_vaddr, phdr->p_memsz, &end) ||
+	    end > TASK_SIZE)
+		return false;
+	return true;
+}
+
+/**
+ * elf_map_image - map the loadable segments of an ELF executable
+ * @mm: the address space to map them into
+ * @image: the executable, in the linear map, which must stay there
+ * @size: size of @image
+ * @entry: set to the entry point
+ *
+ * Segments must not share pages with each other or with anything else
+ * mapped in @mm. The architecture's additional pages, such as the vDSO,
+ * are mapped along with them.
+ *
+ * Return: 0, -ENOEXEC if @image is not a static AArch64 executable,
+ * -EBUSY if a page to map is in use, or -ENOMEM.
+ */
+int elf_map_image(struct mm_struct *mm, const void *image, u64 size,
+		  u64 *entry)
+{
+	const struct elfhdr *ehdr = image;
+	const struct elf_phdr *phdr;
+	u64 phend;
+	int i, ret;
+
+	if (size < sizeof(*ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG))
+		return -ENOEXEC;
+	if (ehdr->e_ident[EI_CLASS] != ELF_CLASS ||
+	    ehdr->e_ident[EI_DATA] != ELF_DATA ||
+	    ehdr->e_type != ET_EXEC || !elf_check_arch(ehdr) ||
+	    ehdr->e_phentsize != sizeof(*phdr))
+		return -ENOEXEC;
+	if (check_add_overflow(ehdr->e_phoff,
+			       (u64)ehdr->e_phnum * sizeof(*phdr), &phend) ||
+	    phend > size)
+		return -ENOEXEC;
+
+	phdr = image + ehdr->e_phoff;
+	for (i = 0; i < ehdr->e_phnum; i++, phdr++) {
+		if (phdr->p_type != PT_LOAD || !phdr->p_memsz)
+			continue;
+		if (!elf_phdr_ok(phdr, size))
+			return -ENOEXEC;
+
+		ret = elf_map_segment(mm, image, phdr);
+		if (ret)
+			return ret;
+	}
+
+	*entry = ehdr->e_entry;
+#ifdef ARCH_HAS_SETUP_ADDITIONAL_PAGES
+	return arch_setup_additional_pages(mm);
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ *  linux/kernel/exit.c
+ *
+ *  Copyright (C) 1991, 1992  Linus Torvalds
+ */
+
+#include <linux/kernel.h>
+#include <linux/compiler.h>
+#include <linux/ipc.h>
+#include <linux/panic.h>
+#include <linux/sched.h>
+#include <linux/sched/task.h>
+
+/**
+ * do_exit - end the current thread
+ * @error_code: exit status, unused: nothing waits for a thread
+ *
+ * The thread is detached from IPC first, see ipc_thread_exit(). Its
+ * address space and capability space may be shared with other threads
+ * and are left alone. The stack and task_struct are freed by the task
+ * that runs next on this cpu, once the switch away is complete.
+ */
+void __noreturn do_exit(long error_code)
+{
+	ipc_thread_exit();
+
+	set_current_state(TASK_DEAD);
+	schedule();
+	BUG();
+}
@@ -11,7 +11,27 @@
  * management can be a bitch. See 'mm/memory.c': 'copy_page_range()'
  */
 
+#include <linux/atomic.h>
+#include <linux/cnode.h>
+#include <linux/gfp.h>
+#include <linux/init.h>
+#include <linux/ipc.h>
+#include <linux/mm.h>
+#include <linux/mm_types.h>
+#include <linux/percpu.h>
+#include <linux/rbtree.h>
+#include <linux/sched.h>
+#include <linux/sched/task.h>
 #include <linux/sched/task_stack.h>
+#include <linux/slab.h>
+#include <linux/smp.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+#include <asm/mmu_context.h>
+#include <asm/pgalloc.h>
+#include <asm/processor.h>
 
 void set_task_stack_end_magic(struct task_struct *tsk)
 {
@@ -20,3 +40,200 @@ void set_task_stack_end_magic(struct task_struct *tsk)
 	stackend = end_of_stack(tsk);
 	*stackend = STACK_END_MAGIC;	/* for overflow detection */
 }
+
+static struct kmem_cache *task_struct_cachep;
+static struct kmem_cache *mm_cachep;
+
+static atomic64_t last_pid = ATOMIC64_INIT(0);
+
+#ifdef CONFIG_VMAP_STACK
+/*
+ * vmalloc() is a bit slow, and calling vfree() enough times will force a TLB
+ * flush.  Try to minimize the number of calls by caching stacks.
+ */
+#define NR_CACHED_STACKS 2
+static DEFINE_PER_CPU(struct vm_struct *, cached_stacks[NR_CACHED_STACKS]);
+#endif
+
+static void *alloc_thread_stack(struct task_struct *tsk)
+{
+#ifdef CONFIG_VMAP_STACK
+	void *stack;
+	int i;
+
+	for (i = 0; i < NR_CACHED_STACKS; i++) {
+		struct vm_struct *s;
+
+		s = this_cpu_xchg(cached_stacks[i], NULL);
+
+		if (!s)
+			continue;
+
+		/* Clear stale pointers from reused stack. */
+		memset(s->addr, 0, THREAD_SIZE);
+
+		tsk->stack_vm_area = s;
+		tsk->stack = s->addr;
+		return s->addr;
+	}
+
+	stack = __vmalloc_node_range(THREAD_SIZE, THREAD_ALIGN,
+				     VMALLOC_START, VMALLOC_END,
+				     GFP_KERNEL | __GFP_ZERO, PAGE_KERNEL,
+				     0, __builtin_return_address(0));
+
+	/*
+	 * We can't call find_vm_area() in interrupt context, and
+	 * free_thread_stack() can be called in interrupt context,
+	 * so cache the vm_struct.
+	 */
+	if (stack)
+		tsk->stack_vm_area = find_vm_area(stack);
+	tsk->stack = stack;
+	return stack;
+#else
+	struct page *page = alloc_pages(GFP_KERNEL, THREAD_SIZE_ORDER);
+
+	tsk->stack = page ? page_to_virt(page) : NULL;
+	return tsk->stack;
+#endif
+}
+
+static void free_thread_stack(struct task_struct *tsk)
+{
+#ifdef CONFIG_VMAP_STACK
+	int i;
+
+	for (i = 0; i < NR_CACHED_STACKS; i++) {
+		if (this_cpu_cmpxchg(cached_stacks[i],
+				     NULL, tsk->stack_vm_area) != NULL)
+			continue;
+
+		return;
+	}
+
+	vfree(tsk->stack);
+#else
+	__free_pages(virt_to_page(tsk->stack), THREAD_SIZE_ORDER);
+#endif
+}
+
+/**
+ * put_task_stack - drop a reference to a task's stack
+ * @tsk: the task, which must never run again once the last reference goes
+ *
+ * The stack goes back to this cpu's cache of free stacks when there is
+ * room, and is freed otherwise.
+ */
+void put_task_stack(struct task_struct *tsk)
+{
+	if (!atomic_dec_and_test(&tsk->stack_refcount))
+		return;
+
+	free_thread_stack(tsk);
+	tsk->stack = NULL;
+#ifdef CONFIG_VMAP_STACK
+	tsk->stack_vm_area = NULL;
+#endif
+}
+
+/**
+ * mm_alloc - allocate an empty user address space
+ *
+ * Return: the address space, or NULL if there is no memory.
+ */
+struct mm_struct *mm_alloc(void)
+{
+	struct mm_struct *mm;
+
+	mm = kmem_cache_zalloc(mm_cachep, GFP_KERNEL);
+	if (!mm)
+		return NULL;
+
+	mm->pgd = pgd_alloc(mm);
+	if (!mm->pgd) {
+		kmem_cache_free(mm_cachep, mm);
+		return NULL;
+	}
+
+	mm->mm_rb = RB_ROOT;
+	spin_lock_init(&mm->page_table_lock);
+	init_new_context(NULL, mm);
+	init_tlb_flush_pending(mm);
+	return mm;
+}
+
+/**
+ * mm_free - free an address space no thread has run in
+ * @mm: the address space
+ * @free_mapped: also free the pages mapped into it, see free_user_pgtables()
+ */
+void mm_free(struct mm_struct *mm, bool free_mapped)
+{
+	free_user_pgtables(mm, free_mapped);
+	pgd_free(mm, mm->pgd);
+	destroy_context(mm);
+	kmem_cache_free(mm_cachep, mm);
+}
+
+/**
+ * create_user_thread - create a thread that starts in user space
+ * @mm: the address space it runs in
+ * @pc: where it starts
+ * @sp: its initial stack pointer
+ * @name: name for messages, truncated to TASK_COMM_LEN
+ *
+ * The thread has an empty capability space and no pager, and runs at
+ * DEFAULT_PRIO. It does not run until it is passed to wake_up_process().
+ *
+ * Return: the thread, or NULL if there is no memory.
+ */
+struct task_struct *create_user_thread(struct mm_struct *mm, u64 pc, u64 sp,
+				       const char *name)
+{
+	struct task_struct *tsk;
+
+	tsk = kmem_cache_zalloc(task_struct_cachep, GFP_KERNEL);
+	if (!tsk)
+		return NULL;
+
+	if (!alloc_thread_stack(tsk)) {
+		kmem_cache_free(task_struct_cachep, tsk);
+		return NULL;
+	}
+	set_task_stack_end_magic(tsk);
+	atomic_set(&tsk->stack_refcount, 1);
+	atomic_set(&tsk->usage, 1);
+
+	tsk->thread_info.flags = _TIF_FOREIGN_FPSTATE;
+	tsk->state = TASK_INTERRUPTIBLE;
+	INIT_LIST_HEAD(&tsk->run_list);
+	tsk->cpu = smp_processor_id();
+	tsk->prio = tsk->static_prio = DEFAULT_PRIO;
+	tsk->mm = mm;
+	tsk->active_mm = mm;
+	tsk->pid = atomic64_inc_return(&last_pid);
+	strlcpy(tsk->comm, name, sizeof(tsk->comm));
+	ipc_thread_init(tsk);
+	cspace_init(&tsk->cspace);
+
+	copy_thread(tsk, pc, sp);
+	return tsk;
+}
+
+/**
+ * free_task - free a thread that will never run again
+ * @tsk: the thread, switched away from for the last time
+ */
+void free_task(struct task_struct *tsk)
+{
+	put_task_stack(tsk);
+	kmem_cache_free(task_struct_cachep, tsk);
+}
+
+void __init fork_init(void)
+{
+	task_struct_cachep = KMEM_CACHE(task_struct,
+					SLAB_HWCACHE_ALIGN | SLAB_PANIC);
+	mm_cachep = KMEM_CACHE(mm_struct, SLAB_HWCACHE_ALIGN | SLAB_PANIC);
+}
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Capability management syscalls
+ *
+ * A thread creates kernel objects straight into empty slots of its own
+ * capability space, copies the capabilities it holds with fewer rights or
+ * a badge, and empties slots. Other threads get capabilities in messages
+ * sent through endpoints held with CAP_RIGHT_GRANT, see ipc_transfer().
+ *
+ * There is no untyped memory to retype yet: objects come from the kernel
+ * allocators. Objects are never freed once a capability to them has been
+ * stored, since nothing counts the capabilities, so each thread may only
+ * turn CSPACE_QUOTA bytes into objects over its lifetime. Deleting the
+ * capabilities gives none of it back.
+ *
+ * All cptrs are decoded to their full 64 bits, and every call returns 0
+ * or a negative error in x0.
+ */
+
+#include <linux/kernel.h>
+#include <linux/channel.h>
+#include <linux/cnode.h>
+#include <linux/errno.h>
+#include <linux/ipc.h>
+#include <linux/mmzone.h>
+#include <linux/notification.h>
+#include <linux/sched.h>
+
+#include <asm/page.h>
+#include <asm/ptrace.h>
+
+/* Take @size bytes from the current thread's quota */
+static int cap_charge(unsigned long size)
+{
+	struct cspace *cs = &current->cspace;
+
+	if (size > cs->quota)
+		return -EDQUOT;
+
+	cs->quota -= size;
+	return 0;
+}
+
+/* Give back a charge for an object that was never made visible */
+static void cap_uncharge(unsigned long size)
+{
+	current->cspace.quota += size;
+}
+
+static int cap_create_endpoint(u64 cptr)
+{
+	struct endpoint *ep;
+	struct cap cap;
+	int ret;
+
+	ret = cap_charge(sizeof(*ep));
+	if (ret)
+		return ret;
+
+	ep = endpoint_create();
+	if (!ep) {
+		ret = -ENOMEM;
+		goto uncharge;
+	}
+
+	cap_endpoint_init(&cap, ep, CAP_RIGHTS_ALL, 0);
+	ret = cspace_insert(&current->cspace, cptr, 64, &cap);
+	if (!ret)
+		return 0;
+
+	endpoint_destroy(ep);
+uncharge:
+	cap_uncharge(sizeof(*ep));
+	return ret;
+}
+
+static int cap_create_notification(u64 cptr)
+{
+	struct notification *ntfn;
+	struct cap cap;
+	int ret;
+
+	ret = cap_charge(sizeof(*ntfn));
+	if (ret)
+		return ret;
+
+	ntfn = notification_create();
+	if (!ntfn) {
+		ret = -ENOMEM;
+		goto uncharge;
+	}
+
+	cap_notification_init(&cap, ntfn, CAP_RIGHTS_ALL, 0);
+	ret = cspace_insert(&current->cspace, cptr, 64, &cap);
+	if (!ret)
+		return 0;
+
+	notification_destroy(ntfn);
+uncharge:
+	cap_uncharge(sizeof(*ntfn));
+	return ret;
+}
+
+static int cap_create_cnode(u64 cptr, u64 radix_bits, u64 guard_bits)
+{
+	struct cnode *cnode;
+	unsigned long size;
+	struct cap cap;
+	int ret;
+
+	if (radix_bits < CNODE_MIN_RADIX_BITS ||
+	    radix_bits > CNODE_MAX_RADIX_BITS ||
+	    guard_bits > 64 - radix_bits)
+		return -EINVAL;
+
+	size = sizeof(*cnode) + (sizeof(struct cap) << radix_bits);
+	ret = cap_charge(size);
+	if (ret)
+		return ret;
+
+	cnode = cnode_create(radix_bits);
+	if (!cnode) {
+		ret = -ENOMEM;
+		goto uncharge;
+	}
+
+	cap_cnode_init(&cap, cnode, guard_bits, 0);
+	ret = cspace_insert(&current->cspace, cptr, 64, &cap);
+	if (!ret)
+		return 0;
+
+	cnode_destroy(cnode);
+uncharge:
+	cap_uncharge(size);
+	return ret;
+}
+
+/* The producer capability goes to @cptr, the consumer one to @consumer */
+static int cap_create_channel(u64 cptr, u64 order, u64 consumer)
+{
+	struct channel *ch;
+	unsigned long size;
+	struct cap cap;
+	int ret;
+
+	if (order > CHANNEL_MAX_ORDER)
+		return -EINVAL;
+
+	size = sizeof(*ch) +
+	       ((CHANNEL_CTRL_PAGES + (1UL << order)) << PAGE_SHIFT);
+	ret = cap_charge(size);
+	if (ret)
+		return ret;
+
+	ch = channel_create(order);
+	if (!ch) {
+		cap_uncharge(size);
+		return -ENOMEM;
+	}
+
+	cap_channel_init(&cap, ch, CAP_RIGHT_SEND);
+	ret = cspace_insert(&current->cspace, cptr, 64, &cap);
+	if (ret) {
+		channel_destroy(ch);
+		cap_uncharge(size);
+		return ret;
+	}
+
+	cap_channel_init(&cap, ch, CAP_RIGHT_RECV);
+	ret = cspace_insert(&current->cspace, consumer, 64, &cap);
+	if (ret) {
+		/*
+		 * The producer capability was visible for a moment and may
+		 * have been copied, so the channel cannot be freed; like
+		 * any object whose capabilities are deleted, it leaks,
+		 * and stays charged.
+		 */
+		cspace_delete(&current->cspace, cptr, 64);
+	}
+	return ret;
+}
+
+/**
+ * ipc_cap_create - create an object and store a capability to it
+ * @regs: x0 slot, x2 enum cap_type, x3 and x4 depend on the type
+ *
+ * CAP_CNODE takes the radix bits in x3 and the guard bits in x4, with a
+ * guard of 0. CAP_CHANNEL takes the order of its data pages in x3 and
+ * stores the consumer capability in the slot x4 names. The capability
+ * has all rights; ipc_cap_mint() makes weaker copies. Fails with -EDQUOT
+ * once the object would take the thread over its quota.
+ */
+void ipc_cap_create(struct pt_regs *regs)
+{
+	u64 cptr = regs->regs[IPC_REG_CPTR];
+	u64 arg0 = regs->regs[IPC_REG_MR0 + 1];
+	u64 arg1 = regs->regs[IPC_REG_MR0 + 2];
+	int ret;
+
+	switch (regs->regs[IPC_REG_MR0]) {
+	case CAP_ENDPOINT:
+		ret = cap_create_endpoint(cptr);
+		break;
+	case CAP_NOTIFICATION:
+		ret = cap_create_notification(cptr);
+		break;
+	case CAP_CNODE:
+		ret = cap_create_cnode(cptr, arg0, arg1);
+		break;
+	case CAP_CHANNEL:
+		ret = cap_create_channel(cptr, arg0, arg1);
+		break;
+	default:
+		ret = -EINVAL;
+	}
+
+	regs->regs[IPC_REG_CPTR] = ret;
+}
+
+/**
+ * ipc_cap_mint - copy the capability in x0 into the slot in x2
+ * @regs: x3 rights to keep, x4 badge or 0, see cspace_mint()
+ */
+void ipc_cap_mint(struct pt_regs *regs)
+{
+	regs->regs[IPC_REG_CPTR] =
+		cspace_mint(&current->cspace, regs->regs[IPC_REG_MR0], 64,
+			    &current->cspace, regs->regs[IPC_REG_CPTR],
+			    regs->regs[IPC_REG_MR0 + 1],
+			    regs->regs[IPC_REG_MR0 + 2]);
+}
+
+/*
+ * Empty the slot in x0. The object it referred to is not freed, and its
+ * size is not returned to the quota.
+ */
+void ipc_cap_delete(struct pt_regs *regs)
+{
+	regs->regs[IPC_REG_CPTR] =
+		cspace_delete(&current->cspace, regs->regs[IPC_REG_CPTR], 64);
+}
@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Shared-memory ring channels
+ *
+ * The kernel sets a channel up and maps it, and after that stays out of
+ * the data path: the two sides move data through the shared pages and
+ * only enter the kernel to ring a doorbell the other side asked for.
+ *
+ * A side that is going to wait stores its waiting flag and then loads the
+ * other side's index. A side that has published its index loads the
+ * other side's waiting flag. Both need a full barrier between their store
+ * and load, which user space provides; then either the waiter sees the new
+ * index or the notifier sees the flag. channel_notify() clears the flag
+ * with an exchange, so two notifies racing for one wait signal once.
+ */
+
+#include <linux/kernel.h>
+#include <linux/channel.h>
+#include <linux/cnode.h>
+#include <linux/errno.h>
+#include <linux/gfp.h>
+#include <linux/init.h>
+#include <linux/ipc.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/notification.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#include <asm/pgtable.h>
+#include <asm/ptrace.h>
+
+static struct kmem_cache *channel_cachep;
+
+/**
+ * channel_create - create a channel with an empty ring
+ * @order: log2 of the number of data pages
+ *
+ * Return: the channel, or NULL if @order is too large or there is no
+ * memory.
+ */
+struct channel *channel_create(unsigned int order)
+{
+	struct channel *ch;
+	int side;
+
+	if (order > CHANNEL_MAX_ORDER)
+		return NULL;
+
+	ch = kmem_cache_zalloc(channel_cachep, GFP_KERNEL);
+	if (!ch)
+		return NULL;
+
+	ch->ctrl_pages = alloc_pages(GFP_KERNEL | __GFP_ZERO,
+				     ilog2(CHANNEL_CTRL_PAGES));
+	if (!ch->ctrl_pages)
+		goto free_channel;
+
+	ch->data_pages = alloc_pages(GFP_KERNEL | __GFP_ZERO, order);
+	if (!ch->data_pages)
+		goto free_ctrl;
+
+	ch->order = order;
+	for (side = 0; side < CHANNEL_SIDES; side++)
+		ch->ctrl[side] = page_to_virt(ch->ctrl_pages + side);
+	raw_spin_lock_init(&ch->lock);
+	return ch;
+
+free_ctrl:
+	__free_pages(ch->ctrl_pages, ilog2(CHANNEL_CTRL_PAGES));
+free_channel:
+	kmem_cache_free(channel_cachep, ch);
+	return NULL;
+}
+
+/* Free a channel no capability refers to and neither side has mapped */
+void channel_destroy(struct channel *ch)
+{
+	__free_pages(ch->data_pages, ch->order);
+	__free_pages(ch->ctrl_pages, ilog2(CHANNEL_CTRL_PAGES));
+	kmem_cache_free(channel_cachep, ch);
+}
+
+/**
+ * channel_set_doorbell - choose how a side is woken
+ * @ch: the channel
+ * @side: the side to be woken
+ * @ntfn: the notification it waits on, or NULL for none
+ * @badge: bits to signal @ntfn with
+ */
+void channel_set_doorbell(struct channel *ch, enum channel_side side,
+			  struct notification *ntfn, u64 badge)
+{
+	raw_spin_lock(&ch->lock);
+	WRITE_ONCE(ch->doorbell[side], NULL);
+	smp_wmb();
+	WRITE_ONCE(ch->badge[side], badge);
+	smp_store_release(&ch->doorbell[side], ntfn);
+	raw_spin_unlock(&ch->lock);
+}
+
+/**
+ * channel_map - map one side of a channel into an address space
+ * @ch: the channel
+ * @side: the side to map
+ * @mm: the address space
+ * @addr: page aligned address for the first control page
+ *
+ * Each side can be mapped once, into channel_map_size() bytes that must
+ * not be mapped yet.
+ *
+ * Return: 0, -EBUSY if @side is already mapped or part of the range is in
+ * use, -EINVAL for a bad address, or -ENOMEM.
+ */
+int channel_map(struct channel *ch, enum channel_side side,
+		struct mm_struct *mm, u64 addr)
+{
+	u64 ctrl_pfn = page_to_pfn(ch->ctrl_pages);
+	u64 data_addr = addr + CHANNEL_CTRL_PAGES * PAGE_SIZE;
+	int ret = 0;
+	int i;
+
+	raw_spin_lock(&ch->lock);
+	if (ch->mm[side]) {
+		ret = -EBUSY;
+	} else {
+		ch->mm[side] = mm;
+		ch->vaddr[side] = addr;
+	}
+	raw_spin_unlock(&ch->lock);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < CHANNEL_CTRL_PAGES; i++) {
+		ret = map_user_pfn_range(mm, addr + i * PAGE_SIZE, ctrl_pfn + i,
+					 PAGE_SIZE, i == side ? PAGE_SHARED :
+								PAGE_READONLY);
+		if (ret)
+			goto unmap;
+	}
+
+	ret = map_user_pfn_range(mm, data_addr, page_to_pfn(ch->data_pages),
+				 channel_data_size(ch),
+				 side == CHANNEL_PRODUCER ? PAGE_SHARED :
+							    PAGE_READONLY);
+	if (!ret)
+		return 0;
+
+unmap:
+	if (i)
+		unmap_user_range(mm, addr, i * PAGE_SIZE);
+
+	raw_spin_lock(&ch->lock);
+	ch->mm[side] = NULL;
+	raw_spin_unlock(&ch->lock);
+	return ret;
+}
+
+/**
+ * channel_unmap - remove one side of a channel from its address space
+ * @ch: the channel
+ * @side: the side to unmap, which need not be mapped
+ */
+void channel_unmap(struct channel *ch, enum channel_side side)
+{
+	struct mm_struct *mm;
+	u64 addr;
+
+	raw_spin_lock(&ch->lock);
+	mm = ch->mm[side];
+	addr = ch->vaddr[side];
+	ch->mm[side] = NULL;
+	raw_spin_unlock(&ch->lock);
+
+	if (mm)
+		unmap_user_range(mm, addr, channel_map_size(ch));
+}
+
+/**
+ * channel_notify - wake the other side if it is waiting
+ * @ch: the channel
+ * @side: the side that published new work
+ */
+void channel_notify(struct channel *ch, enum channel_side side)
+{
+	enum channel_side peer = side ^ 1;
+	struct channel_ctrl *ctrl = ch->ctrl[peer];
+	struct notification *ntfn;
+
+	if (!READ_ONCE(ctrl->waiting) || !xchg(&ctrl->waiting, 0))
+		return;
+
+	ntfn = smp_load_acquire(&ch->doorbell[peer]);
+	if (ntfn)
+		notification_signal(ntfn, READ_ONCE(ch->badge[peer]));
+}
+
+/* A channel capability grants exactly one of send and receive */
+static struct channel *ipc_lookup_channel(u64 cptr, enum channel_side *side)
+{
+	struct cap *slot = cspace_lookup(&current->cspace, cptr);
+	struct cap cap;
+
+	if (!slot)
+		return NULL;
+
+	cap_load(slot, &cap);
+	if (cap.type != CAP_CHANNEL)
+		return NULL;
+
+	switch (cap.rights & (CAP_RIGHT_SEND | CAP_RIGHT_RECV)) {
+	case CAP_RIGHT_SEND:
+		*side = CHANNEL_PRODUCER;
+		break;
+	case CAP_RIGHT_RECV:
+		*side = CHANNEL_CONSUMER;
+		break;
+	default:
+		return NULL;
+	}
+	return cap.obj;
+}
+
+/*
+ * Map the side of the channel in x0 at the address in x2. Returns 0 or a
+ * negative error in x0, and the size of the data area in x1.
+ */
+void ipc_channel_map(struct pt_regs *regs)
+{
+	enum channel_side side;
+	struct channel *ch;
+	long ret = -EINVAL;
+
+	ch = ipc_lookup_channel(regs->regs[IPC_REG_CPTR], &side);
+	if (ch && current->mm)
+		ret = channel_map(ch, side, current->mm,
+				  regs->regs[IPC_REG_MR0]);
+
+	regs->regs[IPC_REG_INFO] = ret ? 0 : channel_data_size(ch);
+	regs->regs[IPC_REG_CPTR] = ret;
+}
+
+/*
+ * Ring the notification in x2 to wake the side of the channel in x0, or
+ * stop waking it if x2 names none.
+ */
+void ipc_channel_set_doorbell(struct pt_regs *regs)
+{
+	struct notification *ntfn;
+	enum channel_side side;
+	struct channel *ch;
+	u64 badge = 0;
+
+	ch = ipc_lookup_channel(regs->regs[IPC_REG_CPTR], &side);
+	if (!ch)
+		return;
+
+	ntfn = ipc_lookup_notification(regs->regs[IPC_REG_MR0],
+				       CAP_RIGHT_SEND, &badge);
+	channel_set_doorbell(ch, side, ntfn, badge);
+}
+
+/* The side of the channel in x0 has published work: wake the other side */
+void ipc_channel_notify(struct pt_regs *regs)
+{
+	enum channel_side side;
+	struct channel *ch;
+
+	ch = ipc_lookup_channel(regs->regs[IPC_REG_CPTR], &side);
+	if (ch)
+		channel_notify(ch, side);
+}
+
+void __init channel_init(void)
+{
+	channel_cachep = KMEM_CACHE(channel, SLAB_HWCACHE_ALIGN | SLAB_PANIC);
+}
@@ -0,0 +1,375 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Endpoint IPC, slow path
+ *
+ * Everything the fast path in fastpath.c declines ends up here: messages
+ * longer than the message registers, sends and receives that have to
+ * block, non-blocking sends, plain replies and page faults. Blocking goes
+ * through the scheduler; the fast path never does.
+ *
+ * An endpoint's queue and state, and the IPC state of the threads on the
+ * queue, are protected by the endpoint's lock. A thread blocked on reply
+ * is on no queue. It belongs to the thread holding its reply right, the
+ * one whose ipc.caller points at it.
+ *
+ * Every change to who is calling whom, or to the senders queued on an
+ * endpoint, is followed by a priority update, see prio.c, once the
+ * endpoint is unlocked.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cnode.h>
+#include <linux/init.h>
+#include <linux/ipc.h>
+#include <linux/list.h>
+#include <linux/sched.h>
+#include <linux/sched/task_stack.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#include <asm/ptrace.h>
+
+static struct kmem_cache *endpoint_cachep;
+
+/**
+ * endpoint_create - create an endpoint
+ *
+ * The caller makes it reachable by storing a capability to it, see
+ * cap_endpoint_init().
+ *
+ * Return: the endpoint, or NULL if there is no memory.
+ */
+struct endpoint *endpoint_create(void)
+{
+	struct endpoint *ep;
+
+	ep = kmem_cache_alloc(endpoint_cachep, GFP_KERNEL);
+	if (!ep)
+		return NULL;
+
+	raw_spin_lock_init(&ep->lock);
+	ep->state = EP_IDLE;
+	INIT_LIST_HEAD(&ep->queue);
+	INIT_LIST_HEAD(&ep->servers);
+	return ep;
+}
+
+/* Free an endpoint no capability refers to and nobody is queued on */
+void endpoint_destroy(struct endpoint *ep)
+{
+	kmem_cache_free(endpoint_cachep, ep);
+}
+
+/**
+ * ipc_lookup_endpoint - find the endpoint a capability pointer names
+ * @cptr: capability pointer passed in x0, decoded in current's cspace
+ * @rights: CAP_RIGHT_* the capability must carry
+ * @badge: set to the badge of the capability
+ *
+ * Return: the endpoint, or NULL if @cptr does not name one with @rights.
+ */
+struct endpoint *ipc_lookup_endpoint(u64 cptr, unsigned int rights,
+				     u64 *badge)
+{
+	struct cap *slot = cspace_lookup(&current->cspace, cptr);
+	struct cap cap;
+
+	if (unlikely(!slot))
+		return NULL;
+
+	cap_load(slot, &cap);
+	if (unlikely(cap.type != CAP_ENDPOINT))
+		return NULL;
+	if (unlikely((cap.rights & rights) != rights))
+		return NULL;
+
+	*badge = cap.data;
+	return cap.obj;
+}
+
+void ipc_thread_init(struct task_struct *tsk)
+{
+	memset(&tsk->ipc, 0, sizeof(tsk->ipc));
+	INIT_LIST_HEAD(&tsk->ipc.ep_link);
+	INIT_LIST_HEAD(&tsk->ipc.serve_link);
+}
+
+/**
+ * ipc_set_buffer - register a thread's IPC buffer
+ * @tsk: the thread
+ * @buffer: kernel mapping of the buffer
+ * @uaddr: where the thread sees it
+ *
+ * Without a buffer a thread can only exchange messages that fit in the
+ * message registers; longer ones are truncated.
+ */
+void ipc_set_buffer(struct task_struct *tsk, struct ipc_buffer *buffer,
+		    u64 uaddr)
+{
+	tsk->ipc.buffer = buffer;
+	tsk->ipc.buffer_uaddr = uaddr;
+}
+
+/*
+ * Copy the first extra capability @src names in its IPC buffer into the
+ * receive slot @dst names in its own. One capability travels per message;
+ * the rest are dropped, as is the first if the receive slot is not free.
+ * Returns the number of capabilities transferred.
+ */
+static unsigned int ipc_transfer_cap(struct task_struct *src,
+				     struct task_struct *dst)
+{
+	struct ipc_buffer *sbuf = src->ipc.buffer;
+	struct ipc_buffer *dbuf = dst->ipc.buffer;
+
+	if (!sbuf || !dbuf)
+		return 0;
+
+	return !cspace_mint(&dst->cspace, READ_ONCE(dbuf->receive_index),
+			    READ_ONCE(dbuf->receive_depth), &src->cspace,
+			    READ_ONCE(sbuf->caps_or_badges[0]),
+			    CAP_RIGHTS_ALL, 0);
+}
+
+/*
+ * Copy the message described by @info from @src to @dst, leaving the
+ * message info and @badge in @dst's x1 and x0. Capabilities go along only
+ * if @grant is set. A thread waiting for its pager sends a fault message
+ * instead of its registers.
+ */
+static void ipc_transfer(struct task_struct *src, struct task_struct *dst,
+			 u64 info, u64 badge, bool grant)
+{
+	struct pt_regs *sregs = task_pt_regs(src);
+	struct pt_regs *dregs = task_pt_regs(dst);
+	unsigned int len = min_t(unsigned int, ipc_msginfo_length(info),
+				 IPC_MSG_MAX_LENGTH);
+	unsigned int caps = 0;
+	unsigned int i;
+
+	if (unlikely(src->ipc.fault.pending)) {
+		ipc_fault_message(src, dst, badge);
+		return;
+	}
+
+	for (i = 0; i < min_t(unsigned int, len, IPC_MSG_REGS); i++)
+		dregs->regs[IPC_REG_MR0 + i] = sregs->regs[IPC_REG_MR0 + i];
+
+	if (len > IPC_MSG_REGS) {
+		if (src->ipc.buffer && dst->ipc.buffer)
+			memcpy(&dst->ipc.buffer->msg[IPC_MSG_REGS],
+			       &src->ipc.buffer->msg[IPC_MSG_REGS],
+			       (len - IPC_MSG_REGS) * sizeof(u64));
+		else
+			len = IPC_MSG_REGS;
+	}
+
+	if (grant && ipc_msginfo_extra_caps(info))
+		caps = ipc_transfer_cap(src, dst);
+
+	dregs->regs[IPC_REG_INFO] = ipc_msginfo(ipc_msginfo_label(info), 0,
+						caps, len);
+	dregs->regs[IPC_REG_BADGE] = badge;
+}
+
+static void ipc_block(struct endpoint *ep, unsigned int state,
+		      unsigned int ep_state)
+{
+	current->ipc.state = state;
+	current->ipc.ep = ep;
+	if (ep_state == EP_SEND)
+		ipc_enqueue_sender(ep, current);
+	else
+		list_add_tail(&current->ipc.ep_link, &ep->queue);
+	ep->state = ep_state;
+	set_current_state(TASK_INTERRUPTIBLE);
+}
+
+/* Take the first thread off @ep's queue. Called with ep->lock held. */
+static struct task_struct *ipc_dequeue(struct endpoint *ep)
+{
+	struct task_struct *tsk;
+
+	tsk = list_first_entry(&ep->queue, struct task_struct, ipc.ep_link);
+	list_del_init(&tsk->ipc.ep_link);
+	tsk->ipc.ep = NULL;
+	if (list_empty(&ep->queue))
+		ep->state = EP_IDLE;
+	return tsk;
+}
+
+/**
+ * __ipc_send - send, or call, through an endpoint
+ * @ep: the endpoint
+ * @badge: badge of the capability used
+ * @info: message info; the message is in current's registers
+ * @call: wait for a reply
+ * @blocking: wait for a receiver; if clear the message is dropped when
+ *	nobody is waiting
+ */
+void __ipc_send(struct endpoint *ep, u64 badge, u64 info, bool call,
+		bool blocking)
+{
+	struct task_struct *dest;
+
+	raw_spin_lock(&ep->lock);
+	if (ep->state != EP_RECV) {
+		if (blocking) {
+			current->ipc.badge = badge;
+			current->ipc.do_call = call;
+			ipc_block(ep, IPC_BLOCKED_ON_SEND, EP_SEND);
+		}
+		raw_spin_unlock(&ep->lock);
+		if (blocking) {
+			ipc_prio_inherit(current);
+			schedule();
+		}
+		return;
+	}
+
+	dest = ipc_dequeue(ep);
+	ipc_serve(dest, ep);
+	raw_spin_unlock(&ep->lock);
+
+	ipc_transfer(current, dest, info, badge, true);
+	dest->ipc.state = IPC_RUNNING;
+
+	if (call) {
+		dest->ipc.caller = current;
+		current->ipc.server = dest;
+		current->ipc.state = IPC_BLOCKED_ON_REPLY;
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	ipc_prio_update(dest);
+	wake_up_process(dest);
+	if (call)
+		schedule();
+}
+
+/**
+ * ipc_send - send, or call, through the endpoint in x0
+ * @regs: the sender's registers
+ * @call: wait for a reply
+ * @blocking: wait for a receiver
+ *
+ * A message that carries a capability needs CAP_RIGHT_GRANT as well.
+ */
+void ipc_send(struct pt_regs *regs, bool call, bool blocking)
+{
+	u64 info = regs->regs[IPC_REG_INFO];
+	unsigned int rights = CAP_RIGHT_SEND;
+	struct endpoint *ep;
+	u64 badge;
+
+	if (ipc_msginfo_extra_caps(info))
+		rights |= CAP_RIGHT_GRANT;
+
+	ep = ipc_lookup_endpoint(regs->regs[IPC_REG_CPTR], rights, &badge);
+	if (ep)
+		__ipc_send(ep, badge, info, call, blocking);
+}
+
+/**
+ * ipc_recv - receive from the endpoint in x0
+ * @regs: the receiver's registers, which get the message
+ */
+void ipc_recv(struct pt_regs *regs)
+{
+	struct task_struct *src;
+	struct endpoint *ep;
+	u64 badge;
+
+	ep = ipc_lookup_endpoint(regs->regs[IPC_REG_CPTR], CAP_RIGHT_RECV,
+				 &badge);
+	if (!ep)
+		return;
+
+	ipc_unserve(current);
+
+	raw_spin_lock(&ep->lock);
+	if (ep->state != EP_SEND) {
+		ipc_block(ep, IPC_BLOCKED_ON_RECV, EP_RECV);
+		raw_spin_unlock(&ep->lock);
+		ipc_prio_update(current);
+		schedule();
+		return;
+	}
+
+	src = ipc_dequeue(ep);
+	ipc_serve(current, ep);
+	raw_spin_unlock(&ep->lock);
+
+	ipc_transfer(src, current, task_pt_regs(src)->regs[IPC_REG_INFO],
+		     src->ipc.badge, true);
+
+	if (src->ipc.do_call) {
+		/* Stays asleep, now waiting for our reply */
+		src->ipc.state = IPC_BLOCKED_ON_REPLY;
+		src->ipc.server = current;
+		current->ipc.caller = src;
+	} else {
+		src->ipc.state = IPC_RUNNING;
+		wake_up_process(src);
+	}
+
+	/* The first sender has changed, and we may have a caller now */
+	ipc_prio_update_servers(ep);
+}
+
+/**
+ * ipc_reply - answer the last call received
+ * @regs: the replier's registers
+ *
+ * Does nothing if there is no caller to answer.
+ */
+void ipc_reply(struct pt_regs *regs)
+{
+	struct task_struct *caller = current->ipc.caller;
+
+	if (!caller)
+		return;
+
+	current->ipc.caller = NULL;
+	caller->ipc.server = NULL;
+	ipc_prio_update(current);
+	if (WARN_ON(caller->ipc.state != IPC_BLOCKED_ON_REPLY))
+		return;
+
+	if (unlikely(caller->ipc.fault.pending)) {
+		ipc_fault_reply(current, caller, regs->regs[IPC_REG_INFO]);
+		return;
+	}
+
+	/* Replies carry no capabilities */
+	ipc_transfer(current, caller, regs->regs[IPC_REG_INFO], 0, false);
+	caller->ipc.state = IPC_RUNNING;
+	wake_up_process(caller);
+}
+
+void ipc_reply_recv(struct pt_regs *regs)
+{
+	ipc_reply(regs);
+	ipc_recv(regs);
+}
+
+/**
+ * ipc_thread_exit - detach the current thread from IPC before it exits
+ *
+ * A running thread is on no endpoint queue and blocked on no reply. A
+ * call it was serving is answered with an empty message, and it stops
+ * serving its endpoint, so that no other thread refers to it any more.
+ */
+void ipc_thread_exit(void)
+{
+	struct pt_regs *regs = task_pt_regs(current);
+
+	regs->regs[IPC_REG_INFO] = 0;
+	ipc_reply(regs);
+	ipc_unserve(current);
+}
+
+void __init ipc_init(void)
+{
+	endpoint_cachep = KMEM_CACHE(endpoint, SLAB_HWCACHE_ALIGN | SLAB_PANIC);
+}
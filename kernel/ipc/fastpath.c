@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Endpoint IPC fast path
+ *
+ * The common shape of client/server traffic is a client calling a server
+ * that is already waiting in reply_recv, and the server answering while
+ * the client waits for the reply. In both cases the thread on the other
+ * side is blocked and ready, so the whole operation is: check that
+ * nothing unusual is going on, move up to four message registers, and
+ * switch to the other thread. Neither side touches the runqueue: the
+ * sender becomes blocked and the receiver runs in its place, so the
+ * scheduler has nothing to decide as long as nothing queued is more
+ * important than the receiver. A called server runs at its caller's
+ * priority if that is better, and goes back to its own on reply_recv.
+ *
+ * Every check that fails sends the syscall to the slow path in
+ * endpoint.c, which handles the general case; the fast path must leave
+ * no state behind when it bails out.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cnode.h>
+#include <linux/ipc.h>
+#include <linux/list.h>
+#include <linux/sched.h>
+#include <linux/sched/task_stack.h>
+#include <linux/spinlock.h>
+
+#include <asm/ptrace.h>
+
+/*
+ * The slow path would also just switch to @dest, running at @prio, here;
+ * anything that might make it choose differently is checked in the slow
+ * path instead.
+ */
+static inline bool fastpath_can_switch(struct task_struct *dest,
+				       unsigned int prio)
+{
+	/* Kernel threads do not receive messages from user space */
+	if (unlikely(!dest->mm))
+		return false;
+
+	/* Something queued must not be waiting behind @dest */
+	return sched_may_switch(prio);
+}
+
+/* Short messages: registers only, no capabilities */
+static inline bool fastpath_msginfo_ok(u64 info)
+{
+	return ipc_msginfo_length(info) <= IPC_MSG_REGS &&
+	       !ipc_msginfo_extra_caps(info);
+}
+
+static __always_inline void fastpath_copy_mrs(struct pt_regs *src,
+					      struct pt_regs *dst,
+					      u64 info, u64 badge)
+{
+	unsigned int len = ipc_msginfo_length(info);
+
+	/* Only what was sent: stale registers must not leak to @dst */
+	switch (len) {
+	case 4:
+		dst->regs[IPC_REG_MR0 + 3] = src->regs[IPC_REG_MR0 + 3];
+		/* fall through */
+	case 3:
+		dst->regs[IPC_REG_MR0 + 2] = src->regs[IPC_REG_MR0 + 2];
+		/* fall through */
+	case 2:
+		dst->regs[IPC_REG_MR0 + 1] = src->regs[IPC_REG_MR0 + 1];
+		/* fall through */
+	case 1:
+		dst->regs[IPC_REG_MR0] = src->regs[IPC_REG_MR0];
+	}
+
+	dst->regs[IPC_REG_INFO] = ipc_msginfo(ipc_msginfo_label(info), 0, 0,
+					      len);
+	dst->regs[IPC_REG_BADGE] = badge;
+}
+
+/**
+ * ipc_fastpath_call - call through an endpoint a server is waiting on
+ * @regs: the caller's registers
+ *
+ * Returns once the reply has been delivered into @regs.
+ */
+void ipc_fastpath_call(struct pt_regs *regs)
+{
+	u64 info = regs->regs[IPC_REG_INFO];
+	struct task_struct *dest;
+	struct endpoint *ep;
+	unsigned int prio;
+	u64 badge;
+
+	if (unlikely(!fastpath_msginfo_ok(info)))
+		goto slowpath;
+
+	ep = ipc_lookup_endpoint(regs->regs[IPC_REG_CPTR], CAP_RIGHT_SEND,
+				 &badge);
+	if (unlikely(!ep))
+		goto slowpath;
+
+	raw_spin_lock(&ep->lock);
+	if (unlikely(ep->state != EP_RECV))
+		goto slowpath_unlock;
+
+	/*
+	 * Waiting to receive, @dest serves nothing, and no sender is queued
+	 * on @ep: it inherits only from us.
+	 */
+	dest = list_first_entry(&ep->queue, struct task_struct, ipc.ep_link);
+	prio = min(dest->static_prio, current->prio);
+	if (unlikely(!fastpath_can_switch(dest, prio)))
+		goto slowpath_unlock;
+
+	/* Point of no return */
+	list_del_init(&dest->ipc.ep_link);
+	if (list_empty(&ep->queue))
+		ep->state = EP_IDLE;
+	ipc_serve(dest, ep);
+	raw_spin_unlock(&ep->lock);
+
+	dest->ipc.ep = NULL;
+	dest->ipc.state = IPC_RUNNING;
+	dest->ipc.caller = current;
+	current->ipc.server = dest;
+	current->ipc.state = IPC_BLOCKED_ON_REPLY;
+	current->state = TASK_INTERRUPTIBLE;
+
+	fastpath_copy_mrs(regs, task_pt_regs(dest), info, badge);
+
+	/* On no runqueue, so nothing to move */
+	dest->prio = prio;
+	dest->state = TASK_RUNNING;
+	sched_switch_to(dest);
+	return;
+
+slowpath_unlock:
+	raw_spin_unlock(&ep->lock);
+slowpath:
+	ipc_send(regs, true, true);
+}
+
+/**
+ * ipc_fastpath_reply_recv - answer the caller and wait for the next one
+ * @regs: the server's registers
+ *
+ * Returns once the next message has been delivered into @regs.
+ */
+void ipc_fastpath_reply_recv(struct pt_regs *regs)
+{
+	u64 info = regs->regs[IPC_REG_INFO];
+	struct task_struct *caller = current->ipc.caller;
+	struct endpoint *ep;
+	u64 badge;
+
+	if (unlikely(!fastpath_msginfo_ok(info)))
+		goto slowpath;
+
+	if (unlikely(!caller || caller->ipc.state != IPC_BLOCKED_ON_REPLY))
+		goto slowpath;
+
+	/* Fault replies are map items, not registers for the caller */
+	if (unlikely(caller->ipc.fault.pending))
+		goto slowpath;
+
+	if (unlikely(!fastpath_can_switch(caller, caller->prio)))
+		goto slowpath;
+
+	ep = ipc_lookup_endpoint(regs->regs[IPC_REG_CPTR], CAP_RIGHT_RECV,
+				 &badge);
+	if (unlikely(!ep))
+		goto slowpath;
+
+	/* Leaving another endpoint means taking its lock as well */
+	if (unlikely(current->ipc.serving && current->ipc.serving != ep))
+		goto slowpath;
+
+	raw_spin_lock(&ep->lock);
+	/* A queued sender has to be received, which is the slow path's job */
+	if (unlikely(ep->state == EP_SEND))
+		goto slowpath_unlock;
+
+	/* Point of no return */
+	if (current->ipc.serving) {
+		list_del_init(&current->ipc.serve_link);
+		current->ipc.serving = NULL;
+	}
+	current->ipc.state = IPC_BLOCKED_ON_RECV;
+	current->ipc.ep = ep;
+	list_add_tail(&current->ipc.ep_link, &ep->queue);
+	ep->state = EP_RECV;
+	raw_spin_unlock(&ep->lock);
+
+	current->ipc.caller = NULL;
+	caller->ipc.server = NULL;
+	/* Serving nothing and called by no one, we inherit nothing */
+	current->prio = current->static_prio;
+	current->state = TASK_INTERRUPTIBLE;
+
+	fastpath_copy_mrs(regs, task_pt_regs(caller), info, 0);
+
+	caller->ipc.state = IPC_RUNNING;
+	caller->state = TASK_RUNNING;
+	sched_switch_to(caller);
+	return;
+
+slowpath_unlock:
+	raw_spin_unlock(&ep->lock);
+slowpath:
+	ipc_reply_recv(regs);
+}
@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Page faults handled by user-space pagers
+ *
+ * The kernel has no idea what should be mapped where. A thread that
+ * faults calls its pager, which decides and answers with the pages to
+ * map. The call is the ordinary slow path with the message made up from
+ * the fault, see ipc_transfer(), and the reply is intercepted before it
+ * reaches the thread's registers, see ipc_reply(). The fast path leaves
+ * faults alone.
+ *
+ * Mapping pages the pager owns is also what gives it the authority to
+ * hand them out: it can only pass on what is mapped in its own address
+ * space, with no more than its own permissions, and the destination
+ * keeps the source's memory attributes.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cnode.h>
+#include <linux/ipc.h>
+#include <linux/mm.h>
+#include <linux/mm_types.h>
+#include <linux/sched.h>
+#include <linux/sched/task_stack.h>
+
+#include <asm/pgtable.h>
+#include <asm/processor.h>
+#include <asm/ptrace.h>
+
+/**
+ * ipc_thread_set_pager - choose where a thread's page faults go
+ * @tsk: the thread
+ * @pager: the endpoint to call, or NULL to make faults fatal
+ * @badge: badge of the fault messages
+ */
+void ipc_thread_set_pager(struct task_struct *tsk, struct endpoint *pager,
+			  u64 badge)
+{
+	tsk->ipc.pager = pager;
+	tsk->ipc.pager_badge = badge;
+}
+
+/* Send current's page faults to the endpoint in x0, or nowhere */
+void ipc_set_pager(struct pt_regs *regs)
+{
+	struct endpoint *ep;
+	u64 badge = 0;
+
+	ep = ipc_lookup_endpoint(regs->regs[IPC_REG_CPTR], CAP_RIGHT_SEND,
+				 &badge);
+	ipc_thread_set_pager(current, ep, badge);
+}
+
+/*
+ * One bit per page of the aligned fault-around window holding @addr,
+ * set if the page is not mapped. The window never spans two last level
+ * tables, so one lookup covers it.
+ */
+static u64 fault_around_unmapped(struct mm_struct *mm, u64 addr)
+{
+	u64 start = addr & ~(IPC_FAULT_AROUND_PAGES * PAGE_SIZE - 1);
+	u64 unmapped = 0;
+	pte_t *ptep;
+	int i;
+
+	BUILD_BUG_ON(IPC_FAULT_AROUND_PAGES > 64);
+	BUILD_BUG_ON(IPC_FAULT_AROUND_PAGES > PTRS_PER_PTE);
+
+	ptep = user_pte_lookup(mm, start);
+	if (!ptep)
+		return ~0ULL;
+
+	for (i = 0; i < IPC_FAULT_AROUND_PAGES; i++)
+		if (pte_none(READ_ONCE(ptep[i])))
+			unmapped |= 1ULL << i;
+	return unmapped;
+}
+
+/**
+ * ipc_fault - hand a user page fault to the thread's pager
+ * @regs: the thread's registers, which are preserved
+ * @addr: faulting address, below TASK_SIZE
+ * @esr: syndrome of the abort
+ *
+ * Returns when the pager has replied, and the thread retries the
+ * faulting instruction. Without a pager the thread is stopped.
+ */
+void ipc_fault(struct pt_regs *regs, u64 addr, unsigned int esr)
+{
+	struct ipc_thread *ipc = &current->ipc;
+
+	if (!ipc->pager || !current->mm) {
+		pr_err("%s[%lld]: unhandled page fault at 0x%016llx (esr 0x%08x), pc 0x%016llx\n",
+		       current->comm, task_pid_nr(current), addr, esr,
+		       regs->pc);
+		current->state = TASK_UNINTERRUPTIBLE;
+		schedule();
+		return;
+	}
+
+	ipc->fault.addr = addr;
+	ipc->fault.pc = regs->pc;
+	ipc->fault.esr = esr;
+	ipc->fault.unmapped = fault_around_unmapped(current->mm, addr);
+	ipc->fault.pending = true;
+
+	__ipc_send(ipc->pager, ipc->pager_badge,
+		   ipc_msginfo(IPC_LABEL_VM_FAULT, 0, 0, IPC_FAULT_MSG_LENGTH),
+		   true, true);
+}
+
+/* Deliver the fault @src is waiting on as a message to @dst */
+void ipc_fault_message(struct task_struct *src, struct task_struct *dst,
+		       u64 badge)
+{
+	const struct ipc_fault *fault = &src->ipc.fault;
+	struct pt_regs *dregs = task_pt_regs(dst);
+
+	dregs->regs[IPC_REG_MR0] = fault->addr;
+	dregs->regs[IPC_REG_MR0 + 1] = fault->pc;
+	dregs->regs[IPC_REG_MR0 + 2] = fault->esr;
+	dregs->regs[IPC_REG_MR0 + 3] = fault->unmapped;
+	dregs->regs[IPC_REG_INFO] = ipc_msginfo(IPC_LABEL_VM_FAULT, 0, 0,
+						IPC_FAULT_MSG_LENGTH);
+	dregs->regs[IPC_REG_BADGE] = badge;
+}
+
+/* Word @i of the message @tsk is sending */
+static u64 ipc_get_mr(struct task_struct *tsk, unsigned int i)
+{
+	if (i < IPC_MSG_REGS)
+		return task_pt_regs(tsk)->regs[IPC_REG_MR0 + i];
+	return tsk->ipc.buffer->msg[i];
+}
+
+/* The pager's permissions, cut down to what the map item asks for */
+static pgprot_t ipc_map_prot(pte_t pte, unsigned int flags)
+{
+	bool write = (flags & IPC_MAP_WRITE) && pte_write(pte);
+	bool exec = (flags & IPC_MAP_EXEC) && pte_user_exec(pte);
+	pgprot_t prot;
+
+	if (write)
+		prot = exec ? PAGE_SHARED_EXEC : PAGE_SHARED;
+	else
+		prot = exec ? PAGE_READONLY_EXEC : PAGE_READONLY;
+
+	return __pgprot_modify(prot, PTE_ATTRINDX_MASK,
+			       pte_val(pte) & PTE_ATTRINDX_MASK);
+}
+
+static void ipc_map_item(struct task_struct *pager, struct task_struct *tsk,
+			 u64 src, u64 dst)
+{
+	unsigned int flags = src & ~PAGE_MASK;
+	u64 nr = (dst & ~PAGE_MASK) + 1;
+
+	src &= PAGE_MASK;
+	dst &= PAGE_MASK;
+
+	for (; nr; nr--, src += PAGE_SIZE, dst += PAGE_SIZE) {
+		pte_t *ptep;
+		pte_t pte;
+
+		if (src >= TASK_SIZE || dst >= TASK_SIZE)
+			break;
+
+		ptep = user_pte_lookup(pager->mm, src);
+		if (!ptep)
+			continue;
+
+		pte = READ_ONCE(*ptep);
+		if (!pte_valid(pte) || !(pte_val(pte) & PTE_USER))
+			continue;
+
+		/* Already mapped pages stay as they are */
+		map_user_pfn_range(tsk->mm, dst, pte_pfn(pte), PAGE_SIZE,
+				   ipc_map_prot(pte, flags));
+	}
+}
+
+/**
+ * ipc_fault_reply - resolve a fault with the pager's reply
+ * @pager: the replying thread
+ * @tsk: the thread that faulted
+ * @info: message info of the reply, whose words are map items
+ */
+void ipc_fault_reply(struct task_struct *pager, struct task_struct *tsk,
+		     u64 info)
+{
+	unsigned int len = min_t(unsigned int, ipc_msginfo_length(info),
+				 IPC_MSG_MAX_LENGTH);
+	unsigned int i;
+
+	tsk->ipc.fault.pending = false;
+	tsk->ipc.state = IPC_RUNNING;
+
+	if (ipc_msginfo_label(info)) {
+		pr_err("%s[%lld]: page fault at 0x%016llx refused by pager\n",
+		       tsk->comm, task_pid_nr(tsk), tsk->ipc.fault.addr);
+		tsk->state = TASK_UNINTERRUPTIBLE;
+		return;
+	}
+
+	if (!pager->mm)
+		len = 0;
+	else if (!pager->ipc.buffer)
+		len = min_t(unsigned int, len, IPC_MSG_REGS);
+
+	for (i = 0; i + IPC_MAP_ITEM_WORDS <= len; i += IPC_MAP_ITEM_WORDS)
+		ipc_map_item(pager, tsk, ipc_get_mr(pager, i),
+			     ipc_get_mr(pager, i + 1));
+
+	wake_up_process(tsk);
+}
@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Notification objects
+ *
+ * Signalling with nobody waiting is a single atomic OR, with no lock.
+ * Only the waiter list is locked. A waiter adds itself to the list and
+ * then takes the word. A signaller ORs into the word and then checks the
+ * list. With a full barrier between the two steps on both sides, either
+ * the waiter finds the bits or the signaller finds the waiter.
+ *
+ * The signaller hands the whole word to the first waiter, so signals
+ * that raced with the wakeup arrive together.
+ */
+
+#include <linux/kernel.h>
+#include <linux/cnode.h>
+#include <linux/errno.h>
+#include <linux/init.h>
+#include <linux/ipc.h>
+#include <linux/irq.h>
+#include <linux/list.h>
+#include <linux/notification.h>
+#include <linux/sched.h>
+#include <linux/sched/task_stack.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+
+#include <asm/ptrace.h>
+
+static struct kmem_cache *notification_cachep;
+
+/**
+ * notification_create - create a notification with no bits pending
+ *
+ * Return: the notification, or NULL if there is no memory.
+ */
+struct notification *notification_create(void)
+{
+	struct notification *ntfn;
+
+	ntfn = kmem_cache_alloc(notification_cachep, GFP_KERNEL);
+	if (!ntfn)
+		return NULL;
+
+	atomic64_set(&ntfn->word, 0);
+	raw_spin_lock_init(&ntfn->lock);
+	INIT_LIST_HEAD(&ntfn->waiters);
+	return ntfn;
+}
+
+/* Free a notification no capability or interrupt refers to */
+void notification_destroy(struct notification *ntfn)
+{
+	kmem_cache_free(notification_cachep, ntfn);
+}
+
+/**
+ * notification_signal - set bits in a notification
+ * @ntfn: the notification
+ * @badge: bits to set
+ *
+ * Safe from interrupt context. If a thread is waiting it gets all bits
+ * pending and is woken.
+ */
+void notification_signal(struct notification *ntfn, u64 badge)
+{
+	struct task_struct *waiter;
+	u64 flags, bits;
+
+	atomic64_or(badge, &ntfn->word);
+	smp_mb__after_atomic();
+
+	if (list_empty(&ntfn->waiters))
+		return;
+
+	raw_spin_lock_irqsave(&ntfn->lock, flags);
+	if (list_empty(&ntfn->waiters))
+		goto unlock;
+
+	/* The waiter may have found the bits itself */
+	bits = atomic64_xchg(&ntfn->word, 0);
+	if (!bits)
+		goto unlock;
+
+	waiter = list_first_entry(&ntfn->waiters, struct task_struct,
+				  ipc.ep_link);
+	list_del_init(&waiter->ipc.ep_link);
+	waiter->ipc.state = IPC_RUNNING;
+	task_pt_regs(waiter)->regs[IPC_REG_BADGE] = bits;
+	wake_up_process(waiter);
+unlock:
+	raw_spin_unlock_irqrestore(&ntfn->lock, flags);
+}
+
+/**
+ * notification_poll - take the pending bits without blocking
+ * @ntfn: the notification
+ *
+ * Return: the bits that were pending, possibly none.
+ */
+u64 notification_poll(struct notification *ntfn)
+{
+	return atomic64_xchg(&ntfn->word, 0);
+}
+
+/*
+ * Return the bits pending on @ntfn, or 0 after queueing current to be
+ * handed them by notification_signal().
+ */
+static u64 notification_wait(struct notification *ntfn)
+{
+	u64 flags, bits;
+
+	bits = atomic64_xchg(&ntfn->word, 0);
+	if (bits)
+		return bits;
+
+	raw_spin_lock_irqsave(&ntfn->lock, flags);
+	list_add_tail(&current->ipc.ep_link, &ntfn->waiters);
+	current->ipc.state = IPC_BLOCKED_ON_NOTIFICATION;
+	set_current_state(TASK_INTERRUPTIBLE);
+
+	bits = atomic64_xchg(&ntfn->word, 0);
+	if (bits) {
+		list_del_init(&current->ipc.ep_link);
+		current->ipc.state = IPC_RUNNING;
+		current->state = TASK_RUNNING;
+	}
+	raw_spin_unlock_irqrestore(&ntfn->lock, flags);
+
+	return bits;
+}
+
+/*
+ * Find the notification @cptr names, if the capability has @rights, and
+ * the badge it signals with. A capability with no badge would signal no
+ * bits and wake nobody, so it does not count as having CAP_RIGHT_SEND.
+ */
+struct notification *ipc_lookup_notification(u64 cptr, unsigned int rights,
+					     u64 *badge)
+{
+	struct cap *slot = cspace_lookup(&current->cspace, cptr);
+	struct cap cap;
+
+	if (!slot)
+		return NULL;
+
+	cap_load(slot, &cap);
+	if (cap.type != CAP_NOTIFICATION)
+		return NULL;
+	if ((cap.rights & rights) != rights)
+		return NULL;
+	if ((rights & CAP_RIGHT_SEND) && !cap.data)
+		return NULL;
+
+	*badge = cap.data;
+	return cap.obj;
+}
+
+static bool ipc_lookup_irq(u64 cptr, unsigned int *irq)
+{
+	struct cap *slot = cspace_lookup(&current->cspace, cptr);
+	struct cap cap;
+
+	if (!slot)
+		return false;
+
+	cap_load(slot, &cap);
+	if (cap.type != CAP_IRQ_HANDLER)
+		return false;
+
+	*irq = cap.data;
+	return true;
+}
+
+/*
+ * Signal the notification in x0 with the badge of that capability.
+ * Returns 0 in x0, or -EINVAL if x0 names no badged notification
+ * capability with CAP_RIGHT_SEND.
+ */
+void ipc_signal(struct pt_regs *regs)
+{
+	struct notification *ntfn;
+	u64 badge;
+
+	ntfn = ipc_lookup_notification(regs->regs[IPC_REG_CPTR],
+				       CAP_RIGHT_SEND, &badge);
+	if (!ntfn) {
+		regs->regs[IPC_REG_CPTR] = -EINVAL;
+		return;
+	}
+
+	notification_signal(ntfn, badge);
+	regs->regs[IPC_REG_CPTR] = 0;
+}
+
+/* Wait on the notification in x0; the bits taken are returned in x0 */
+void ipc_wait(struct pt_regs *regs)
+{
+	struct notification *ntfn;
+	u64 badge, bits;
+
+	ntfn = ipc_lookup_notification(regs->regs[IPC_REG_CPTR],
+				       CAP_RIGHT_RECV, &badge);
+	if (!ntfn) {
+		regs->regs[IPC_REG_BADGE] = 0;
+		return;
+	}
+
+	bits = notification_wait(ntfn);
+	if (bits) {
+		regs->regs[IPC_REG_BADGE] = bits;
+		return;
+	}
+
+	/* notification_signal() fills in x0 */
+	schedule();
+}
+
+void ipc_poll(struct pt_regs *regs)
+{
+	struct notification *ntfn;
+	u64 badge;
+
+	ntfn = ipc_lookup_notification(regs->regs[IPC_REG_CPTR],
+				       CAP_RIGHT_RECV, &badge);
+	regs->regs[IPC_REG_BADGE] = ntfn ? notification_poll(ntfn) : 0;
+}
+
+/*
+ * Deliver the interrupt named by the IRQ handler capability in x0 to the
+ * notification in x2, or stop delivering it if x2 names none.
+ */
+void ipc_irq_set_notification(struct pt_regs *regs)
+{
+	struct notification *ntfn;
+	unsigned int irq;
+	u64 badge;
+
+	if (!ipc_lookup_irq(regs->regs[IPC_REG_CPTR], &irq))
+		return;
+
+	ntfn = ipc_lookup_notification(regs->regs[IPC_REG_MR0],
+				       CAP_RIGHT_SEND, &badge);
+	if (ntfn)
+		irq_bind_notification(irq, ntfn, badge);
+	else
+		irq_unbind_notification(irq);
+}
+
+/* The handler is done with the interrupt in x0: let it fire again */
+void ipc_irq_ack(struct pt_regs *regs)
+{
+	unsigned int irq;
+
+	if (ipc_lookup_irq(regs->regs[IPC_REG_CPTR], &irq))
+		irq_ack(irq);
+}
+
+void __init notification_init(void)
+{
+	notification_cachep = KMEM_CACHE(notification,
+					 SLAB_HWCACHE_ALIGN | SLAB_PANIC);
+}
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Priority donation and inheritance through IPC
+ *
+ * A call hands the caller's priority to the server along with the
+ * message, and the server keeps it until it replies. A server also runs
+ * at the priority of the most important sender queued on the endpoint it
+ * serves, since that sender cannot get anywhere until the server is back
+ * in receive. Both pass on down chains of servers: a server blocked
+ * calling another server, or queued on another endpoint, lends what it
+ * has inherited in turn. So a client is never held up behind work less
+ * important than itself just because a server it depends on is.
+ *
+ * The effective priority of a thread is worked out from scratch, see
+ * ipc_inherited_prio(), whenever something it inherits from changes, and
+ * the change is pushed to whatever the thread is blocked on. Walks are
+ * serialised by ipc_prio_lock and take one endpoint lock at a time. They
+ * stop where nothing changes, and after IPC_PRIO_MAX_DEPTH hops, which
+ * also ends walks around the loops that deadlocked services make.
+ *
+ * The fast path does not walk. A call there goes to a thread waiting on
+ * an endpoint no sender is queued on, so the server gets exactly its
+ * caller's priority; a reply_recv there leaves the server inheriting
+ * nothing.
+ */
+
+#include <linux/kernel.h>
+#include <linux/ipc.h>
+#include <linux/list.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+
+#define IPC_PRIO_MAX_DEPTH	8
+#define IPC_PRIO_MAX_SERVERS	4	/* of one endpoint, followed per hop */
+
+static DEFINE_RAW_SPINLOCK(ipc_prio_lock);
+
+static void __ipc_prio_update(struct task_struct *tsk, unsigned int depth);
+
+/**
+ * ipc_serve - note that a thread took a message off an endpoint
+ * @tsk: the receiver, serving no endpoint
+ * @ep: the endpoint, locked
+ *
+ * @tsk serves @ep until it next waits to receive.
+ */
+void ipc_serve(struct task_struct *tsk, struct endpoint *ep)
+{
+	tsk->ipc.serving = ep;
+	list_add_tail(&tsk->ipc.serve_link, &ep->servers);
+}
+
+/**
+ * ipc_unserve - stop serving an endpoint before waiting to receive
+ * @tsk: the thread, which need not be serving one
+ */
+void ipc_unserve(struct task_struct *tsk)
+{
+	struct endpoint *ep = tsk->ipc.serving;
+
+	if (!ep)
+		return;
+
+	raw_spin_lock(&ep->lock);
+	list_del_init(&tsk->ipc.serve_link);
+	tsk->ipc.serving = NULL;
+	raw_spin_unlock(&ep->lock);
+}
+
+/**
+ * ipc_enqueue_sender - queue a sender behind those at least as important
+ * @ep: the endpoint, locked
+ * @tsk: the sender
+ */
+void ipc_enqueue_sender(struct endpoint *ep, struct task_struct *tsk)
+{
+	struct task_struct *pos;
+
+	list_for_each_entry(pos, &ep->queue, ipc.ep_link) {
+		if (pos->prio > tsk->prio) {
+			list_add_tail(&tsk->ipc.ep_link, &pos->ipc.ep_link);
+			return;
+		}
+	}
+	list_add_tail(&tsk->ipc.ep_link, &ep->queue);
+}
+
+/*
+ * The best of @tsk's own priority, its caller's, and that of the first
+ * sender queued on the endpoint it serves.
+ */
+static unsigned int ipc_inherited_prio(struct task_struct *tsk)
+{
+	struct task_struct *caller = READ_ONCE(tsk->ipc.caller);
+	struct endpoint *ep = READ_ONCE(tsk->ipc.serving);
+	unsigned int prio = tsk->static_prio;
+
+	if (caller)
+		prio = min(prio, READ_ONCE(caller->prio));
+
+	if (ep) {
+		raw_spin_lock(&ep->lock);
+		if (ep->state == EP_SEND)
+			prio = min(prio, list_first_entry(&ep->queue,
+							  struct task_struct,
+							  ipc.ep_link)->prio);
+		raw_spin_unlock(&ep->lock);
+	}
+
+	return prio;
+}
+
+static void __ipc_prio_update_servers(struct endpoint *ep, unsigned int depth)
+{
+	struct task_struct *servers[IPC_PRIO_MAX_SERVERS];
+	struct task_struct *tsk;
+	int i, n = 0;
+
+	raw_spin_lock(&ep->lock);
+	list_for_each_entry(tsk, &ep->servers, ipc.serve_link) {
+		if (n == IPC_PRIO_MAX_SERVERS)
+			break;
+		servers[n++] = tsk;
+	}
+	raw_spin_unlock(&ep->lock);
+
+	for (i = 0; i < n; i++)
+		__ipc_prio_update(servers[i], depth);
+}
+
+/* Pass @tsk's priority on to whoever it is blocked on */
+static void __ipc_prio_inherit(struct task_struct *tsk, unsigned int depth)
+{
+	struct endpoint *ep;
+
+	if (++depth > IPC_PRIO_MAX_DEPTH)
+		return;
+
+	switch (tsk->ipc.state) {
+	case IPC_BLOCKED_ON_REPLY:
+		if (tsk->ipc.server)
+			__ipc_prio_update(tsk->ipc.server, depth);
+		break;
+
+	case IPC_BLOCKED_ON_SEND:
+		ep = READ_ONCE(tsk->ipc.ep);
+		if (!ep)
+			break;
+
+		raw_spin_lock(&ep->lock);
+		/* Its place in the queue depends on its priority */
+		if (tsk->ipc.ep == ep &&
+		    tsk->ipc.state == IPC_BLOCKED_ON_SEND) {
+			list_del(&tsk->ipc.ep_link);
+			ipc_enqueue_sender(ep, tsk);
+		}
+		raw_spin_unlock(&ep->lock);
+		__ipc_prio_update_servers(ep, depth);
+		break;
+	}
+}
+
+static void __ipc_prio_update(struct task_struct *tsk, unsigned int depth)
+{
+	unsigned int prio = ipc_inherited_prio(tsk);
+
+	if (prio == tsk->prio)
+		return;
+
+	sched_set_prio(tsk, prio);
+	__ipc_prio_inherit(tsk, depth);
+}
+
+/**
+ * ipc_prio_update - recompute a thread's priority
+ * @tsk: the thread, whose caller, or endpoint served, has changed
+ *
+ * Called with no endpoint locked.
+ */
+void ipc_prio_update(struct task_struct *tsk)
+{
+	raw_spin_lock(&ipc_prio_lock);
+	__ipc_prio_update(tsk, 0);
+	raw_spin_unlock(&ipc_prio_lock);
+}
+
+/**
+ * ipc_prio_update_servers - recompute the priorities of an endpoint's servers
+ * @ep: the endpoint, unlocked, whose first queued sender has changed
+ */
+void ipc_prio_update_servers(struct endpoint *ep)
+{
+	raw_spin_lock(&ipc_prio_lock);
+	__ipc_prio_update_servers(ep, 0);
+	raw_spin_unlock(&ipc_prio_lock);
+}
+
+/**
+ * ipc_prio_inherit - lend a thread's priority to whoever it is blocked on
+ * @tsk: the thread, just blocked on an endpoint or on a reply
+ */
+void ipc_prio_inherit(struct task_struct *tsk)
+{
+	raw_spin_lock(&ipc_prio_lock);
+	__ipc_prio_inherit(tsk, 0);
+	raw_spin_unlock(&ipc_prio_lock);
+}
+
+/**
+ * ipc_thread_set_prio - set a thread's own priority
+ * @tsk: the thread
+ * @prio: its static priority, below MAX_PRIO
+ */
+void ipc_thread_set_prio(struct task_struct *tsk, unsigned int prio)
+{
+	if (WARN_ON(prio >= MAX_PRIO))
+		return;
+
+	raw_spin_lock(&ipc_prio_lock);
+	tsk->static_prio = prio;
+	__ipc_prio_update(tsk, 0);
+	raw_spin_unlock(&ipc_prio_lock);
+}
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Boot time test of IPC priority donation
+ *
+ * Two threads that never run stand in for a client and a server. They
+ * are put in the states the slow path leaves them in, and each step
+ * checks that prio.c gives the server the priority it should have: the
+ * client's while it is queued on the endpoint the server serves, and
+ * while the server holds its reply right; the server's own once it has
+ * replied.
+ */
+
+#define pr_fmt(fmt) "ipc_prio_test: " fmt
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/ipc.h>
+#include <linux/list.h>
+#include <linux/sched.h>
+#include <linux/smp.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#define TEST_SERVER_PRIO	(MAX_PRIO - 1)
+#define TEST_CLIENT_PRIO	1
+
+static struct task_struct test_server __initdata;
+static struct task_struct test_client __initdata;
+
+static unsigned int test_checks __initdata;
+static unsigned int test_failures __initdata;
+
+static void __init test_thread_init(struct task_struct *tsk, const char *name,
+				    unsigned int prio)
+{
+	strlcpy(tsk->comm, name, sizeof(tsk->comm));
+	tsk->state = TASK_INTERRUPTIBLE;
+	tsk->cpu = smp_processor_id();
+	tsk->prio = tsk->static_prio = prio;
+	INIT_LIST_HEAD(&tsk->run_list);
+	ipc_thread_init(tsk);
+}
+
+static void __init test_expect(const char *step, unsigned int prio)
+{
+	test_checks++;
+	if (test_server.prio == prio)
+		return;
+
+	pr_err("%s: server at priority %u, expected %u\n", step,
+	       test_server.prio, prio);
+	test_failures++;
+}
+
+void __init ipc_prio_test(void)
+{
+	struct task_struct *server = &test_server;
+	struct task_struct *client = &test_client;
+	struct endpoint *ep;
+
+	ep = endpoint_create();
+	if (!ep) {
+		pr_err("no memory for the endpoint\n");
+		return;
+	}
+
+	test_thread_init(server, "test_server", TEST_SERVER_PRIO);
+	test_thread_init(client, "test_client", TEST_CLIENT_PRIO);
+
+	/* The server took a message off @ep and serves it */
+	raw_spin_lock(&ep->lock);
+	ipc_serve(server, ep);
+	raw_spin_unlock(&ep->lock);
+	ipc_prio_update(server);
+	test_expect("serving", TEST_SERVER_PRIO);
+
+	/* The client calls while the server is busy, and queues */
+	raw_spin_lock(&ep->lock);
+	client->ipc.state = IPC_BLOCKED_ON_SEND;
+	client->ipc.do_call = true;
+	client->ipc.ep = ep;
+	ipc_enqueue_sender(ep, client);
+	ep->state = EP_SEND;
+	raw_spin_unlock(&ep->lock);
+	ipc_prio_inherit(client);
+	test_expect("queued call", TEST_CLIENT_PRIO);
+
+	/* The server receives the call, see ipc_recv() */
+	ipc_unserve(server);
+	raw_spin_lock(&ep->lock);
+	list_del_init(&client->ipc.ep_link);
+	client->ipc.ep = NULL;
+	ep->state = EP_IDLE;
+	ipc_serve(server, ep);
+	raw_spin_unlock(&ep->lock);
+	client->ipc.state = IPC_BLOCKED_ON_REPLY;
+	client->ipc.server = server;
+	server->ipc.caller = client;
+	ipc_prio_update_servers(ep);
+	test_expect("received call", TEST_CLIENT_PRIO);
+
+	/* A change to the client's priority follows it to the server */
+	ipc_thread_set_prio(client, 0);
+	test_expect("client raised", 0);
+
+	/* The server replies, see ipc_reply() */
+	server->ipc.caller = NULL;
+	client->ipc.server = NULL;
+	client->ipc.state = IPC_RUNNING;
+	ipc_prio_update(server);
+	test_expect("replied", TEST_SERVER_PRIO);
+
+	ipc_unserve(server);
+	endpoint_destroy(ep);
+
+	if (test_failures)
+		pr_err("%u of %u checks failed\n", test_failures,
+		       test_checks);
+	else
+		pr_info("all %u checks passed\n", test_checks);
+}
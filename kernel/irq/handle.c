@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Interrupt delivery to notifications
+ *
+ * The interrupt controller driver calls generic_handle_irq() for each
+ * interrupt it takes, in order, before it signals end of interrupt. All
+ * interrupts pending at one exception are handled in one pass, and each
+ * costs one atomic OR unless its handler is waiting.
+ */
+
+#define pr_fmt(fmt) "irq: " fmt
+
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/irq.h>
+#include <linux/notification.h>
+#include <linux/spinlock.h>
+
+struct irq_desc {
+	struct notification	*ntfn;
+	u64			badge;
+};
+
+static struct irq_desc irq_desc[NR_IRQS];
+static struct irq_chip *irq_chip;
+
+/* Serialises binding; delivery reads the descriptors without it */
+static DEFINE_RAW_SPINLOCK(irq_desc_lock);
+
+void irq_set_chip(struct irq_chip *chip)
+{
+	irq_chip = chip;
+}
+
+/**
+ * generic_handle_irq - deliver an interrupt
+ * @irq: the interrupt that fired
+ *
+ * Called with interrupts masked. The interrupt stays masked until
+ * irq_ack(), or for good if it has no notification bound.
+ *
+ * Return: 0, or -EINVAL if @irq is out of range.
+ */
+int generic_handle_irq(unsigned int irq)
+{
+	struct irq_desc *desc;
+	struct notification *ntfn;
+
+	if (unlikely(irq >= NR_IRQS))
+		return -EINVAL;
+
+	desc = &irq_desc[irq];
+	irq_chip->irq_mask(irq);
+
+	ntfn = READ_ONCE(desc->ntfn);
+	if (likely(ntfn))
+		notification_signal(ntfn, READ_ONCE(desc->badge));
+	else
+		pr_warn("IRQ%u has no handler, masked\n", irq);
+
+	return 0;
+}
+
+/**
+ * irq_bind_notification - deliver an interrupt to a notification
+ * @irq: the interrupt
+ * @ntfn: notification to signal when it fires
+ * @badge: bits to signal it with
+ *
+ * Replaces any earlier binding and unmasks the interrupt.
+ *
+ * Return: 0, or -EINVAL if @irq is out of range.
+ */
+int irq_bind_notification(unsigned int irq, struct notification *ntfn,
+			  u64 badge)
+{
+	struct irq_desc *desc;
+	u64 flags;
+
+	if (irq >= NR_IRQS || !irq_chip)
+		return -EINVAL;
+
+	desc = &irq_desc[irq];
+	raw_spin_lock_irqsave(&irq_desc_lock, flags);
+	WRITE_ONCE(desc->badge, badge);
+	WRITE_ONCE(desc->ntfn, ntfn);
+	irq_chip->irq_unmask(irq);
+	raw_spin_unlock_irqrestore(&irq_desc_lock, flags);
+
+	return 0;
+}
+
+int irq_unbind_notification(unsigned int irq)
+{
+	struct irq_desc *desc;
+	u64 flags;
+
+	if (irq >= NR_IRQS || !irq_chip)
+		return -EINVAL;
+
+	desc = &irq_desc[irq];
+	raw_spin_lock_irqsave(&irq_desc_lock, flags);
+	irq_chip->irq_mask(irq);
+	WRITE_ONCE(desc->ntfn, NULL);
+	raw_spin_unlock_irqrestore(&irq_desc_lock, flags);
+
+	return 0;
+}
+
+/**
+ * irq_ack - the handler is done with an interrupt
+ * @irq: the interrupt
+ *
+ * Return: 0, or -EINVAL if @irq is out of range or not bound.
+ */
+int irq_ack(unsigned int irq)
+{
+	if (irq >= NR_IRQS || !irq_chip || !READ_ONCE(irq_desc[irq].ntfn))
+		return -EINVAL;
+
+	irq_chip->irq_unmask(irq);
+	return 0;
+}
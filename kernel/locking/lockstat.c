@@ -0,0 +1,333 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Lock contention statistics
+ *
+ * Classes live in a fixed table and are never freed; a lock finds its
+ * class by key on first use and caches it in its lockstat_map. Slot 0
+ * collects locks that were never initialised with a name (zeroed memory
+ * is a valid unlocked spinlock) and everything past the end of the table.
+ *
+ * Nothing here may take an instrumented lock: the table is protected by
+ * a bare arch_spinlock_t and the counters are per cpu with interrupts
+ * off.
+ */
+
+#define pr_fmt(fmt) "lockstat: " fmt
+
+#include <linux/kernel.h>
+#include <linux/bitops.h>
+#include <linux/cpumask.h>
+#include <linux/errno.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#include <asm/timex.h>
+
+#define MAX_LOCKSTAT_CLASSES	256
+
+struct lock_class {
+	const void	*key;
+	const char	*name;
+	u64		contention_point[LOCKSTAT_POINTS];
+	u64		contending_point[LOCKSTAT_POINTS];
+};
+
+static struct lock_class lock_classes[MAX_LOCKSTAT_CLASSES] = {
+	[0] = { .name = "<other>" },
+};
+static unsigned int nr_lock_classes = 1;
+static arch_spinlock_t lockstat_lock = __ARCH_SPIN_LOCK_UNLOCKED;
+
+static DEFINE_PER_CPU(struct lock_class_stats[MAX_LOCKSTAT_CLASSES],
+		      cpu_lock_stats);
+
+void lockstat_init_map(struct lockstat_map *map, const char *name,
+		       struct lock_class_key *key)
+{
+	map->name = name;
+	map->key = key;
+	map->class = NULL;
+	map->holder_ip = 0;
+}
+
+void __raw_spin_lock_init(raw_spinlock_t *lock, const char *name,
+			  struct lock_class_key *key)
+{
+	lock->raw_lock = (arch_spinlock_t)__ARCH_SPIN_LOCK_UNLOCKED;
+	lockstat_init_map(&lock->stat_map, name, key);
+}
+
+void __rwlock_init(rwlock_t *lock, const char *name,
+		   struct lock_class_key *key)
+{
+	lock->raw_lock = (arch_rwlock_t)__ARCH_RW_LOCK_UNLOCKED;
+	lockstat_init_map(&lock->stat_map, name, key);
+}
+
+static struct lock_class *register_lock_class(struct lockstat_map *map)
+{
+	struct lock_class *class = &lock_classes[0];
+	unsigned int i;
+
+	if (!map->key)
+		goto out;
+
+	arch_spin_lock(&lockstat_lock);
+	for (i = 1; i < nr_lock_classes; i++) {
+		if (lock_classes[i].key == map->key) {
+			class = &lock_classes[i];
+			goto unlock;
+		}
+	}
+	if (nr_lock_classes < MAX_LOCKSTAT_CLASSES) {
+		class = &lock_classes[nr_lock_classes];
+		class->key = map->key;
+		class->name = map->name;
+		/* lockstat_dump() reads the table without the lock */
+		smp_store_release(&nr_lock_classes, nr_lock_classes + 1);
+	}
+unlock:
+	arch_spin_unlock(&lockstat_lock);
+out:
+	WRITE_ONCE(map->class, class);
+	return class;
+}
+
+static inline struct lock_class *lock_class_of(struct lockstat_map *map)
+{
+	struct lock_class *class = READ_ONCE(map->class);
+
+	if (unlikely(!class))
+		class = register_lock_class(map);
+	return class;
+}
+
+static inline struct lock_class_stats *get_lock_stats(struct lock_class *class)
+{
+	return &this_cpu_ptr(&cpu_lock_stats)[0][class - lock_classes];
+}
+
+/*
+ * Return the slot of @ip in @points, claiming a free one if it is not
+ * there yet, or LOCKSTAT_POINTS if they are all taken by other sites.
+ */
+static int lock_point(u64 *points, u64 ip)
+{
+	int i;
+
+	for (i = 0; i < LOCKSTAT_POINTS; i++) {
+		u64 old = READ_ONCE(points[i]);
+
+		if (old == ip)
+			break;
+		if (!old && (!cmpxchg(&points[i], 0, ip) ||
+			     READ_ONCE(points[i]) == ip))
+			break;
+	}
+	return i;
+}
+
+static inline int wait_bucket(u64 wait)
+{
+	return min(fls64(wait), LOCKSTAT_HIST_BUCKETS - 1);
+}
+
+/**
+ * lock_contended - note that acquiring a lock has to wait
+ * @map: the lock's map
+ * @ip: the call site that is about to wait
+ *
+ * Return: the time the wait started, to be handed to lock_acquired().
+ */
+u64 lock_contended(struct lockstat_map *map, u64 ip)
+{
+	struct lock_class *class = lock_class_of(map);
+	struct lock_class_stats *stats;
+	u64 flags;
+	int point;
+
+	local_irq_save(flags);
+	stats = get_lock_stats(class);
+	stats->contentions++;
+
+	point = lock_point(class->contention_point, ip);
+	if (point < LOCKSTAT_POINTS)
+		stats->contention_point[point]++;
+
+	point = lock_point(class->contending_point, READ_ONCE(map->holder_ip));
+	if (point < LOCKSTAT_POINTS)
+		stats->contending_point[point]++;
+	local_irq_restore(flags);
+
+	return get_cycles() ? : 1;
+}
+
+/**
+ * lock_acquired - note that a lock has been taken
+ * @map: the lock's map
+ * @ip: the call site that took it
+ * @waitstart: what lock_contended() returned, or 0 if there was no wait
+ */
+void lock_acquired(struct lockstat_map *map, u64 ip, u64 waitstart)
+{
+	struct lock_class *class = lock_class_of(map);
+	struct lock_class_stats *stats;
+	u64 flags, wait;
+
+	WRITE_ONCE(map->holder_ip, ip);
+
+	local_irq_save(flags);
+	stats = get_lock_stats(class);
+	stats->acquisitions++;
+	if (waitstart) {
+		wait = get_cycles() - waitstart;
+		stats->wait_total += wait;
+		if (wait > stats->wait_max)
+			stats->wait_max = wait;
+		stats->wait_hist[wait_bucket(wait)]++;
+	}
+	local_irq_restore(flags);
+}
+
+static void lock_class_sum(unsigned int idx, struct lock_class_stats *sum)
+{
+	int cpu, i;
+
+	memset(sum, 0, sizeof(*sum));
+	for_each_possible_cpu(cpu) {
+		struct lock_class_stats *pcs = &per_cpu(cpu_lock_stats, cpu)[idx];
+
+		sum->acquisitions += pcs->acquisitions;
+		sum->contentions += pcs->contentions;
+		sum->wait_total += pcs->wait_total;
+		sum->wait_max = max(sum->wait_max, pcs->wait_max);
+		for (i = 0; i < LOCKSTAT_HIST_BUCKETS; i++)
+			sum->wait_hist[i] += pcs->wait_hist[i];
+		for (i = 0; i < LOCKSTAT_POINTS; i++) {
+			sum->contention_point[i] += pcs->contention_point[i];
+			sum->contending_point[i] += pcs->contending_point[i];
+		}
+	}
+}
+
+/**
+ * lockstat_snapshot - sum the counters of the classes called @name
+ * @name: class name, as passed to spin_lock_init() or DEFINE_SPINLOCK()
+ * @stats: filled in with the totals over all cpus
+ *
+ * Several init sites can share a name, e.g. "&zone->lock" for every zone;
+ * their counters are added up and wait_max is the largest of them. The
+ * call site slots are per class and so are not meaningful across classes.
+ *
+ * Return: 0, or -ENOENT if no lock by that name has been used yet.
+ */
+int lockstat_snapshot(const char *name, struct lock_class_stats *stats)
+{
+	unsigned int nr = smp_load_acquire(&nr_lock_classes);
+	struct lock_class_stats sum;
+	unsigned int idx;
+	int i, ret = -ENOENT;
+
+	memset(stats, 0, sizeof(*stats));
+	for (idx = 0; idx < nr; idx++) {
+		if (strcmp(lock_classes[idx].name, name))
+			continue;
+
+		lock_class_sum(idx, &sum);
+		stats->acquisitions += sum.acquisitions;
+		stats->contentions += sum.contentions;
+		stats->wait_total += sum.wait_total;
+		stats->wait_max = max(stats->wait_max, sum.wait_max);
+		for (i = 0; i < LOCKSTAT_HIST_BUCKETS; i++)
+			stats->wait_hist[i] += sum.wait_hist[i];
+		for (i = 0; i < LOCKSTAT_POINTS; i++) {
+			stats->contention_point[i] += sum.contention_point[i];
+			stats->contending_point[i] += sum.contending_point[i];
+		}
+		ret = 0;
+	}
+	return ret;
+}
+
+static void lock_class_show(struct lock_class *class,
+			    struct lock_class_stats *stats)
+{
+	int i, last;
+
+	pr_info("%-32s %10llu %12llu %12llu %12llu\n", class->name,
+		stats->contentions, stats->acquisitions, stats->wait_max,
+		stats->wait_total / stats->contentions);
+
+	for (last = LOCKSTAT_HIST_BUCKETS - 1; last > 0; last--)
+		if (stats->wait_hist[last])
+			break;
+	for (i = 0; i <= last; i++)
+		pr_info("  wait < 2^%-2d %10llu\n", i, stats->wait_hist[i]);
+
+	for (i = 0; i < LOCKSTAT_POINTS; i++)
+		if (stats->contention_point[i])
+			pr_info("  waiter %10llu %pS\n",
+				stats->contention_point[i],
+				(void *)class->contention_point[i]);
+	for (i = 0; i < LOCKSTAT_POINTS; i++)
+		if (stats->contending_point[i])
+			pr_info("  holder %10llu %pS\n",
+				stats->contending_point[i],
+				(void *)class->contending_point[i]);
+}
+
+/*
+ * Print every class that has been contended, most contended first, with
+ * its wait time histogram and the call sites on both sides. Times are in
+ * get_cycles() units.
+ */
+void lockstat_dump(void)
+{
+	unsigned int nr = smp_load_acquire(&nr_lock_classes);
+	struct lock_class_stats *sums;
+	unsigned int idx, best, shown;
+
+	sums = kcalloc(nr, sizeof(*sums), GFP_KERNEL);
+	if (!sums) {
+		pr_warn("no memory for the dump\n");
+		return;
+	}
+	for (idx = 0; idx < nr; idx++)
+		lock_class_sum(idx, &sums[idx]);
+
+	pr_info("%-32s %10s %12s %12s %12s\n", "class", "contended",
+		"acquired", "wait-max", "wait-avg");
+
+	/* Selection sort: the table is small and this is not a hot path */
+	for (shown = 0; shown < nr; shown++) {
+		best = nr;
+		for (idx = 0; idx < nr; idx++) {
+			if (!sums[idx].contentions)
+				continue;
+			if (best == nr ||
+			    sums[idx].contentions > sums[best].contentions)
+				best = idx;
+		}
+		if (best == nr)
+			break;
+		lock_class_show(&lock_classes[best], &sums[best]);
+		sums[best].contentions = 0;
+	}
+
+	kfree(sums);
+}
+
+/*
+ * Zero all counters. Updates racing with this on other cpus may survive
+ * it; the call sites stay assigned to their slots.
+ */
+void lockstat_clear(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(&per_cpu(cpu_lock_stats, cpu), 0,
+		       sizeof(per_cpu(cpu_lock_stats, cpu)));
+}
@@ -5,7 +5,274 @@
  *
  *  Copyright (C) 1991-2002  Linus Torvalds
  */
+#include <linux/bitops.h>
+#include <linux/cpumask.h>
+#include <linux/init.h>
+#include <linux/mm.h>
+#include <linux/percpu.h>
 #include <linux/sched.h>
+#include <linux/sched/task.h>
+#include <linux/smp.h>
+
+#include <asm/mmu_context.h>
+#include <asm/switch_to.h>
+
+/*
+ * One runqueue per cpu, holding the runnable tasks other than the one
+ * running there. A task is queued on the runqueue of task->cpu and only
+ * that cpu takes tasks off it, so a task that is still switching out when
+ * it is woken cannot be picked up anywhere else in the meantime.
+ *
+ * The most important queued task runs next, round robin among those of
+ * equal priority. A task's priority is task->prio, which IPC raises while
+ * the task works for a more important one, see kernel/ipc/prio.c.
+ */
+struct rq {
+	raw_spinlock_t		lock;
+	u64			bitmap;		/* of non-empty queues */
+	struct list_head	queue[MAX_PRIO];
+	struct task_struct	*curr;
+	struct task_struct	*idle;
+};
+
+static DEFINE_PER_CPU(struct rq, runqueues);
+
+#define cpu_rq(cpu)		(&per_cpu(runqueues, (cpu)))
+#define this_rq()		this_cpu_ptr(&runqueues)
+#define task_rq(p)		cpu_rq((p)->cpu)
+
+static void enqueue_task(struct rq *rq, struct task_struct *p)
+{
+	list_add_tail(&p->run_list, &rq->queue[p->prio]);
+	rq->bitmap |= 1ULL << p->prio;
+}
+
+static void dequeue_task(struct rq *rq, struct task_struct *p)
+{
+	list_del_init(&p->run_list);
+	if (list_empty(&rq->queue[p->prio]))
+		rq->bitmap &= ~(1ULL << p->prio);
+}
+
+static struct task_struct *pick_next_task(struct rq *rq)
+{
+	struct task_struct *next;
+
+	if (!rq->bitmap)
+		return rq->idle;
+
+	next = list_first_entry(&rq->queue[__ffs64(rq->bitmap)],
+				struct task_struct, run_list);
+	dequeue_task(rq, next);
+	return next;
+}
+
+/* Whether @p should run instead of what @rq is running */
+static bool preempts_curr(struct rq *rq, struct task_struct *p)
+{
+	return rq->curr == rq->idle || p->prio < rq->curr->prio;
+}
+
+/*
+ * @prev has left the cpu: its registers and stack are no longer in use,
+ * so another cpu may switch to it from here on, see sched_switch_to().
+ * A task that exited is freed here, now that nothing runs on its stack.
+ */
+static void finish_task_switch(struct task_struct *prev)
+{
+	s64 prev_state = prev->state;
+
+	smp_store_release(&prev->on_cpu, 0);
+
+	if (unlikely(prev_state == TASK_DEAD))
+		free_task(prev);
+}
+
+/**
+ * schedule_tail - first thing a new task does after its first switch
+ * @prev: the task that was switched out for it
+ */
+asmlinkage void schedule_tail(struct task_struct *prev)
+{
+	finish_task_switch(prev);
+}
+
+/*
+ * Called with interrupts off and the runqueue lock dropped, after
+ * rq->curr has been set to @next under it; returns in @prev's context
+ * once something switches back to it.
+ */
+static void context_switch(struct rq *rq, struct task_struct *prev,
+			   struct task_struct *next)
+{
+	struct mm_struct *oldmm = prev->active_mm;
+
+	WRITE_ONCE(next->on_cpu, 1);
+
+	if (!next->mm) {
+		next->active_mm = oldmm;
+		enter_lazy_tlb(oldmm, next);
+	} else {
+		next->active_mm = next->mm;
+		switch_mm(oldmm, next->mm, next);
+	}
+
+	switch_to(prev, next, prev);
+	finish_task_switch(prev);
+}
+
+/*
+ * Give up the cpu. If current is still TASK_RUNNING it goes to the back
+ * of the runqueue; otherwise it stays off it until wake_up_process().
+ */
+void schedule(void)
+{
+	struct task_struct *prev = current, *next;
+	struct rq *rq;
+	u64 flags;
+
+	local_irq_save(flags);
+	rq = this_rq();
+
+	raw_spin_lock(&rq->lock);
+	clear_tsk_need_resched(prev);
+	if (prev->state == TASK_RUNNING && prev != rq->idle)
+		enqueue_task(rq, prev);
+	next = pick_next_task(rq);
+	/*
+	 * From here on wake_up_process() must queue prev: it is on its way
+	 * out, and only this cpu, after the switch, takes it off the queue.
+	 */
+	rq->curr = next;
+	raw_spin_unlock(&rq->lock);
+
+	if (next != prev)
+		context_switch(rq, prev, next);
+
+	local_irq_restore(flags);
+}
+
+/**
+ * sched_switch_to - hand the cpu straight to a task
+ * @next: runnable task that is on no runqueue
+ *
+ * For IPC, where it is already known who has to run next: the runqueue
+ * is not consulted. current is requeued only if it is still runnable.
+ * @next may have blocked on another cpu, so wait until that cpu is done
+ * switching it out before taking it over.
+ */
+void sched_switch_to(struct task_struct *next)
+{
+	struct task_struct *prev = current;
+	struct rq *rq;
+	u64 flags;
+
+	smp_cond_load_acquire(&next->on_cpu, !VAL);
+
+	local_irq_save(flags);
+	rq = this_rq();
+
+	raw_spin_lock(&rq->lock);
+	if (prev->state == TASK_RUNNING && prev != rq->idle)
+		enqueue_task(rq, prev);
+	next->cpu = smp_processor_id();
+	rq->curr = next;
+	raw_spin_unlock(&rq->lock);
+
+	context_switch(rq, prev, next);
+
+	local_irq_restore(flags);
+}
+
+/**
+ * sched_may_switch - check that switching directly respects priorities
+ * @prio: priority of the task sched_switch_to() would run
+ *
+ * Return: false if a task queued on this cpu is more important, in which
+ * case the runqueue has to decide who runs.
+ */
+bool sched_may_switch(unsigned int prio)
+{
+	u64 bitmap = READ_ONCE(this_rq()->bitmap);
+
+	return !bitmap || __ffs64(bitmap) >= prio;
+}
+
+/**
+ * sched_set_prio - change the priority a task runs at
+ * @p: the task
+ * @prio: its new priority
+ *
+ * A queued task goes to the back of its new queue. Whichever of @p and
+ * the task running on its cpu ends up less important is asked to
+ * reschedule.
+ */
+void sched_set_prio(struct task_struct *p, unsigned int prio)
+{
+	struct rq *rq = task_rq(p);
+	u64 flags;
+
+	raw_spin_lock_irqsave(&rq->lock, flags);
+	if (!list_empty(&p->run_list)) {
+		dequeue_task(rq, p);
+		p->prio = prio;
+		enqueue_task(rq, p);
+		if (preempts_curr(rq, p))
+			set_tsk_need_resched(rq->curr);
+	} else {
+		p->prio = prio;
+		if (p == rq->curr && rq->bitmap && __ffs64(rq->bitmap) < prio)
+			set_tsk_need_resched(p);
+	}
+	raw_spin_unlock_irqrestore(&rq->lock, flags);
+}
+
+/**
+ * wake_up_process - make a sleeping task runnable
+ * @p: the task
+ *
+ * Return: 1 if @p was woken, 0 if it was already runnable.
+ */
+int wake_up_process(struct task_struct *p)
+{
+	struct rq *rq = task_rq(p);
+	u64 flags;
+	int woken = 0;
+
+	raw_spin_lock_irqsave(&rq->lock, flags);
+	if (p->state != TASK_RUNNING) {
+		p->state = TASK_RUNNING;
+		/* Woken before it got as far as schedule(): nothing to queue */
+		if (p != rq->curr) {
+			enqueue_task(rq, p);
+			if (preempts_curr(rq, p))
+				set_tsk_need_resched(rq->curr);
+		}
+		woken = 1;
+	}
+	raw_spin_unlock_irqrestore(&rq->lock, flags);
+
+	return woken;
+}
+
+void __init sched_init(void)
+{
+	int cpu, prio;
+
+	BUILD_BUG_ON(MAX_PRIO > 64);
+
+	for_each_possible_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		raw_spin_lock_init(&rq->lock);
+		for (prio = 0; prio < MAX_PRIO; prio++)
+			INIT_LIST_HEAD(&rq->queue[prio]);
+	}
+
+	/* The boot task becomes this cpu's idle task */
+	this_rq()->curr = this_rq()->idle = &init_task;
+	init_task.cpu = smp_processor_id();
+}
 
 /*
  * __cond_resched_lock() - if a reschedule is pending, drop the given lock,
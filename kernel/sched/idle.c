@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Generic entry point for the idle task
+ */
+#include <linux/irqflags.h>
+#include <linux/sched.h>
+#include <linux/cpu.h>
+
+#include <asm/proc-fns.h>
+
+/*
+ * Look for work with interrupts masked, so that a wakeup from an interrupt
+ * handler cannot land between the check and WFI. A pending interrupt still
+ * ends WFI; it is taken once interrupts are unmasked again.
+ */
+static void do_idle(void)
+{
+	local_irq_disable();
+	if (!need_resched())
+		cpu_do_idle();
+	local_irq_enable();
+}
+
+void cpu_startup_entry(void)
+{
+	for (;;) {
+		schedule();
+		do_idle();
+	}
+}
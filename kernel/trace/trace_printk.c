@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Binary trace_printk() buffers
+ *
+ * trace_printk() is meant for paths that cannot afford a vsnprintf() per
+ * event. The writer only runs vbin_printf(), which stores the arguments by
+ * value next to the format pointer, into a buffer owned by the local cpu.
+ * Turning a record into text with bstr_printf() is left to whoever reads
+ * the buffers.
+ *
+ * Each cpu has a single-producer/single-consumer ring of u32 words. The
+ * producer is the owning cpu with interrupts disabled, so it needs no lock;
+ * consumers serialise among themselves on trace_read_lock. The head and
+ * tail are free running word counts, published with release/acquire so
+ * that a record is only seen once it has been completely written and is
+ * only overwritten once it has been completely formatted.
+ */
+
+#define pr_fmt(fmt) "trace: " fmt
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/cpumask.h>
+#include <linux/gfp.h>
+#include <linux/percpu.h>
+#include <linux/smp.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+
+#include <asm/timex.h>
+
+#define TRACE_BUF_WORDS		(1U << (CONFIG_TRACE_PRINTK_BUF_SHIFT - 2))
+#define TRACE_BUF_MASK		(TRACE_BUF_WORDS - 1)
+
+/* Set in ->len for the filler written when a record would straddle the end */
+#define TRACE_ENTRY_PAD		0x80000000U
+
+struct trace_bprint_entry {
+	u32 len;		/* in words, header included; always even */
+	u32 __pad;
+	u64 ts;
+	u64 ip;
+	const char *fmt;
+	u32 buf[];
+};
+
+#define TRACE_ENTRY_WORDS	(sizeof(struct trace_bprint_entry) / sizeof(u32))
+
+struct trace_cpu_buffer {
+	u32 *data;
+	u64 head;		/* written by the owning cpu only */
+	u64 tail;		/* written by readers only */
+	u64 dropped;		/* written by the owning cpu only */
+	u64 dropped_seen;	/* written by readers only */
+};
+
+static DEFINE_PER_CPU(struct trace_cpu_buffer, trace_cpu_buffer);
+static DEFINE_RAW_SPINLOCK(trace_read_lock);
+
+static char trace_text[1024];
+
+/*
+ * Pack @args into the ring at word offset @off and return the size of the
+ * record it needs, in words. If that is more than @avail the record is not
+ * valid and nothing past @avail has been touched.
+ */
+static u32 trace_pack(struct trace_cpu_buffer *cb, u32 off, u32 avail,
+		      const char *fmt, va_list args)
+{
+	struct trace_bprint_entry *entry;
+	u32 size = 0;
+	va_list ap;
+	int len;
+
+	entry = (struct trace_bprint_entry *)(cb->data + off);
+	if (avail > TRACE_ENTRY_WORDS)
+		size = avail - TRACE_ENTRY_WORDS;
+
+	va_copy(ap, args);
+	len = vbin_printf(entry->buf, size, fmt, ap);
+	va_end(ap);
+
+	return ALIGN(TRACE_ENTRY_WORDS + len, 2);
+}
+
+/**
+ * __trace_vbprintk - record a binary trace_printk() event
+ * @ip: the caller's address, reported with the event
+ * @fmt: format string, which must stay valid until the event is read
+ * @args: the arguments for @fmt
+ *
+ * Returns the size of the record in bytes, or 0 if it was dropped because
+ * the buffer was full or not yet set up.
+ */
+int __trace_vbprintk(u64 ip, const char *fmt, va_list args)
+{
+	struct trace_cpu_buffer *cb;
+	struct trace_bprint_entry *entry;
+	u64 flags, head;
+	u32 off, room, contig, len;
+	int ret = 0;
+
+	local_irq_save(flags);
+	cb = this_cpu_ptr(&trace_cpu_buffer);
+	if (unlikely(!cb->data)) {
+		cb->dropped++;
+		goto out;
+	}
+
+	head = cb->head;
+	room = TRACE_BUF_WORDS - (head - smp_load_acquire(&cb->tail));
+	off = head & TRACE_BUF_MASK;
+	contig = TRACE_BUF_WORDS - off;
+
+	/* Try to pack in place; vbin_printf() reports the size it needed. */
+	len = trace_pack(cb, off, min(room, contig), fmt, args);
+	if (len > min(room, contig)) {
+		/*
+		 * Only the tail of the ring was too short: fill it and start
+		 * over at the beginning, if the reader has made room there.
+		 */
+		if (len > contig && room > contig && len <= room - contig) {
+			cb->data[off] = contig | TRACE_ENTRY_PAD;
+			head += contig;
+			off = 0;
+			len = trace_pack(cb, off, room - contig, fmt, args);
+		} else {
+			cb->dropped++;
+			goto out;
+		}
+	}
+
+	entry = (struct trace_bprint_entry *)(cb->data + off);
+	entry->len = len;
+	entry->ts = get_cycles();
+	entry->ip = ip;
+	entry->fmt = fmt;
+
+	smp_store_release(&cb->head, head + len);
+	ret = len * sizeof(u32);
+out:
+	local_irq_restore(flags);
+	return ret;
+}
+
+int __trace_bprintk(u64 ip, const char *fmt, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, fmt);
+	ret = __trace_vbprintk(ip, fmt, ap);
+	va_end(ap);
+
+	return ret;
+}
+
+/*
+ * Return the oldest complete record of @cb, skipping (and consuming) any
+ * filler in front of it, or NULL if the buffer is empty.
+ */
+static struct trace_bprint_entry *trace_peek(struct trace_cpu_buffer *cb)
+{
+	u64 head = smp_load_acquire(&cb->head);
+	u64 tail = cb->tail;
+	struct trace_bprint_entry *entry;
+
+	while (tail != head) {
+		entry = (struct trace_bprint_entry *)(cb->data +
+						      (tail & TRACE_BUF_MASK));
+		if (!(entry->len & TRACE_ENTRY_PAD))
+			return entry;
+
+		tail += entry->len & ~TRACE_ENTRY_PAD;
+		smp_store_release(&cb->tail, tail);
+	}
+
+	return NULL;
+}
+
+static void trace_consume(struct trace_cpu_buffer *cb,
+			  struct trace_bprint_entry *entry)
+{
+	smp_store_release(&cb->tail, cb->tail + entry->len);
+}
+
+/* Pick the cpu whose oldest pending record has the smallest timestamp. */
+static struct trace_bprint_entry *trace_next(int *cpup)
+{
+	struct trace_bprint_entry *next = NULL, *entry;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct trace_cpu_buffer *cb = per_cpu_ptr(&trace_cpu_buffer, cpu);
+
+		if (!cb->data)
+			continue;
+
+		entry = trace_peek(cb);
+		if (entry && (!next || entry->ts < next->ts)) {
+			next = entry;
+			*cpup = cpu;
+		}
+	}
+
+	return next;
+}
+
+static int trace_format(char *buf, size_t size, int cpu,
+			struct trace_bprint_entry *entry)
+{
+	int len;
+
+	len = scnprintf(buf, size, "[%03d] %llu: %llx: ", cpu, entry->ts,
+			entry->ip);
+	len += bstr_printf(buf + len, size - len, entry->fmt, entry->buf);
+
+	return min_t(int, len, size - 1);
+}
+
+/**
+ * trace_printk_read - consume and format the oldest trace_printk() event
+ * @buf: where to place the text
+ * @size: size of @buf, including the trailing NUL
+ *
+ * Events are returned in timestamp order across all cpus. Returns the
+ * length of the text placed in @buf, or 0 once every buffer is empty.
+ */
+int trace_printk_read(char *buf, size_t size)
+{
+	struct trace_bprint_entry *entry;
+	u64 flags;
+	int cpu, len = 0;
+
+	raw_spin_lock_irqsave(&trace_read_lock, flags);
+	entry = trace_next(&cpu);
+	if (entry) {
+		len = trace_format(buf, size, cpu, entry);
+		trace_consume(per_cpu_ptr(&trace_cpu_buffer, cpu), entry);
+	}
+	raw_spin_unlock_irqrestore(&trace_read_lock, flags);
+
+	return len;
+}
+
+/**
+ * trace_printk_dump - format and print every pending trace_printk() event
+ *
+ * Drains the buffers to the console, oldest first, then reports how many
+ * events each cpu had to drop since the last dump.
+ */
+void trace_printk_dump(void)
+{
+	struct trace_bprint_entry *entry;
+	u64 flags;
+	int cpu;
+
+	raw_spin_lock_irqsave(&trace_read_lock, flags);
+	pr_info("Dumping trace_printk() buffers\n");
+
+	while ((entry = trace_next(&cpu))) {
+		trace_format(trace_text, sizeof(trace_text), cpu, entry);
+		trace_consume(per_cpu_ptr(&trace_cpu_buffer, cpu), entry);
+		printk(KERN_INFO "%s", trace_text);
+	}
+
+	for_each_possible_cpu(cpu) {
+		struct trace_cpu_buffer *cb = per_cpu_ptr(&trace_cpu_buffer, cpu);
+		u64 dropped = READ_ONCE(cb->dropped);
+
+		if (dropped != cb->dropped_seen)
+			pr_info("cpu%d: %llu events dropped\n", cpu,
+				dropped - cb->dropped_seen);
+		cb->dropped_seen = dropped;
+	}
+	pr_info("End of trace_printk() buffers\n");
+	raw_spin_unlock_irqrestore(&trace_read_lock, flags);
+}
+
+/*
+ * Called from start_kernel() once the page allocator is up. Events logged
+ * before then are counted as dropped.
+ */
+void __init trace_printk_init(void)
+{
+	unsigned int order = get_order(TRACE_BUF_WORDS * sizeof(u32));
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct trace_cpu_buffer *cb = per_cpu_ptr(&trace_cpu_buffer, cpu);
+		u32 *data = (u32 *)__get_free_pages(GFP_KERNEL, order);
+
+		if (!data) {
+			pr_warn("cpu%d: failed to allocate buffer\n", cpu);
+			continue;
+		}
+
+		cb->head = cb->tail = 0;
+		/* Publish the buffer only once it is ready to be written */
+		smp_store_release(&cb->data, data);
+	}
+
+	pr_info("%u KB per cpu binary buffers\n",
+		(TRACE_BUF_WORDS * 4) >> 10);
+}
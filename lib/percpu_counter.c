@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Fast batching percpu counters.
+ *
+ * Each cpu accumulates updates in its own s32 and only folds them into the
+ * shared count, under the counter's lock, once they reach the batch size.
+ * percpu_counter_read() returns the shared count and may be off by up to
+ * batch * nr_cpus; percpu_counter_sum() adds up every cpu's delta for the
+ * exact value.
+ */
+
+#include <linux/percpu_counter.h>
+#include <linux/cpumask.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+
+int percpu_counter_batch __read_mostly = 32;
+
+void percpu_counter_set(struct percpu_counter *fbc, s64 amount)
+{
+	int cpu;
+	u64 flags;
+
+	raw_spin_lock_irqsave(&fbc->lock, flags);
+	for_each_possible_cpu(cpu) {
+		s32 *pcount = per_cpu_ptr(fbc->counters, cpu);
+		*pcount = 0;
+	}
+	fbc->count = amount;
+	raw_spin_unlock_irqrestore(&fbc->lock, flags);
+}
+
+/**
+ * percpu_counter_add_batch - add to a percpu counter
+ * @fbc: the counter
+ * @amount: value to add, may be negative
+ * @batch: size of the local delta at which it is folded into the count
+ *
+ * This function is both preempt and irq safe. The former is due to explicit
+ * preemption disable. The latter is guaranteed by the fact that the slow path
+ * is explicitly protected by an irq-safe spinlock whereas the fast patch uses
+ * this_cpu_add which is irq-safe by definition. Hence there is no need muck
+ * with irq state before calling this one
+ */
+void percpu_counter_add_batch(struct percpu_counter *fbc, s64 amount, s32 batch)
+{
+	s64 count;
+
+	preempt_disable();
+	count = this_cpu_read(*fbc->counters) + amount;
+	if (count >= batch || count <= -batch) {
+		u64 flags;
+
+		raw_spin_lock_irqsave(&fbc->lock, flags);
+		fbc->count += count;
+		this_cpu_sub(*fbc->counters, count - amount);
+		raw_spin_unlock_irqrestore(&fbc->lock, flags);
+	} else {
+		this_cpu_add(*fbc->counters, amount);
+	}
+	preempt_enable();
+}
+
+/*
+ * Add up all the per-cpu counts, return the result.  This is a more accurate
+ * but much slower version of percpu_counter_read_positive()
+ */
+s64 __percpu_counter_sum(struct percpu_counter *fbc)
+{
+	s64 ret;
+	int cpu;
+	u64 flags;
+
+	raw_spin_lock_irqsave(&fbc->lock, flags);
+	ret = fbc->count;
+	for_each_possible_cpu(cpu) {
+		s32 *pcount = per_cpu_ptr(fbc->counters, cpu);
+		ret += *pcount;
+	}
+	raw_spin_unlock_irqrestore(&fbc->lock, flags);
+	return ret;
+}
+
+/**
+ * percpu_counter_init - set up a percpu counter
+ * @fbc: the counter
+ * @amount: initial value
+ * @gfp: allocation flags for the per-cpu deltas
+ *
+ * Returns 0, or -ENOMEM if the per-cpu deltas could not be allocated.
+ */
+int percpu_counter_init(struct percpu_counter *fbc, s64 amount, gfp_t gfp)
+{
+	raw_spin_lock_init(&fbc->lock);
+	fbc->count = amount;
+	fbc->counters = alloc_percpu_gfp(s32, gfp);
+	if (!fbc->counters)
+		return -ENOMEM;
+
+	return 0;
+}
+
+void percpu_counter_destroy(struct percpu_counter *fbc)
+{
+	if (!fbc->counters)
+		return;
+
+	free_percpu(fbc->counters);
+	fbc->counters = NULL;
+}
+
+/*
+ * Compare counter against given value.
+ * Return 1 if greater, 0 if equal and -1 if less
+ */
+int __percpu_counter_compare(struct percpu_counter *fbc, s64 rhs, s32 batch)
+{
+	s64	count, slack = (s64)batch * nr_possible_cpu_ids;
+
+	count = percpu_counter_read(fbc);
+	/* Check to see if rough count will be sufficient for comparison */
+	if (count - rhs > slack || rhs - count > slack) {
+		if (count > rhs)
+			return 1;
+		else
+			return -1;
+	}
+	/* Need to use precise count */
+	count = percpu_counter_sum(fbc);
+	if (count > rhs)
+		return 1;
+	else if (count < rhs)
+		return -1;
+	else
+		return 0;
+}
+
+/*
+ * The batch grows with the number of cpus, so that the shared count is
+ * touched no more often per cpu on large machines than on small ones.
+ * Called from start_kernel() once the possible cpus are known.
+ */
+void __init percpu_counter_startup(void)
+{
+	percpu_counter_batch = max_t(int, 32, nr_possible_cpu_ids * 2);
+}
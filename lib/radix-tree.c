@@ -243,6 +243,56 @@ static u64 next_index(u64 index,
 	return (index & ~node_maxindex(node)) + (offset << node->shift);
 }
 
+/*
+ * Nodes freed in task context go back to this cpu's preload pool rather
+ * than to the slab, up to RADIX_TREE_PRELOAD_SIZE of them, and allocation
+ * takes from the pool first. Trees that grow and shrink all the time, such
+ * as the IDRs and IDAs handing out IDs for short-lived objects, then mostly
+ * recycle nodes without calling into the slab allocator. The pool is never
+ * touched from interrupt context, so disabling preemption is enough to
+ * keep it consistent.
+ */
+struct radix_tree_node *radix_tree_node_cache_get(void)
+{
+	struct radix_tree_preload *rtp;
+	struct radix_tree_node *node = NULL;
+
+	if (in_interrupt())
+		return NULL;
+
+	preempt_disable();
+	rtp = this_cpu_ptr(&radix_tree_preloads);
+	if (rtp->nr) {
+		node = rtp->nodes;
+		rtp->nodes = node->parent;
+		rtp->nr--;
+	}
+	preempt_enable();
+
+	return node;
+}
+
+static bool radix_tree_node_cache_put(struct radix_tree_node *node)
+{
+	struct radix_tree_preload *rtp;
+	bool ret = false;
+
+	if (in_interrupt())
+		return false;
+
+	preempt_disable();
+	rtp = this_cpu_ptr(&radix_tree_preloads);
+	if (rtp->nr < RADIX_TREE_PRELOAD_SIZE) {
+		node->parent = rtp->nodes;
+		rtp->nodes = node;
+		rtp->nr++;
+		ret = true;
+	}
+	preempt_enable();
+
+	return ret;
+}
+
 /*
  * This assumes that the caller has performed appropriate preallocation, and
  * that the caller has pinned this thread of control to the current CPU.
@@ -253,42 +303,18 @@ radix_tree_node_alloc(gfp_t gfp_mask, struct radix_tree_node *parent,
 			unsigned int shift, unsigned int offset,
 			unsigned int count, unsigned int nr_values)
 {
-	struct radix_tree_node *ret = NULL;
+	struct radix_tree_node *ret;
 
 	/*
-	 * Preload code isn't irq safe and it doesn't make sense to use
-	 * preloading during an interrupt anyway as all the allocations have
-	 * to be atomic. So just do normal allocation when in interrupt.
+	 * Provided the caller has preloaded here, we will always succeed in
+	 * getting a node from the pool (and never reach kmem_cache_alloc).
+	 * Preload code isn't irq safe, so in interrupt context the pool is
+	 * skipped and the allocation goes straight to the slab.
 	 */
-	if (!in_interrupt()) {
-		struct radix_tree_preload *rtp;
-
-		/*
-		 * Even if the caller has preloaded, try to allocate from the
-		 * cache first for the new node to get accounted to the memory
-		 * cgroup.
-		 */
-		ret = kmem_cache_alloc(radix_tree_node_cachep,
-				       gfp_mask | __GFP_NOWARN);
-		if (ret)
-			goto out;
+	ret = radix_tree_node_cache_get();
+	if (!ret)
+		ret = kmem_cache_alloc(radix_tree_node_cachep, gfp_mask);
 
-		/*
-		 * Provided the caller has preloaded here, we will always
-		 * succeed in getting a node here (and never reach
-		 * kmem_cache_alloc)
-		 */
-		rtp = this_cpu_ptr(&radix_tree_preloads);
-		if (rtp->nr) {
-			ret = rtp->nodes;
-			rtp->nodes = ret->parent;
-			rtp->nr--;
-		}
-
-		goto out;
-	}
-	ret = kmem_cache_alloc(radix_tree_node_cachep, gfp_mask);
-out:
 	BUG_ON(radix_tree_is_internal_node(ret));
 	if (ret) {
 		ret->shift = shift;
@@ -315,7 +341,8 @@ void radix_tree_node_rcu_free(struct rcu_head *head)
 	memset(node->tags, 0, sizeof(node->tags));
 	INIT_LIST_HEAD(&node->private_list);
 
-	kmem_cache_free(radix_tree_node_cachep, node);
+	if (!radix_tree_node_cache_put(node))
+		kmem_cache_free(radix_tree_node_cachep, node);
 }
 
 static inline void
@@ -1451,6 +1478,10 @@ int radix_tree_tagged(const struct radix_tree_root *root, unsigned int tag)
  *
  * Preallocate memory to use for the next call to idr_alloc().  This function
  * returns with preemption disabled.  It will be enabled by idr_preload_end().
+ *
+ * The nodes are kept in this cpu's node pool, which the IDA's XArray also
+ * allocates from, so a preload covers ida_alloc() and ida_alloc_batch() as
+ * well.
  */
 void idr_preload(gfp_t gfp_mask)
 {
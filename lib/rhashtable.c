@@ -0,0 +1,461 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Resizable, Scalable, Concurrent Hash Table
+ *
+ * Copyright (c) 2015 Herbert Xu <herbert@gondor.apana.org.au>
+ * Copyright (c) 2014-2015 Thomas Graf <tgraf@suug.ch>
+ * Copyright (c) 2008-2014 Patrick McHardy <kaber@trash.net>
+ *
+ * Code partially derived from nft_hash
+ * Rewritten with rehash code from br_multicast plus single list
+ * pointer as suggested by Josh Triplett
+ *
+ * Resizing never stops the table. A bigger (or smaller) table is hung off
+ * the current one as its future_tbl and buckets are moved into it one at a
+ * time, in index order, a few at the end of every insert and remove. Until a bucket has been moved, updates
+ * for its keys are applied to the old table; afterwards to the new one.
+ * Lookups search the old table first and then the new one. The old table
+ * is freed once no lookup or update is left that may still be walking it.
+ */
+
+#include <linux/atomic.h>
+#include <linux/hash.h>
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/log2.h>
+#include <linux/sched.h>
+#include <linux/rculist.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/jhash.h>
+#include <linux/rhashtable.h>
+#include <linux/err.h>
+
+#include <asm/timex.h>
+
+#define HASH_DEFAULT_SIZE	64UL
+#define HASH_MIN_SIZE		4U
+
+/* Buckets moved into the future table at the end of each update */
+#define RHT_REHASH_BATCH	8
+
+/*
+ * Resizes allocate under rcu_read_lock(), where kvmalloc() cannot fall
+ * back to vmalloc(): tables grow no larger than kmalloc() can return.
+ */
+#define RHT_ATOMIC_MAX_SIZE						\
+	rounddown_pow_of_two((KMALLOC_MAX_SIZE - sizeof(struct bucket_table)) / \
+			     sizeof(((struct bucket_table *)0)->buckets[0]))
+
+static u32 rhashtable_jhash2(const void *key, u32 length, u32 seed)
+{
+	return jhash2(key, length / sizeof(u32), seed);
+}
+
+static u32 rhashtable_jhash(const void *key, u32 length, u32 seed)
+{
+	return jhash(key, length, seed);
+}
+
+static void bucket_table_free(const struct bucket_table *tbl)
+{
+	kvfree(tbl);
+}
+
+static struct bucket_table *bucket_table_alloc(struct rhashtable *ht,
+					       size_t nbuckets, gfp_t gfp)
+{
+	struct bucket_table *tbl;
+	size_t size;
+
+	size = sizeof(*tbl) + nbuckets * sizeof(tbl->buckets[0]);
+	tbl = kvzalloc(size, gfp);
+	if (!tbl)
+		return NULL;
+
+	tbl->size = nbuckets;
+	tbl->hash_rnd = hash32_ptr(tbl) ^ (u32)get_cycles();
+
+	return tbl;
+}
+
+/*
+ * Move every object of the next unmoved bucket of @old into @new. Called
+ * with ht->lock held, which keeps other movers out; the bucket locks keep
+ * out the updaters.
+ */
+static void rhashtable_rehash_one(struct rhashtable *ht,
+				  struct bucket_table *old,
+				  struct bucket_table *new)
+{
+	unsigned int old_hash = old->rehash;
+	struct rhash_head *he, *next;
+	unsigned int new_hash;
+
+	rht_lock(old, old_hash);
+
+	for (he = rht_ptr(old, old_hash); !rht_is_a_nulls(he); he = next) {
+		next = rht_dereference(he->next, ht);
+		new_hash = rht_head_hashfn(ht, new, he, ht->p);
+
+		rht_lock(new, new_hash);
+		RCU_INIT_POINTER(he->next, rht_ptr(new, new_hash));
+		rht_assign_locked(new, new_hash, he);
+		rht_unlock(new, new_hash);
+
+		rht_assign_locked(old, old_hash, next);
+	}
+
+	/* Later updates for this bucket must go to the new table */
+	smp_store_release(&old->rehash, old_hash + 1);
+
+	rht_unlock(old, old_hash);
+}
+
+/*
+ * Move up to @nr buckets. Once the old table is empty, the new one takes
+ * its place. Called with ht->lock held; returns true while there is more
+ * to move.
+ */
+static bool rhashtable_rehash_batch(struct rhashtable *ht, unsigned int nr)
+{
+	struct bucket_table *old = rht_dereference(ht->tbl, ht);
+	struct bucket_table *new = rht_dereference(old->future_tbl, ht);
+
+	if (!new)
+		return false;
+
+	while (nr-- && old->rehash < old->size)
+		rhashtable_rehash_one(ht, old, new);
+
+	if (old->rehash < old->size)
+		return true;
+
+	rcu_assign_pointer(ht->tbl, new);
+
+	/* All new readers will see the new table; wait for the others */
+	old->next_retired = ht->retired;
+	WRITE_ONCE(ht->retired, old);
+
+	return false;
+}
+
+/**
+ * rhashtable_rehash_step - move a few buckets into the future table
+ * @ht:		the hash table
+ *
+ * Called at the end of updates while a resize is in progress; there is no
+ * other mover, so the resize finishes after about size / RHT_REHASH_BATCH
+ * updates. Gives up at once if somebody else is already moving buckets.
+ */
+void rhashtable_rehash_step(struct rhashtable *ht)
+{
+	if (!spin_trylock(&ht->lock))
+		return;
+
+	rhashtable_rehash_batch(ht, RHT_REHASH_BATCH);
+
+	spin_unlock(&ht->lock);
+}
+
+/**
+ * rhashtable_free_retired - free the tables replaced by a rehash
+ * @ht:		the hash table
+ *
+ * Called after updates, outside the read side, while tables are waiting
+ * to be freed. Frees all of them if no lookup or update is in progress;
+ * otherwise a later update tries again.
+ */
+void rhashtable_free_retired(struct rhashtable *ht)
+{
+	struct bucket_table *tbl = NULL, *next;
+	int cpu, readers = 0;
+
+	if (!spin_trylock(&ht->lock))
+		return;
+
+	/* Pairs with rht_read_enter(), after ht->tbl was replaced */
+	smp_mb();
+
+	for_each_possible_cpu(cpu)
+		readers += READ_ONCE(*per_cpu_ptr(ht->readers, cpu));
+
+	if (!readers) {
+		tbl = ht->retired;
+		WRITE_ONCE(ht->retired, NULL);
+	}
+
+	spin_unlock(&ht->lock);
+
+	for (; tbl; tbl = next) {
+		next = tbl->next_retired;
+		bucket_table_free(tbl);
+	}
+}
+
+/*
+ * Hang a table of @size buckets off @old. Fails with -EAGAIN if @old is
+ * no longer the current table or already has a future table.
+ */
+static int rhashtable_attach_table(struct rhashtable *ht,
+				   struct bucket_table *old,
+				   unsigned int size, gfp_t gfp)
+{
+	struct bucket_table *new;
+	int err = 0;
+
+	new = bucket_table_alloc(ht, size, gfp);
+	if (!new)
+		return -ENOMEM;
+
+	spin_lock(&ht->lock);
+	if (rht_dereference(ht->tbl, ht) != old ||
+	    rht_dereference(old->future_tbl, ht))
+		err = -EAGAIN;
+	else
+		rcu_assign_pointer(old->future_tbl, new);
+	spin_unlock(&ht->lock);
+
+	if (err)
+		bucket_table_free(new);
+
+	return err;
+}
+
+/*
+ * Size that fits the current element count without expanding again right
+ * away, or 0 if @old is already no bigger than that.
+ */
+static unsigned int rhashtable_shrink_size(struct rhashtable *ht,
+					   struct bucket_table *old)
+{
+	unsigned int nelems = atomic_read(&ht->nelems);
+	unsigned int size = 0;
+
+	if (nelems)
+		size = roundup_pow_of_two(nelems * 3 / 2);
+	if (size < ht->p.min_size)
+		size = ht->p.min_size;
+
+	return old->size > size ? size : 0;
+}
+
+/**
+ * rhashtable_resize - start growing or shrinking a table from an update
+ * @ht:		the hash table
+ * @tbl:	the table the update started from
+ * @grow:	true after an insert, false after a remove
+ *
+ * Called under rcu_read_lock() but outside the bucket locks, once the load
+ * has left the 30%-75% band. The new table is attached right here, with
+ * GFP_ATOMIC since the caller may not sleep, and the first batch of
+ * buckets is moved; later updates move the rest. On allocation failure
+ * the next update out of bounds simply tries again.
+ */
+void rhashtable_resize(struct rhashtable *ht, struct bucket_table *tbl,
+		       bool grow)
+{
+	unsigned int size;
+
+	if (grow) {
+		if (!rht_grow_above_75(ht, tbl))
+			return;
+		size = tbl->size * 2;
+	} else {
+		if (!ht->p.automatic_shrinking ||
+		    !rht_shrink_below_30(ht, tbl))
+			return;
+		size = rhashtable_shrink_size(ht, tbl);
+		if (!size)
+			return;
+	}
+
+	if (rhashtable_attach_table(ht, tbl, size, GFP_ATOMIC | __GFP_NOWARN))
+		return;
+
+	rhashtable_rehash_step(ht);
+}
+
+/**
+ * rhashtable_insert_rehash - start growing a table from the insert path
+ * @ht:		the hash table
+ * @tbl:	the table the insert found overloaded
+ *
+ * Used when the table has passed 100% load without a bigger table being
+ * attached, e.g. because an earlier attempt failed to allocate. Called
+ * under rcu_read_lock(), so the allocation must not sleep.
+ *
+ * Returns 0 if a bigger table is being filled, -EAGAIN if somebody else
+ * already started one, or -ENOMEM.
+ */
+int rhashtable_insert_rehash(struct rhashtable *ht, struct bucket_table *tbl)
+{
+	return rhashtable_attach_table(ht, tbl, tbl->size * 2,
+				       GFP_ATOMIC | __GFP_NOWARN);
+}
+
+static size_t rounded_hashtable_size(const struct rhashtable_params *params)
+{
+	size_t retsize;
+
+	if (params->nelem_hint)
+		retsize = max_t(size_t,
+				roundup_pow_of_two(params->nelem_hint * 4 / 3),
+				params->min_size);
+	else
+		retsize = max_t(size_t, HASH_DEFAULT_SIZE, params->min_size);
+
+	return retsize;
+}
+
+/**
+ * rhashtable_init - initialize a new hash table
+ * @ht:		hash table to be initialized
+ * @params:	configuration parameters
+ *
+ * Initializes a new hash table based on the provided configuration
+ * parameters. A table can be configured either with a variable or
+ * fixed length key:
+ *
+ * Configuration Example 1: Fixed length keys
+ * struct test_obj {
+ *	int			key;
+ *	void *			my_member;
+ *	struct rhash_head	node;
+ * };
+ *
+ * struct rhashtable_params params = {
+ *	.head_offset = offsetof(struct test_obj, node),
+ *	.key_offset = offsetof(struct test_obj, key),
+ *	.key_len = sizeof(int),
+ *	.hashfn = jhash,
+ * };
+ *
+ * Configuration Example 2: Variable length keys
+ * struct test_obj {
+ *	[...]
+ *	struct rhash_head	node;
+ * };
+ *
+ * u32 my_hash_fn(const void *data, u32 len, u32 seed)
+ * {
+ *	struct test_obj *obj = data;
+ *
+ *	return [... hash ...];
+ * }
+ *
+ * struct rhashtable_params params = {
+ *	.head_offset = offsetof(struct test_obj, node),
+ *	.hashfn = jhash,
+ *	.obj_hashfn = my_hash_fn,
+ * };
+ */
+int rhashtable_init(struct rhashtable *ht,
+		    const struct rhashtable_params *params)
+{
+	struct bucket_table *tbl;
+	size_t size;
+
+	if ((!params->key_len && !params->obj_hashfn) ||
+	    (params->obj_hashfn && !params->obj_cmpfn))
+		return -EINVAL;
+
+	memset(ht, 0, sizeof(*ht));
+	spin_lock_init(&ht->lock);
+	memcpy(&ht->p, params, sizeof(*params));
+
+	if (params->min_size)
+		ht->p.min_size = roundup_pow_of_two(params->min_size);
+
+	/* Cap total entries at 2^31 to avoid nelems overflow. */
+	ht->max_elems = 1u << 31;
+
+	if (params->max_size) {
+		ht->p.max_size = rounddown_pow_of_two(params->max_size);
+		if (ht->p.max_size < ht->max_elems / 2)
+			ht->max_elems = ht->p.max_size * 2;
+	}
+
+	/* Past this the table stops growing but still takes elements */
+	if (!ht->p.max_size || ht->p.max_size > RHT_ATOMIC_MAX_SIZE)
+		ht->p.max_size = RHT_ATOMIC_MAX_SIZE;
+
+	ht->p.min_size = max_t(u16, ht->p.min_size, HASH_MIN_SIZE);
+
+	size = rounded_hashtable_size(&ht->p);
+
+	ht->key_len = ht->p.key_len;
+	if (!params->hashfn) {
+		if (ht->key_len & (sizeof(u32) - 1))
+			ht->p.hashfn = rhashtable_jhash;
+		else
+			ht->p.hashfn = rhashtable_jhash2;
+	}
+
+	ht->readers = alloc_percpu(int);
+	if (!ht->readers)
+		return -ENOMEM;
+
+	tbl = bucket_table_alloc(ht, size, GFP_KERNEL);
+	if (tbl == NULL) {
+		free_percpu(ht->readers);
+		return -ENOMEM;
+	}
+
+	atomic_set(&ht->nelems, 0);
+
+	RCU_INIT_POINTER(ht->tbl, tbl);
+
+	return 0;
+}
+
+/**
+ * rhashtable_free_and_destroy - free elements and destroy hash table
+ * @ht:		the hash table to destroy
+ * @free_fn:	callback to release resources of element
+ * @arg:	pointer passed to free_fn
+ *
+ * Frees the bucket array, both of the current table and of a resize in
+ * progress, and any replaced tables still waiting to be freed. If
+ * function pointer @free_fn is provided, it is called for every element.
+ *
+ * The caller must ensure that no concurrent accesses to the table can
+ * take place any more.
+ */
+void rhashtable_free_and_destroy(struct rhashtable *ht,
+				 void (*free_fn)(void *ptr, void *arg),
+				 void *arg)
+{
+	struct bucket_table *tbl, *next_tbl;
+	struct rhash_head *pos, *next;
+	unsigned int i;
+
+	tbl = rht_dereference(ht->tbl, ht);
+	while (tbl) {
+		if (free_fn) {
+			for (i = 0; i < tbl->size; i++) {
+				for (pos = rht_ptr(tbl, i);
+				     !rht_is_a_nulls(pos); pos = next) {
+					next = rht_dereference(pos->next, ht);
+					free_fn(rht_obj(ht, pos), arg);
+				}
+			}
+		}
+
+		next_tbl = rht_dereference(tbl->future_tbl, ht);
+		bucket_table_free(tbl);
+		tbl = next_tbl;
+	}
+
+	for (tbl = ht->retired; tbl; tbl = next_tbl) {
+		next_tbl = tbl->next_retired;
+		bucket_table_free(tbl);
+	}
+
+	free_percpu(ht->readers);
+}
+
+void rhashtable_destroy(struct rhashtable *ht)
+{
+	return rhashtable_free_and_destroy(ht, NULL, NULL);
+}
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Boot time insert/lookup benchmark for rhashtable
+ *
+ * Fills a table from its default size up to each of a few object counts,
+ * forcing every resize along the way, then times hit and miss lookups.
+ * The same objects are also run through a fixed 1024 bucket hashtable.h
+ * table, the kind of table rhashtable is meant to replace, to show where
+ * its chains start to hurt. Results are in cycles per operation.
+ */
+
+#define pr_fmt(fmt) "rhashtable_bench: " fmt
+
+#include <linux/hash.h>
+#include <linux/hashtable.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/mm.h>
+#include <linux/rhashtable.h>
+
+#include <asm/timex.h>
+
+#define BENCH_STATIC_BITS	10
+
+struct bench_obj {
+	u64			key;
+	struct rhash_head	node;
+	struct hlist_node	hnode;
+};
+
+static const struct rhashtable_params bench_params = {
+	.key_len		= sizeof(u64),
+	.key_offset		= offsetof(struct bench_obj, key),
+	.head_offset		= offsetof(struct bench_obj, node),
+	.automatic_shrinking	= true,
+};
+
+static DEFINE_HASHTABLE(bench_static, BENCH_STATIC_BITS);
+
+/* Spread the keys so that neither table sees a friendly sequence */
+static u64 __init bench_key(unsigned int i)
+{
+	return (u64)i * GOLDEN_RATIO_64;
+}
+
+static struct bench_obj * __init bench_static_find(u64 key)
+{
+	struct bench_obj *obj;
+
+	hash_for_each_possible(bench_static, obj, hnode, key)
+		if (obj->key == key)
+			return obj;
+	return NULL;
+}
+
+static u64 __init per_op(u64 start, unsigned int nr)
+{
+	return (get_cycles() - start) / nr;
+}
+
+static int __init bench_one(struct bench_obj *objs, unsigned int nr)
+{
+	struct rhashtable ht;
+	u64 t, ins, hit, miss, shash_ins, shash_hit;
+	unsigned int i, found = 0;
+	u64 key;
+	int err;
+
+	err = rhashtable_init(&ht, &bench_params);
+	if (err)
+		return err;
+
+	for (i = 0; i < nr; i++)
+		objs[i].key = bench_key(i);
+
+	t = get_cycles();
+	for (i = 0; i < nr; i++) {
+		err = rhashtable_insert_fast(&ht, &objs[i].node, bench_params);
+		if (err)
+			goto out;
+	}
+	ins = per_op(t, nr);
+
+	t = get_cycles();
+	for (i = 0; i < nr; i++) {
+		key = bench_key(i);
+		found += !!rhashtable_lookup_fast(&ht, &key, bench_params);
+	}
+	hit = per_op(t, nr);
+
+	t = get_cycles();
+	for (i = 0; i < nr; i++) {
+		key = bench_key(nr + i);
+		found += !!rhashtable_lookup_fast(&ht, &key, bench_params);
+	}
+	miss = per_op(t, nr);
+
+	if (found != nr)
+		pr_warn("%u: found %u objects\n", nr, found);
+
+	hash_init(bench_static);
+	t = get_cycles();
+	for (i = 0; i < nr; i++)
+		hash_add(bench_static, &objs[i].hnode, objs[i].key);
+	shash_ins = per_op(t, nr);
+
+	t = get_cycles();
+	for (i = 0; i < nr; i++)
+		bench_static_find(bench_key(i));
+	shash_hit = per_op(t, nr);
+
+	pr_info("%8u objs, %8u buckets: insert %llu, hit %llu, miss %llu; static %u buckets: insert %llu, hit %llu\n",
+		nr, rht_dereference(ht.tbl, &ht)->size, ins, hit, miss,
+		1U << BENCH_STATIC_BITS, shash_ins, shash_hit);
+
+	for (i = 0; i < nr; i++)
+		rhashtable_remove_fast(&ht, &objs[i].node, bench_params);
+out:
+	rhashtable_destroy(&ht);
+	return err;
+}
+
+void __init rhashtable_bench(void)
+{
+	static const unsigned int sizes[] __initconst = {
+		256, 4096, 65536, 1U << 20,
+	};
+	struct bench_obj *objs;
+	int i, err = 0;
+
+	objs = kvcalloc(sizes[ARRAY_SIZE(sizes) - 1], sizeof(*objs),
+			GFP_KERNEL);
+	if (!objs) {
+		pr_warn("failed: %d\n", -ENOMEM);
+		return;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(sizes) && !err; i++)
+		err = bench_one(objs, sizes[i]);
+
+	if (err)
+		pr_warn("failed: %d\n", err);
+
+	kvfree(objs);
+}
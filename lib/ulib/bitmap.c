@@ -186,6 +186,7 @@ int __bitmap_subset(const u64 *bitmap1,
 	return 1;
 }
 
+#ifndef __HAVE_ARCH_BITMAP_WEIGHT
 int __bitmap_weight(const u64 *bitmap, unsigned int bits)
 {
 	unsigned int k, lim = bits/BITS_PER_LONG;
@@ -199,6 +200,7 @@ int __bitmap_weight(const u64 *bitmap, unsigned int bits)
 
 	return w;
 }
+#endif
 
 void __bitmap_set(u64 *map, unsigned int start, int len)
 {
@@ -27,6 +27,7 @@
 /* see: Documentation/crc32.txt for a description of algorithms */
 
 #include <linux/crc32.h>
+#include <linux/crc32c.h>
 #include <linux/crc32poly.h>
 #include <linux/types.h>
 #include <linux/cache.h>
@@ -203,6 +204,37 @@ u32 __pure __weak __crc32c_le(u32 crc, unsigned char const *p, size_t len)
 u32 __pure crc32_le_base(u32, unsigned char const *, size_t) __alias(crc32_le);
 u32 __pure __crc32c_le_base(u32, unsigned char const *, size_t) __alias(__crc32c_le);
 
+/**
+ * crc32c - Castagnoli CRC32 of a buffer
+ * @crc: seed value, or the result of a previous call when computing
+ *	 incrementally
+ * @address: the buffer
+ * @length: length of the buffer in bytes
+ */
+u32 crc32c(u32 crc, const void *address, unsigned int length)
+{
+	return __crc32c_le(crc, address, length);
+}
+
+/**
+ * crc32c_multi - Castagnoli CRC32 of several buffers of the same length
+ * @crc: array of @nr seeds, replaced by the results
+ * @address: array of @nr buffers
+ * @nr: number of buffers
+ * @length: length of each buffer in bytes
+ *
+ * Equivalent to calling crc32c() on each buffer in turn; architectures
+ * can override it to interleave the buffers.
+ */
+void __weak crc32c_multi(u32 *crc, const void * const *address,
+			 unsigned int nr, unsigned int length)
+{
+	unsigned int i;
+
+	for (i = 0; i < nr; i++)
+		crc[i] = __crc32c_le(crc[i], address[i], length);
+}
+
 /*
  * This multiplies the polynomials x and y modulo the given modulus.
  * This follows the "little-endian" CRC convention that the lsbit
@@ -837,15 +837,18 @@ static void *check_bytes8(const u8 *start, u8 value, unsigned int bytes)
 }
 
 /**
- * memchr_inv - Find an unmatching character in an area of memory.
+ * __memchr_inv - Find an unmatching character in an area of memory.
  * @start: The memory area
  * @c: Find a character other than c
  * @bytes: The size of the area.
  *
  * returns the address of the first character other than @c, or %NULL
  * if the whole buffer contains just @c.
+ *
+ * This is the word-at-a-time version; architectures that provide their
+ * own memchr_inv() use it for the lengths they do not accelerate.
  */
-void *memchr_inv(const void *start, int c, size_t bytes)
+void *__memchr_inv(const void *start, int c, size_t bytes)
 {
 	u8 value = c;
 	u64 value64;
@@ -890,6 +893,33 @@ void *memchr_inv(const void *start, int c, size_t bytes)
 	return check_bytes8(start, value, bytes % 8);
 }
 
+#ifndef __HAVE_ARCH_MEMCHR_INV
+void *memchr_inv(const void *start, int c, size_t bytes)
+{
+	return __memchr_inv(start, c, bytes);
+}
+#endif
+
+#ifndef __HAVE_ARCH_MEMZERO_PAGE_CHECK
+/**
+ * memzero_page_check - Check whether a page contains only zeroes
+ * @addr: The page-aligned address of the page
+ *
+ * returns true if all %PAGE_SIZE bytes at @addr are zero.
+ */
+bool memzero_page_check(const void *addr)
+{
+	const u64 *p = addr;
+	unsigned int i;
+
+	for (i = 0; i < PAGE_SIZE / sizeof(*p); i += 4)
+		if (p[i] | p[i + 1] | p[i + 2] | p[i + 3])
+			return false;
+
+	return true;
+}
+#endif
+
 /**
  * strreplace - Replace all occurrences of character in string.
  * @s: The string to operate on.
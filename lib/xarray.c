@@ -335,8 +335,10 @@ static void *xas_alloc(struct xa_state *xas, unsigned int shift)
 	if (node) {
 		xas->xa_alloc = NULL;
 	} else {
-		node = kmem_cache_alloc(radix_tree_node_cachep,
-					GFP_KERNEL | __GFP_NOWARN);
+		node = radix_tree_node_cache_get();
+		if (!node)
+			node = kmem_cache_alloc(radix_tree_node_cachep,
+						GFP_KERNEL | __GFP_NOWARN);
 		if (!node) {
 			xas_set_err(xas, -ENOMEM);
 			return NULL;
@@ -1232,6 +1234,61 @@ void *xa_load(struct xarray *xa, u64 index)
 	return entry;
 }
 
+/**
+ * xa_load_batch() - Load the entries at a run of consecutive indices.
+ * @xa: XArray.
+ * @start: First index to load.
+ * @dst: Array to copy the entries into.
+ * @nr: Maximum number of entries to copy.
+ *
+ * Copies the entries at @start, @start + 1, ... into @dst, stopping at the
+ * first index which has no entry or after @nr entries.  Unlike calling
+ * xa_load() in a loop, the tree is only walked from the root once; after
+ * that each index is the next slot of the current node.  A multi-index
+ * entry is copied once for every index it covers.
+ *
+ * Context: Any context.  Takes and releases the RCU lock.
+ * Return: The number of entries copied into @dst.
+ */
+unsigned int xa_load_batch(struct xarray *xa, u64 start, void **dst,
+		unsigned int nr)
+{
+	XA_STATE(xas, xa, start);
+	unsigned int i = 0;
+	void *entry;
+
+	if (!nr)
+		return 0;
+
+	rcu_read_lock();
+	entry = XA_RETRY_ENTRY;
+	for (;;) {
+		if (xa_is_retry(entry)) {
+			xas_reset(&xas);
+			entry = xas_load(&xas);
+			/*
+			 * xas_load() leaves the offset on the head slot of a
+			 * multi-index entry; xas_next() wants it to follow
+			 * xa_index.
+			 */
+			if (xas_is_node(&xas))
+				xas_set_offset(&xas);
+			continue;
+		}
+		if (xa_is_sibling(entry))
+			entry = xa_entry(xa, xas.xa_node, xa_to_sibling(entry));
+		if (!entry || xa_is_zero(entry))
+			break;
+		dst[i++] = entry;
+		if (i == nr || xas.xa_index == ULONG_MAX)
+			break;
+		entry = xas_next(&xas);
+	}
+	rcu_read_unlock();
+
+	return i;
+}
+
 static void *xas_result(struct xa_state *xas, void *curr)
 {
 	if (xa_is_zero(curr))
@@ -1345,6 +1402,102 @@ void *xa_store(struct xarray *xa, u64 index, void *entry, gfp_t gfp)
 	return curr;
 }
 
+#ifdef CONFIG_XARRAY_MULTI
+static inline u64 xas_size(const struct xa_state *xas)
+{
+	return (xas->xa_sibs + 1ULL) << xas->xa_shift;
+}
+
+/*
+ * Set up @xas for the largest naturally aligned entry which starts at
+ * @first and does not extend past @last.
+ */
+static void xas_set_range(struct xa_state *xas, u64 first, u64 last)
+{
+	unsigned int shift = 0;
+	u64 sibs = last - first;
+	unsigned int offset = XA_CHUNK_MASK;
+
+	xas_set(xas, first);
+
+	while ((first & XA_CHUNK_MASK) == 0) {
+		if (sibs < XA_CHUNK_MASK)
+			break;
+		if ((sibs == XA_CHUNK_MASK) && (offset < XA_CHUNK_MASK))
+			break;
+		shift += XA_CHUNK_SHIFT;
+		if (offset == XA_CHUNK_MASK)
+			offset = sibs & XA_CHUNK_MASK;
+		sibs >>= XA_CHUNK_SHIFT;
+		first >>= XA_CHUNK_SHIFT;
+	}
+
+	offset = first & XA_CHUNK_MASK;
+	if (offset + sibs > XA_CHUNK_MASK)
+		sibs = XA_CHUNK_MASK - offset;
+	if ((((first + sibs + 1) << shift) - 1) > last)
+		sibs -= 1;
+
+	xas->xa_shift = shift;
+	xas->xa_sibs = sibs;
+}
+
+/**
+ * xa_store_range() - Store this entry at a range of indices in the XArray.
+ * @xa: XArray.
+ * @first: First index to affect.
+ * @last: Last index to affect.
+ * @entry: New entry.
+ * @gfp: Memory allocation flags.
+ *
+ * After this function returns, loads from any index between @first and @last,
+ * inclusive will return @entry.  The range is covered by as few multi-index
+ * entries as its alignment allows, so an aligned range of 2^N indices takes
+ * one slot and its siblings rather than 2^N slots.
+ * Storing into an existing multislot entry updates the entry of every index.
+ * The marks associated with @index are unaffected unless @entry is %NULL.
+ *
+ * Context: Process context.  Takes and releases the xa_lock.  May sleep
+ * if the @gfp flags permit.
+ * Return: %NULL on success, xa_err(-EINVAL) if @entry cannot be stored in
+ * an XArray, or xa_err(-ENOMEM) if memory allocation failed.
+ */
+void *xa_store_range(struct xarray *xa, u64 first, u64 last,
+		void *entry, gfp_t gfp)
+{
+	XA_STATE(xas, xa, 0);
+
+	if (WARN_ON_ONCE(xa_is_internal(entry)))
+		return XA_ERROR(-EINVAL);
+	if (last < first)
+		return XA_ERROR(-EINVAL);
+
+	do {
+		xas_lock(&xas);
+		if (entry) {
+			unsigned int order = BITS_PER_LONG;
+			if (last + 1)
+				order = __ffs(last + 1);
+			xas_set_order(&xas, last, order);
+			xas_create(&xas, true);
+			if (xas_error(&xas))
+				goto unlock;
+		}
+		do {
+			xas_set_range(&xas, first, last);
+			xas_store(&xas, entry);
+			if (xas_error(&xas))
+				goto unlock;
+			first += xas_size(&xas);
+		} while (first <= last && first);
+unlock:
+		xas_unlock(&xas);
+	} while (xas_nomem(&xas, gfp));
+
+	return xas_result(&xas, NULL);
+}
+#endif /* CONFIG_XARRAY_MULTI */
+
 /**
  * __xa_cmpxchg() - Store this entry in the XArray.
  * @xa: XArray.
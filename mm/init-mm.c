@@ -25,5 +25,6 @@
 struct mm_struct init_mm = {
 	.mm_rb		= RB_ROOT,
 	.pgd		= swapper_pg_dir,
+	.page_table_lock = __SPIN_LOCK_UNLOCKED(init_mm.page_table_lock),
 	INIT_MM_CONTEXT(init_mm)
 };
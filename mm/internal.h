@@ -32,4 +32,12 @@ static inline void set_page_refcounted(struct page *page)
 	set_page_count(page, 1);
 }
 
+/*
+ * Allocate the next level of table under an empty entry of @mm, which may
+ * be &init_mm. Return 0 if the entry is populated afterwards.
+ */
+int __pud_alloc(struct mm_struct *mm, pgd_t *pgdp);
+int __pmd_alloc(struct mm_struct *mm, pud_t *pudp);
+int __pte_alloc(struct mm_struct *mm, pmd_t *pmdp);
+
 #endif /* !__MM_INTERNAL_H_ */
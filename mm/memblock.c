@@ -12,6 +12,9 @@
 #include <linux/kernel.h>
 #include <linux/memblock.h>
 #include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/page.h>
+#include <linux/pfn.h>
 #include <linux/slab.h>
 #include <linux/cache.h>
 
@@ -1472,6 +1475,71 @@ void __init_memblock __memblock_dump_all(void)
 	memblock_dump(&memblock.reserved);
 }
 
+static void __init reserve_bootmem_region(phys_addr_t start, phys_addr_t end)
+{
+	u64 start_pfn = PFN_DOWN(start);
+	u64 end_pfn = PFN_UP(end);
+
+	for (; start_pfn < end_pfn; start_pfn++)
+		if (pfn_valid(start_pfn))
+			__SetPageReserved(pfn_to_page(start_pfn));
+}
+
+static void __init __free_pages_memory(u64 start, u64 end)
+{
+	int order;
+
+	while (start < end) {
+		order = min_t(u64, MAX_ORDER - 1, __ffs(start));
+
+		while (start + (1UL << order) > end)
+			order--;
+
+		memblock_free_pages(pfn_to_page(start), start, order);
+
+		start += (1UL << order);
+	}
+}
+
+static u64 __init __free_memory_core(phys_addr_t start, phys_addr_t end)
+{
+	u64 start_pfn = PFN_UP(start);
+	u64 end_pfn = min_t(u64, PFN_DOWN(end), max_pfn);
+
+	if (start_pfn >= end_pfn)
+		return 0;
+
+	__free_pages_memory(start_pfn, end_pfn);
+
+	return end_pfn - start_pfn;
+}
+
+/**
+ * memblock_free_all - release free pages to the buddy allocator
+ *
+ * Marks every reserved region PageReserved and hands the rest of
+ * memblock.memory to the page allocator. memblock allocations are not
+ * possible once this has run.
+ */
+void __init memblock_free_all(void)
+{
+	phys_addr_t start, end;
+	struct zone *zone;
+	u64 i, count = 0;
+
+	/* memblock_free_pages() accounts each page again */
+	for_each_zone(zone)
+		atomic_long_set(&zone->managed_pages, 0);
+
+	for_each_reserved_mem_region(i, &start, &end)
+		reserve_bootmem_region(start, end);
+
+	for_each_free_mem_range(i, MEMBLOCK_NONE, &start, &end)
+		count += __free_memory_core(start, end);
+
+	pr_info("Memory: %lluK available\n", count << (PAGE_SHIFT - 10));
+}
+
 void __init memblock_allow_resize(void)
 {
 	memblock_can_resize = 1;
@@ -0,0 +1,365 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ *  linux/mm/memory.c
+ *
+ *  Copyright (C) 1991, 1992, 1993, 1994  Linus Torvalds
+ */
+
+/*
+ * Filling in page tables.
+ *
+ * There are no vmas: the servers that own an address space decide what
+ * goes where, and the kernel only installs and removes translations.
+ * Intermediate tables are allocated on demand, for user address spaces
+ * and for init_mm's vmalloc area alike, and never freed while the mm
+ * lives. A translation is only ever installed over an empty entry, so
+ * installing needs no TLB maintenance; removing does.
+ *
+ * Pages shared read-only but meant to be written, like the .data of a
+ * program mapped straight from the initrd, carry PTE_COW. The first write
+ * faults, and do_wp_page() gives the writer its own copy.
+ */
+
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/gfp.h>
+#include <linux/mm.h>
+#include <linux/mm_types.h>
+#include <linux/page-flags.h>
+#include <linux/spinlock.h>
+
+#include <asm/cacheflush.h>
+#include <asm/page.h>
+#include <asm/pgalloc.h>
+#include <asm/pgtable.h>
+#include <asm/processor.h>
+#include <asm/tlbflush.h>
+
+#include "internal.h"
+
+/*
+ * Allocate the table an empty entry will point to. The table is zeroed
+ * before the entry is published, so a concurrent walker sees either no
+ * table or an empty one.
+ */
+static phys_addr_t user_pgtable_alloc(void)
+{
+	u64 table = get_zeroed_page(GFP_KERNEL);
+
+	return table ? __pa(table) : 0;
+}
+
+int __pud_alloc(struct mm_struct *mm, pgd_t *pgdp)
+{
+	phys_addr_t table = user_pgtable_alloc();
+
+	if (!table)
+		return -ENOMEM;
+
+	spin_lock(&mm->page_table_lock);
+	if (pgd_none(READ_ONCE(*pgdp))) {
+		__pgd_populate(pgdp, table, PUD_TYPE_TABLE);
+		table = 0;
+	}
+	spin_unlock(&mm->page_table_lock);
+
+	if (table)	/* Another thread populated it */
+		free_page((u64)__va(table));
+	return 0;
+}
+
+int __pmd_alloc(struct mm_struct *mm, pud_t *pudp)
+{
+	phys_addr_t table = user_pgtable_alloc();
+
+	if (!table)
+		return -ENOMEM;
+
+	spin_lock(&mm->page_table_lock);
+	if (pud_none(READ_ONCE(*pudp))) {
+		__pud_populate(pudp, table, PMD_TYPE_TABLE);
+		table = 0;
+	}
+	spin_unlock(&mm->page_table_lock);
+
+	if (table)
+		free_page((u64)__va(table));
+	return 0;
+}
+
+int __pte_alloc(struct mm_struct *mm, pmd_t *pmdp)
+{
+	phys_addr_t table = user_pgtable_alloc();
+
+	if (!table)
+		return -ENOMEM;
+
+	spin_lock(&mm->page_table_lock);
+	if (pmd_none(READ_ONCE(*pmdp))) {
+		__pmd_populate(pmdp, table, PMD_TYPE_TABLE);
+		table = 0;
+	}
+	spin_unlock(&mm->page_table_lock);
+
+	if (table)
+		free_page((u64)__va(table));
+	return 0;
+}
+
+static pte_t *user_pte_alloc(struct mm_struct *mm, u64 addr)
+{
+	pgd_t *pgdp = pgd_offset(mm, addr);
+	pud_t *pudp;
+	pmd_t *pmdp;
+
+	if (pgd_none(READ_ONCE(*pgdp)) && __pud_alloc(mm, pgdp))
+		return NULL;
+	pudp = pud_offset(pgdp, addr);
+
+	if (pud_none(READ_ONCE(*pudp)) && __pmd_alloc(mm, pudp))
+		return NULL;
+	pmdp = pmd_offset(pudp, addr);
+
+	if (pmd_none(READ_ONCE(*pmdp)) && __pte_alloc(mm, pmdp))
+		return NULL;
+	return pte_offset_kernel(pmdp, addr);
+}
+
+/**
+ * user_pte_lookup - find the page table entry for a user address
+ * @mm: the address space
+ * @addr: the address
+ *
+ * Return: the entry, or NULL if there is no last level table for @addr.
+ */
+pte_t *user_pte_lookup(struct mm_struct *mm, u64 addr)
+{
+	pgd_t *pgdp = pgd_offset(mm, addr);
+	pud_t *pudp;
+	pmd_t *pmdp;
+
+	if (pgd_none(READ_ONCE(*pgdp)))
+		return NULL;
+	pudp = pud_offset(pgdp, addr);
+
+	if (pud_none(READ_ONCE(*pudp)))
+		return NULL;
+	pmdp = pmd_offset(pudp, addr);
+
+	if (pmd_none(READ_ONCE(*pmdp)))
+		return NULL;
+	return pte_offset_kernel(pmdp, addr);
+}
+
+static inline bool user_range_ok(u64 addr, u64 size)
+{
+	return !((addr | size) & ~PAGE_MASK) && size &&
+	       addr < TASK_SIZE && size <= TASK_SIZE - addr;
+}
+
+/**
+ * map_user_pfn_range - map physically contiguous pages into user space
+ * @mm: the address space
+ * @addr: page aligned user address to map at
+ * @pfn: first page frame to map
+ * @size: page aligned size of the range
+ * @prot: protection and memory attributes, e.g. PAGE_SHARED
+ *
+ * Every page in the range must be unmapped. On failure nothing in the
+ * range is left mapped.
+ *
+ * Return: 0, -EINVAL for a bad range, -EBUSY if a page in it is already
+ * mapped, or -ENOMEM.
+ */
+int map_user_pfn_range(struct mm_struct *mm, u64 addr, u64 pfn, u64 size,
+		       pgprot_t prot)
+{
+	u64 start = addr, end = addr + size;
+	pte_t *ptep;
+	int ret = 0;
+
+	if (!user_range_ok(addr, size))
+		return -EINVAL;
+
+	for (; addr != end; addr += PAGE_SIZE, pfn++) {
+		ptep = user_pte_alloc(mm, addr);
+		if (!ptep) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		spin_lock(&mm->page_table_lock);
+		if (pte_none(READ_ONCE(*ptep)))
+			set_pte(ptep, pfn_pte(pfn, prot));
+		else
+			ret = -EBUSY;
+		spin_unlock(&mm->page_table_lock);
+
+		if (ret)
+			break;
+	}
+
+	if (ret && addr != start)
+		unmap_user_range(mm, start, addr - start);
+	return ret;
+}
+
+/**
+ * unmap_user_range - remove user mappings
+ * @mm: the address space
+ * @addr: page aligned user address
+ * @size: page aligned size of the range
+ *
+ * Pages in the range that are not mapped are skipped. The pages that
+ * were mapped are not freed.
+ */
+void unmap_user_range(struct mm_struct *mm, u64 addr, u64 size)
+{
+	u64 end = addr + size;
+	pte_t *ptep;
+
+	if (!user_range_ok(addr, size))
+		return;
+
+	spin_lock(&mm->page_table_lock);
+	for (; addr != end; addr += PAGE_SIZE) {
+		ptep = user_pte_lookup(mm, addr);
+		if (ptep)
+			pte_clear(mm, addr, ptep);
+	}
+	spin_unlock(&mm->page_table_lock);
+
+	flush_tlb_mm(mm);
+}
+
+static void free_pte_table(pmd_t *pmdp, bool free_mapped)
+{
+	pte_t *table = pte_offset_kernel(pmdp, 0UL);
+	unsigned int i;
+
+	for (i = 0; free_mapped && i < PTRS_PER_PTE; i++) {
+		pte_t pte = READ_ONCE(table[i]);
+		struct page *page;
+
+		if (!pte_valid(pte))
+			continue;
+		page = pte_page(pte);
+		if (!PageReserved(page))
+			__free_page(page);
+	}
+	free_page((u64)table);
+}
+
+static void free_pmd_table(struct mm_struct *mm, pud_t *pudp, u64 addr,
+			   u64 end, bool free_mapped)
+{
+	pmd_t *table = pmd_offset(pudp, 0UL);
+	pmd_t *pmdp = pmd_offset(pudp, addr);
+	u64 next;
+
+	do {
+		next = pmd_addr_end(addr, end);
+		if (!pmd_none(READ_ONCE(*pmdp)))
+			free_pte_table(pmdp, free_mapped);
+	} while (pmdp++, addr = next, addr != end);
+
+#if CONFIG_PGTABLE_LEVELS > 2
+	pmd_free(mm, table);
+#endif
+}
+
+static void free_pud_table(struct mm_struct *mm, pgd_t *pgdp, u64 addr,
+			   u64 end, bool free_mapped)
+{
+	pud_t *table = pud_offset(pgdp, 0UL);
+	pud_t *pudp = pud_offset(pgdp, addr);
+	u64 next;
+
+	do {
+		next = pud_addr_end(addr, end);
+		if (!pud_none(READ_ONCE(*pudp)))
+			free_pmd_table(mm, pudp, addr, next, free_mapped);
+	} while (pudp++, addr = next, addr != end);
+
+#if CONFIG_PGTABLE_LEVELS > 3
+	pud_free(mm, table);
+#endif
+}
+
+/**
+ * free_user_pgtables - free the user page tables of an address space
+ * @mm: an address space no thread has run in
+ * @free_mapped: also free the pages mapped, other than reserved ones
+ *
+ * The pgd itself is left to pgd_free(). Pages are not reference counted,
+ * so @free_mapped is only for an address space whose pages were all
+ * allocated for it alone, such as one built for a boot service that then
+ * failed to load. The initrd and kernel image pages it may share with
+ * others are reserved and stay.
+ */
+void free_user_pgtables(struct mm_struct *mm, bool free_mapped)
+{
+	u64 addr = 0, end = TASK_SIZE;
+	pgd_t *pgdp = pgd_offset(mm, addr);
+	u64 next;
+
+	do {
+		next = pgd_addr_end(addr, end);
+		if (!pgd_none(READ_ONCE(*pgdp)))
+			free_pud_table(mm, pgdp, addr, next, free_mapped);
+	} while (pgdp++, addr = next, addr != end);
+}
+
+/**
+ * do_wp_page - give a writer its own copy of a copy-on-write page
+ * @mm: the address space
+ * @addr: the address written to
+ *
+ * Return: 0 if the page at @addr is now private and writable, -EFAULT if
+ * it is not a copy-on-write page, or -ENOMEM.
+ */
+int do_wp_page(struct mm_struct *mm, u64 addr)
+{
+	struct page *page;
+	pte_t *ptep;
+	pte_t pte;
+
+	addr &= PAGE_MASK;
+	if (addr >= TASK_SIZE)
+		return -EFAULT;
+
+	ptep = user_pte_lookup(mm, addr);
+	if (!ptep)
+		return -EFAULT;
+
+	pte = READ_ONCE(*ptep);
+	if (!pte_valid(pte) || !(pte_val(pte) & PTE_COW))
+		return -EFAULT;
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+	copy_page(page_to_virt(page), __va(PFN_PHYS(pte_pfn(pte))));
+	/* The copy is only in the D-cache; the thread may execute from it */
+	if (pte_user_exec(pte))
+		__flush_icache_range((u64)page_to_virt(page),
+				     (u64)page_to_virt(page) + PAGE_SIZE);
+
+	spin_lock(&mm->page_table_lock);
+	if (pte_val(READ_ONCE(*ptep)) == pte_val(pte)) {
+		pgprot_t prot = __pgprot((pte_val(pte) & ~PTE_ADDR_MASK &
+					  ~(PTE_RDONLY | PTE_COW)) | PTE_WRITE);
+
+		/* The output address changes: break before make */
+		pte_clear(mm, addr, ptep);
+		flush_tlb_mm(mm);
+		set_pte(ptep, pfn_pte(page_to_pfn(page), prot));
+		page = NULL;
+	}
+	spin_unlock(&mm->page_table_lock);
+
+	/* Another thread of @mm got there first */
+	if (page)
+		__free_page(page);
+	return 0;
+}
@@ -703,13 +703,11 @@ void prep_compound_page(struct page *page, unsigned int order)
 
 static void prep_new_page(struct page *page, unsigned int order, gfp_t gfp_flags)
 {
-	int i;
-
 	post_alloc_hook(page, order, gfp_flags);
 
+	/* Buddy pages are physically, and so linearly, contiguous */
 	if (gfp_flags & __GFP_ZERO)
-		for (i = 0; i < (1 << order); i++)
-			clear_page(page_address(page + i));
+		clear_pages(page_address(page), 1 << order);
 
 	if (order)
 		prep_compound_page(page, order);
@@ -792,6 +790,33 @@ void __free_pages(struct page *page, unsigned int order)
 		free_the_page(page, order);
 }
 
+/*
+ * Drop a reference on each 0-order page in @pages and hand the ones that
+ * became free to the per-cpu lists, disabling interrupts once for the
+ * whole batch rather than once per page.
+ */
+void release_pages(struct page **pages, int nr)
+{
+	u64 flags;
+	int i;
+
+	local_irq_save(flags);
+	for (i = 0; i < nr; i++) {
+		struct page *page = pages[i];
+		u64 pfn;
+
+		if (!put_page_testzero(page))
+			continue;
+
+		pfn = page_to_pfn(page);
+		if (!free_unref_page_prepare(page, pfn))
+			continue;
+
+		free_unref_page_commit(page, pfn);
+	}
+	local_irq_restore(flags);
+}
+
 void free_pages(u64 addr, unsigned int order)
 {
 	if (addr != 0) {
@@ -81,6 +81,7 @@
 #include <asm/sections.h>
 #include <asm/cacheflush.h>
 #include <asm/tlbflush.h>
+#include <asm/tlb.h>
 #include <asm/pgtable.h>
 
 #include "percpu-internal.h"
@@ -1559,9 +1560,10 @@ static struct page *pcpu_chunk_page(struct pcpu_chunk *chunk,
 	return vmalloc_to_page((void *)pcpu_chunk_addr(chunk, cpu, page_idx));
 }
 
-static void __pcpu_unmap_pages(u64 addr, int nr_pages)
+static void __pcpu_unmap_pages(struct mmu_gather *tlb, u64 addr,
+			       int nr_pages)
 {
-	unmap_kernel_range_noflush(addr, nr_pages << PAGE_SHIFT);
+	unmap_kernel_range_gather(tlb, addr, nr_pages << PAGE_SHIFT);
 }
 
 /**
@@ -1590,8 +1592,38 @@ static void pcpu_free_pages(struct pcpu_chunk *chunk,
 	}
 }
 
+/**
+ * pcpu_gather_free_pages - queue pages of @chunk for freeing after the flush
+ * @tlb: gather the pages were unmapped under
+ * @chunk: chunk pages were allocated for
+ * @pages: array of pages to be freed, indexed by pcpu_page_idx()
+ * @page_start: page index of the first page to be freed
+ * @page_end: page index of the last page to be freed + 1
+ *
+ * Like pcpu_free_pages(), but the pages are handed back in bulk by
+ * tlb_finish_mmu() once no stale translation to them can remain.
+ */
+static void pcpu_gather_free_pages(struct mmu_gather *tlb,
+				   struct pcpu_chunk *chunk,
+				   struct page **pages,
+				   int page_start, int page_end)
+{
+	unsigned int cpu;
+	int i;
+
+	for_each_possible_cpu(cpu) {
+		for (i = page_start; i < page_end; i++) {
+			struct page *page = pages[pcpu_page_idx(cpu, i)];
+
+			if (page)
+				tlb_remove_page(tlb, page);
+		}
+	}
+}
+
 /**
  * pcpu_unmap_pages - unmap pages out of a pcpu_chunk
+ * @tlb: gather collecting the unmapped ranges
  * @chunk: chunk of interest
  * @pages: pages array which can be used to pass information to free
  * @page_start: page index of the first page to unmap
@@ -1599,11 +1631,11 @@ static void pcpu_free_pages(struct pcpu_chunk *chunk,
  *
  * For each cpu, unmap pages [@page_start,@page_end) out of @chunk.
  * Corresponding elements in @pages were cleared by the caller and can
- * be used to carry information to pcpu_free_pages() which will be
- * called after all unmaps are finished.  The caller should call
- * proper pre/post flush functions.
+ * be used to carry information to pcpu_gather_free_pages() which will
+ * be called after all unmaps are finished.  The caller should call
+ * pcpu_pre_unmap_flush() before and finish @tlb after.
  */
-static void pcpu_unmap_pages(struct pcpu_chunk *chunk,
+static void pcpu_unmap_pages(struct mmu_gather *tlb, struct pcpu_chunk *chunk,
 			     struct page **pages, int page_start, int page_end)
 {
 	unsigned int cpu;
@@ -1617,7 +1649,7 @@ static void pcpu_unmap_pages(struct pcpu_chunk *chunk,
 			WARN_ON(!page);
 			pages[pcpu_page_idx(cpu, i)] = page;
 		}
-		__pcpu_unmap_pages(pcpu_chunk_addr(chunk, cpu, page_start),
+		__pcpu_unmap_pages(tlb, pcpu_chunk_addr(chunk, cpu, page_start),
 				   page_end - page_start);
 	}
 }
@@ -1637,6 +1669,7 @@ static void pcpu_unmap_pages(struct pcpu_chunk *chunk,
 static void pcpu_depopulate_chunk(struct pcpu_chunk *chunk,
 				  int page_start, int page_end)
 {
+	struct mmu_gather tlb;
 	struct page **pages;
 
 	/*
@@ -1650,11 +1683,17 @@ static void pcpu_depopulate_chunk(struct pcpu_chunk *chunk,
 	/* unmap and free */
 	pcpu_pre_unmap_flush(chunk, page_start, page_end);
 
-	pcpu_unmap_pages(chunk, pages, page_start, page_end);
-
-	/* no need to flush tlb, vmalloc will handle it lazily */
-
-	pcpu_free_pages(chunk, pages, page_start, page_end);
+	/*
+	 * Every unit's slice is unmapped into the same gather, so the whole
+	 * depopulation costs one invalidation over the chunk and the pages
+	 * are only returned to the allocator after it.
+	 */
+	tlb_gather_mmu(&tlb, &init_mm,
+		       pcpu_chunk_addr(chunk, pcpu_low_unit_cpu, page_start),
+		       pcpu_chunk_addr(chunk, pcpu_high_unit_cpu, page_end));
+	pcpu_unmap_pages(&tlb, chunk, pages, page_start, page_end);
+	pcpu_gather_free_pages(&tlb, chunk, pages, page_start, page_end);
+	tlb_finish_mmu(&tlb);
 }
 
 /**
@@ -1760,27 +1799,6 @@ static int __pcpu_map_pages(u64 addr, struct page **pages,
 					PAGE_KERNEL, pages);
 }
 
-/**
- * pcpu_post_unmap_tlb_flush - flush TLB after unmapping
- * @chunk: pcpu_chunk the regions to be flushed belong to
- * @page_start: page index of the first page to be flushed
- * @page_end: page index of the last page to be flushed + 1
- *
- * Pages [@page_start,@page_end) of @chunk have been unmapped.  Flush
- * TLB for the regions.  This can be skipped if the area is to be
- * returned to vmalloc as vmalloc will handle TLB flushing lazily.
- *
- * As with pcpu_pre_unmap_flush(), TLB flushing also is done at once
- * for the whole region.
- */
-static void pcpu_post_unmap_tlb_flush(struct pcpu_chunk *chunk,
-				      int page_start, int page_end)
-{
-	flush_tlb_kernel_range(
-		pcpu_chunk_addr(chunk, pcpu_low_unit_cpu, page_start),
-		pcpu_chunk_addr(chunk, pcpu_high_unit_cpu, page_end));
-}
-
 /**
  * pcpu_map_pages - map pages into a pcpu_chunk
  * @chunk: chunk of interest
@@ -1799,6 +1817,7 @@ static int pcpu_map_pages(struct pcpu_chunk *chunk,
 			  struct page **pages, int page_start, int page_end)
 {
 	unsigned int cpu, tcpu;
+	struct mmu_gather tlb;
 	int i, err;
 
 	for_each_possible_cpu(cpu) {
@@ -1814,13 +1833,16 @@ static int pcpu_map_pages(struct pcpu_chunk *chunk,
 	}
 	return 0;
 err:
+	tlb_gather_mmu(&tlb, &init_mm,
+		       pcpu_chunk_addr(chunk, pcpu_low_unit_cpu, page_start),
+		       pcpu_chunk_addr(chunk, pcpu_high_unit_cpu, page_end));
 	for_each_possible_cpu(tcpu) {
 		if (tcpu == cpu)
 			break;
-		__pcpu_unmap_pages(pcpu_chunk_addr(chunk, tcpu, page_start),
+		__pcpu_unmap_pages(&tlb, pcpu_chunk_addr(chunk, tcpu, page_start),
 				   page_end - page_start);
 	}
-	pcpu_post_unmap_tlb_flush(chunk, page_start, page_end);
+	tlb_finish_mmu(&tlb);
 	return err;
 }
 
@@ -42,6 +42,8 @@ struct kmem_cache_node {
 
 	u64 nr_partial;
 	struct list_head partial;
+	atomic64_t nr_slabs;
+	atomic64_t total_objects;
 };
 
 /* Legal flag mask for kmem_cache_create(), for various configurations */
@@ -55,6 +57,18 @@ struct kmem_cache_node {
 			      SLAB_STORE_USER | \
 			      SLAB_CONSISTENCY_CHECKS)
 
+struct slabinfo {
+	u64 active_objs;
+	u64 num_objs;
+	u64 active_slabs;
+	u64 num_slabs;
+	unsigned int objects_per_slab;
+	unsigned int cache_order;
+};
+
+void get_slabinfo(struct kmem_cache *s, struct slabinfo *sinfo);
+void slabinfo_show_stats(struct kmem_cache *s);
+
 static inline struct kmem_cache *slab_pre_alloc_hook(struct kmem_cache *s,
 						     gfp_t flags)
 {
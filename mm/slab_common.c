@@ -455,3 +455,45 @@ bool slab_is_available(void)
 {
 	return slab_state >= UP;
 }
+
+static void print_slabinfo_header(void)
+{
+	pr_info("slabinfo - version: 2.1\n");
+	pr_info("# name            <active_objs> <num_objs> <objsize> <objperslab> <pagesperslab> : slabdata <active_slabs> <num_slabs>\n");
+}
+
+static void cache_show(struct kmem_cache *s)
+{
+	struct slabinfo sinfo;
+
+	memset(&sinfo, 0, sizeof(sinfo));
+	get_slabinfo(s, &sinfo);
+
+	pr_info("%-17s %6llu %6llu %6u %4u %4d : slabdata %6llu %6llu\n",
+		s->name, sinfo.active_objs, sinfo.num_objs, s->size,
+		sinfo.objects_per_slab, (1 << sinfo.cache_order),
+		sinfo.active_slabs, sinfo.num_slabs);
+
+	slabinfo_show_stats(s);
+}
+
+/*
+ * Print one slabinfo line per cache to the console, followed by the
+ * cache's non-zero allocator counters when CONFIG_SLUB_STATS is set.
+ * Gives up rather than blocking if a cache is being created concurrently.
+ */
+void dump_slabinfo(void)
+{
+	struct kmem_cache *s;
+
+	if (!mutex_trylock(&slab_mutex)) {
+		pr_warn("excessive slab contention, skipping slabinfo dump\n");
+		return;
+	}
+
+	print_slabinfo_header();
+	list_for_each_entry(s, &slab_caches, list)
+		cache_show(s);
+
+	mutex_unlock(&slab_mutex);
+}
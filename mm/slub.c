@@ -54,6 +54,23 @@ early_param("slub_min_objects", setup_slub_min_objects);
 
 #define SLAB_NO_CMPXCHG (SLAB_CONSISTENCY_CHECKS | SLAB_STORE_USER)
 
+#define SLAB_DEBUG_FLAGS (SLAB_POISON | SLAB_STORE_USER | \
+				SLAB_CONSISTENCY_CHECKS)
+
+static inline int kmem_cache_debug(struct kmem_cache *s)
+{
+	return unlikely(s->flags & SLAB_DEBUG_FLAGS);
+}
+
+static inline bool kmem_cache_has_cpu_partial(struct kmem_cache *s)
+{
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	return !kmem_cache_debug(s);
+#else
+	return false;
+#endif
+}
+
 #define OO_SHIFT	16
 #define OO_MASK		((1 << OO_SHIFT) - 1)
 #define MAX_OBJS_PER_PAGE	32767 /* since page.objects is u15 */
@@ -64,6 +81,13 @@ early_param("slub_min_objects", setup_slub_min_objects);
 /* Use cmpxchg_double */
 #define __CMPXCHG_DOUBLE	((slab_flags_t __force)0x40000000U)
 
+static inline void stat(const struct kmem_cache *s, enum stat_item si)
+{
+#ifdef CONFIG_SLUB_STATS
+	this_cpu_inc(s->cpu_slab->stat[si]);
+#endif
+}
+
 static inline unsigned int order_objects(unsigned int order, unsigned int size)
 {
 	return ((unsigned int)PAGE_SIZE << order) / size;
@@ -256,6 +280,35 @@ static void set_min_partial(struct kmem_cache *s, u64 min)
 
 static void set_cpu_partial(struct kmem_cache *s)
 {
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	/*
+	 * cpu_partial determined the maximum number of objects kept in the
+	 * per cpu partial lists of a processor.
+	 *
+	 * Per cpu partial lists mainly contain slabs that just have one
+	 * object freed. If they are used for allocation then they can be
+	 * filled up again with minimal effort. The slab will never hit the
+	 * per node partial lists and therefore no locking will be required.
+	 *
+	 * This setting also determines
+	 *
+	 * A) The number of objects from per cpu partial slabs dumped to the
+	 *    per node list when we reach the limit.
+	 * B) The number of objects in cpu partial slabs to extract from the
+	 *    per node list when we run out of per cpu objects. We only fetch
+	 *    50% to keep some capacity around for frees.
+	 */
+	if (!kmem_cache_has_cpu_partial(s))
+		slub_set_cpu_partial(s, 0);
+	else if (s->size >= PAGE_SIZE)
+		slub_set_cpu_partial(s, 2);
+	else if (s->size >= 1024)
+		slub_set_cpu_partial(s, 6);
+	else if (s->size >= 256)
+		slub_set_cpu_partial(s, 13);
+	else
+		slub_set_cpu_partial(s, 30);
+#endif
 }
 
 static inline struct page *alloc_slab_page(struct kmem_cache *s,
@@ -325,6 +378,30 @@ static inline void *get_freepointer_safe(struct kmem_cache *s, void *object)
 	return get_freepointer(s, object);
 }
 
+static inline void inc_slabs_node(struct kmem_cache *s, int objects)
+{
+	struct kmem_cache_node *n = s->node;
+
+	/*
+	 * May be called early in order to allocate a slab for the
+	 * kmem_cache_node structure. Solve the chicken-egg
+	 * dilemma by deferring the increment of the count during
+	 * bootstrap (see early_kmem_cache_node_alloc).
+	 */
+	if (likely(n)) {
+		atomic64_inc(&n->nr_slabs);
+		atomic64_add(objects, &n->total_objects);
+	}
+}
+
+static inline void dec_slabs_node(struct kmem_cache *s, int objects)
+{
+	struct kmem_cache_node *n = s->node;
+
+	atomic64_dec(&n->nr_slabs);
+	atomic64_sub(objects, &n->total_objects);
+}
+
 static struct page *allocate_slab(struct kmem_cache *s, gfp_t flags)
 {
 	struct page *page;
@@ -353,6 +430,7 @@ static struct page *allocate_slab(struct kmem_cache *s, gfp_t flags)
 		page = alloc_slab_page(s, alloc_gfp, oo);
 		if (unlikely(!page))
 			goto out;
+		stat(s, ORDER_FALLBACK);
 	}
 
 	page->objects = oo_objects(oo);
@@ -381,6 +459,7 @@ static struct page *allocate_slab(struct kmem_cache *s, gfp_t flags)
 	page->inuse = page->objects;
 	page->frozen = 1;
 
+	inc_slabs_node(s, page->objects);
 out:
 	return page;
 }
@@ -398,6 +477,8 @@ init_kmem_cache_node(struct kmem_cache_node *n)
 	n->nr_partial = 0;
 	spin_lock_init(&n->list_lock);
 	INIT_LIST_HEAD(&n->partial);
+	atomic64_set(&n->nr_slabs, 0);
+	atomic64_set(&n->total_objects, 0);
 }
 
 static inline void
@@ -441,6 +522,7 @@ static void early_kmem_cache_node_alloc(void)
 	page->frozen = 0;
 	kmem_cache_node->node = n;
 	init_kmem_cache_node(n);
+	inc_slabs_node(kmem_cache_node, page->objects);
 
 	/*
 	 * No locks need to be taken here as it has just been
@@ -478,6 +560,7 @@ static inline bool __cmpxchg_double_slab(struct kmem_cache *s, struct page *page
 	}
 
 	cpu_relax();
+	stat(s, CMPXCHG_DOUBLE_FAIL);
 
 	return false;
 }
@@ -556,6 +639,11 @@ static inline void *acquire_slab(struct kmem_cache *s,
 	return freelist;
 }
 
+static void put_cpu_partial(struct kmem_cache *s, struct page *page, int drain);
+
+/*
+ * Try to allocate a partial slab from a specific node.
+ */
 static void *get_partial_node(struct kmem_cache *s, struct kmem_cache_node *n,
 				struct kmem_cache_cpu *c, gfp_t flags)
 {
@@ -584,9 +672,14 @@ static void *get_partial_node(struct kmem_cache *s, struct kmem_cache_node *n,
 		available += objects;
 		if (!object) {
 			c->page = page;
+			stat(s, ALLOC_FROM_PARTIAL);
 			object = t;
+		} else {
+			put_cpu_partial(s, page, 0);
+			stat(s, CPU_PARTIAL_NODE);
 		}
-		if (available > slub_cpu_partial(s) / 2)
+		if (!kmem_cache_has_cpu_partial(s)
+			|| available > slub_cpu_partial(s) / 2)
 			break;
 
 	}
@@ -628,6 +721,7 @@ static void free_slab(struct kmem_cache *s, struct page *page)
 
 static void discard_slab(struct kmem_cache *s, struct page *page)
 {
+	dec_slabs_node(s, page->objects);
 	free_slab(s, page);
 }
 
@@ -643,8 +737,10 @@ static void deactivate_slab(struct kmem_cache *s, struct page *page,
 	struct page new;
 	struct page old;
 
-	if (page->freelist)
+	if (page->freelist) {
+		stat(s, DEACTIVATE_REMOTE_FREES);
 		tail = DEACTIVATE_TO_TAIL;
+	}
 
 	/*
 	 * Stage one: Free all available per cpu objects back
@@ -740,15 +836,143 @@ redo:
 	if (lock)
 		spin_unlock(&n->list_lock);
 
-	if (m == M_FREE)
+	if (m == M_PARTIAL)
+		stat(s, tail);
+	else if (m == M_FULL)
+		stat(s, DEACTIVATE_FULL);
+	else if (m == M_FREE) {
+		stat(s, DEACTIVATE_EMPTY);
 		discard_slab(s, page);
+		stat(s, FREE_SLAB);
+	}
 
 	c->page = NULL;
 	c->freelist = NULL;
 }
 
+/*
+ * Unfreeze all the cpu partial slabs.
+ *
+ * This function must be called with interrupts disabled
+ * for the cpu using c (or some other guarantee must be there
+ * to guarantee no concurrent accesses).
+ */
+static void unfreeze_partials(struct kmem_cache *s,
+		struct kmem_cache_cpu *c)
+{
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	struct kmem_cache_node *n = s->node;
+	struct page *page, *discard_page = NULL;
+
+	if (!c->partial)
+		return;
+
+	spin_lock(&n->list_lock);
+	while ((page = c->partial)) {
+		struct page new;
+		struct page old;
+
+		c->partial = page->next;
+
+		do {
+
+			old.freelist = page->freelist;
+			old.counters = page->counters;
+			BUG_ON(!old.frozen);
+
+			new.counters = old.counters;
+			new.freelist = old.freelist;
+
+			new.frozen = 0;
+
+		} while (!__cmpxchg_double_slab(s, page,
+				old.freelist, old.counters,
+				new.freelist, new.counters,
+				"unfreezing slab"));
+
+		if (unlikely(!new.inuse && n->nr_partial >= s->min_partial)) {
+			page->next = discard_page;
+			discard_page = page;
+		} else {
+			add_partial(n, page, DEACTIVATE_TO_TAIL);
+			stat(s, FREE_ADD_PARTIAL);
+		}
+	}
+	spin_unlock(&n->list_lock);
+
+	while (discard_page) {
+		page = discard_page;
+		discard_page = discard_page->next;
+
+		stat(s, DEACTIVATE_EMPTY);
+		discard_slab(s, page);
+		stat(s, FREE_SLAB);
+	}
+#endif
+}
+
+/*
+ * Put a page that was just frozen (in __slab_free|get_partial_node) into a
+ * partial page slot if available.
+ *
+ * If we did not find a slot then simply move all the partials to the
+ * per node partial list.
+ */
+static void put_cpu_partial(struct kmem_cache *s, struct page *page, int drain)
+{
+#ifdef CONFIG_SLUB_CPU_PARTIAL
+	struct page *oldpage;
+	int pages;
+	int pobjects;
+
+	preempt_disable();
+	do {
+		pages = 0;
+		pobjects = 0;
+		oldpage = this_cpu_read(s->cpu_slab->partial);
+
+		if (oldpage) {
+			pobjects = oldpage->pobjects;
+			pages = oldpage->pages;
+			if (drain && pobjects > slub_cpu_partial(s)) {
+				u64 flags;
+				/*
+				 * partial array is full. Move the existing
+				 * set to the per node partial list.
+				 */
+				local_irq_save(flags);
+				unfreeze_partials(s, this_cpu_ptr(s->cpu_slab));
+				local_irq_restore(flags);
+				oldpage = NULL;
+				pobjects = 0;
+				pages = 0;
+				stat(s, CPU_PARTIAL_DRAIN);
+			}
+		}
+
+		pages++;
+		pobjects += page->objects - page->inuse;
+
+		page->pages = pages;
+		page->pobjects = pobjects;
+		page->next = oldpage;
+
+	} while (this_cpu_cmpxchg(s->cpu_slab->partial, oldpage, page)
+								!= oldpage);
+	if (unlikely(!slub_cpu_partial(s))) {
+		u64 flags;
+
+		local_irq_save(flags);
+		unfreeze_partials(s, this_cpu_ptr(s->cpu_slab));
+		local_irq_restore(flags);
+	}
+	preempt_enable();
+#endif
+}
+
 static inline void flush_slab(struct kmem_cache *s, struct kmem_cache_cpu *c)
 {
+	stat(s, CPUSLAB_FLUSH);
 	deactivate_slab(s, c->page, c->freelist, c);
 
 	c->tid = next_tid(c->tid);
@@ -770,6 +994,7 @@ static inline void *new_slab_objects(struct kmem_cache *s, gfp_t flags,
 
 	page = new_slab(s, flags);
 	if (page) {
+		stat(s, ALLOC_SLAB);
 		c = this_cpu_ptr(s->cpu_slab);
 		if (c->page)
 			flush_slab(s, c);
@@ -798,6 +1023,7 @@ static void *___slab_alloc(struct kmem_cache *s, gfp_t gfpflags,
 	page = c->page;
 	if (!page)
 		goto new_slab;
+redo:
 
 	/* must check again c->freelist in case of cpu migration or IRQ */
 	freelist = c->freelist;
@@ -808,9 +1034,12 @@ static void *___slab_alloc(struct kmem_cache *s, gfp_t gfpflags,
 
 	if (!freelist) {
 		c->page = NULL;
+		stat(s, DEACTIVATE_BYPASS);
 		goto new_slab;
 	}
 
+	stat(s, ALLOC_REFILL);
+
 load_freelist:
 	/*
 	 * freelist is pointing to the list of objects to be used.
@@ -824,6 +1053,13 @@ load_freelist:
 
 new_slab:
 
+	if (slub_percpu_partial(c)) {
+		page = c->page = slub_percpu_partial(c);
+		slub_set_percpu_partial(c, page);
+		stat(s, CPU_PARTIAL_ALLOC);
+		goto redo;
+	}
+
 	freelist = new_slab_objects(s, gfpflags, &c);
 
 	if (unlikely(!freelist))
@@ -902,6 +1138,7 @@ redo:
 	page = c->page;
 	if (unlikely(!object)) {
 		object = __slab_alloc(s, gfpflags, addr, c);
+		stat(s, ALLOC_SLOWPATH);
 	} else {
 		void *next_object = get_freepointer_safe(s, object);
 
@@ -924,9 +1161,11 @@ redo:
 				object, tid,
 				next_object, next_tid(tid)))) {
 
+			stat(s, CMPXCHG_DOUBLE_CPU_FAIL);
 			goto redo;
 		}
 		prefetch_freepointer(s, next_object);
+		stat(s, ALLOC_FASTPATH);
 	}
 
 	if (unlikely(gfpflags & __GFP_ZERO) && object)
@@ -980,6 +1219,7 @@ static inline bool cmpxchg_double_slab(struct kmem_cache *s, struct page *page,
 	}
 
 	cpu_relax();
+	stat(s, CMPXCHG_DOUBLE_FAIL);
 
 	return false;
 }
@@ -996,6 +1236,8 @@ static void __slab_free(struct kmem_cache *s, struct page *page,
 	struct kmem_cache_node *n = NULL;
 	u64 uninitialized_var(flags);
 
+	stat(s, FREE_SLOWPATH);
+
 	do {
 		if (unlikely(n)) {
 			spin_unlock_irqrestore(&n->list_lock, flags);
@@ -1008,16 +1250,31 @@ static void __slab_free(struct kmem_cache *s, struct page *page,
 		was_frozen = new.frozen;
 		new.inuse -= cnt;
 		if ((!new.inuse || !prior) && !was_frozen) {
-			n = s->node;
-			/*
-				* Speculatively acquire the list_lock.
-				* If the cmpxchg does not succeed then we may
-				* drop the list_lock without any processing.
-				*
-				* Otherwise the list_lock will synchronize with
-				* other processors updating the list of slabs.
-				*/
-			spin_lock_irqsave(&n->list_lock, flags);
+
+			if (kmem_cache_has_cpu_partial(s) && !prior) {
+
+				/*
+				 * Slab was on no list before and will be
+				 * partially empty
+				 * We can defer the list move and instead
+				 * freeze it.
+				 */
+				new.frozen = 1;
+
+			} else { /* Needs to be taken off a list */
+
+				n = s->node;
+				/*
+				 * Speculatively acquire the list_lock.
+				 * If the cmpxchg does not succeed then we may
+				 * drop the list_lock without any processing.
+				 *
+				 * Otherwise the list_lock will synchronize with
+				 * other processors updating the list of slabs.
+				 */
+				spin_lock_irqsave(&n->list_lock, flags);
+
+			}
 		}
 
 	} while (!cmpxchg_double_slab(s, page,
@@ -1025,8 +1282,24 @@ static void __slab_free(struct kmem_cache *s, struct page *page,
 		head, new.counters,
 		"__slab_free"));
 
-	if (likely(!n))
+	if (likely(!n)) {
+
+		/*
+		 * If we just froze the page then put it onto the
+		 * per cpu partial list.
+		 */
+		if (new.frozen && !was_frozen) {
+			put_cpu_partial(s, page, 1);
+			stat(s, CPU_PARTIAL_FREE);
+		}
+		/*
+		 * The list lock was not taken therefore no list
+		 * activity can be necessary.
+		 */
+		if (was_frozen)
+			stat(s, FREE_FROZEN);
 		return;
+	}
 
 	if (unlikely(!new.inuse && n->nr_partial >= s->min_partial))
 		goto slab_empty;
@@ -1035,8 +1308,10 @@ static void __slab_free(struct kmem_cache *s, struct page *page,
 	 * Objects left in the slab. If it was not on the partial list before
 	 * then add it.
 	 */
-	if (unlikely(!prior))
+	if (!kmem_cache_has_cpu_partial(s) && unlikely(!prior)) {
 		add_partial(n, page, DEACTIVATE_TO_TAIL);
+		stat(s, FREE_ADD_PARTIAL);
+	}
 
 	spin_unlock_irqrestore(&n->list_lock, flags);
 	return;
@@ -1047,10 +1322,11 @@ slab_empty:
 		 * Slab on the partial list.
 		 */
 		remove_partial(n, page);
+		stat(s, FREE_REMOVE_PARTIAL);
 	}
 
 	spin_unlock_irqrestore(&n->list_lock, flags);
-
+	stat(s, FREE_SLAB);
 	discard_slab(s, page);
 }
 
@@ -1084,8 +1360,10 @@ redo:
 				c->freelist, tid,
 				head, next_tid(tid)))) {
 
+			stat(s, CMPXCHG_DOUBLE_CPU_FAIL);
 			goto redo;
 		}
+		stat(s, FREE_FASTPATH);
 	} else
 		__slab_free(s, page, head, tail_obj, cnt, addr);
 }
@@ -1105,6 +1383,167 @@ void kmem_cache_free(struct kmem_cache *s, void *x)
 	slab_free(s, virt_to_head_page(x), x, NULL, 1, _RET_IP_);
 }
 
+struct detached_freelist {
+	struct page *page;
+	void *tail;
+	void *freelist;
+	int cnt;
+	struct kmem_cache *s;
+};
+
+/*
+ * This function progressively scans the array with free objects (with
+ * a limited look ahead) and extract objects belonging to the same
+ * page.  It builds a detached freelist directly within the given
+ * page/objects.  This can happen without any need for
+ * synchronization, because the objects are owned by running process.
+ * The freelist is build up as a single linked list in the objects.
+ * The idea is, that this detached freelist can then be bulk
+ * transferred to the real freelist(s), but only requiring a single
+ * synchronization primitive.  Look ahead in the array is limited due
+ * to performance reasons.
+ */
+static inline
+int build_detached_freelist(struct kmem_cache *s, size_t size,
+			    void **p, struct detached_freelist *df)
+{
+	size_t first_skipped_index = 0;
+	int lookahead = 3;
+	void *object;
+	struct page *page;
+
+	/* Always re-init detached_freelist */
+	df->page = NULL;
+
+	do {
+		object = p[--size];
+	} while (!object && size);
+
+	if (!object)
+		return 0;
+
+	page = virt_to_head_page(object);
+	if (!s) {
+		/* Handle kalloc'ed objects */
+		if (unlikely(!PageSlab(page))) {
+			BUG_ON(!PageCompound(page));
+			__free_pages(page, compound_order(page));
+			p[size] = NULL; /* mark object processed */
+			return size;
+		}
+		/* Derive kmem_cache from object */
+		df->s = page->slab_cache;
+	} else {
+		df->s = cache_from_obj(s, object);
+	}
+
+	/* Start new detached freelist */
+	df->page = page;
+	set_freepointer(df->s, object, NULL);
+	df->tail = object;
+	df->freelist = object;
+	p[size] = NULL; /* mark object processed */
+	df->cnt = 1;
+
+	while (size) {
+		object = p[--size];
+		if (!object)
+			continue; /* Skip processed objects */
+
+		/* df->page is always set at this point */
+		if (df->page == virt_to_head_page(object)) {
+			/* Opportunity build freelist */
+			set_freepointer(df->s, object, df->freelist);
+			df->freelist = object;
+			df->cnt++;
+			p[size] = NULL; /* mark object processed */
+
+			continue;
+		}
+
+		/* Limit look ahead search */
+		if (!--lookahead)
+			break;
+
+		if (!first_skipped_index)
+			first_skipped_index = size + 1;
+	}
+
+	return first_skipped_index;
+}
+
+/* Note that interrupts must be enabled when calling this function. */
+void kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p)
+{
+	if (WARN_ON(!size))
+		return;
+
+	do {
+		struct detached_freelist df;
+
+		size = build_detached_freelist(s, size, p, &df);
+		if (!df.page)
+			continue;
+
+		slab_free(df.s, df.page, df.freelist, df.tail, df.cnt, _RET_IP_);
+	} while (likely(size));
+}
+
+/* Note that interrupts must be enabled when calling this function. */
+int kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
+			  void **p)
+{
+	struct kmem_cache_cpu *c;
+	int i;
+
+	s = slab_pre_alloc_hook(s, flags);
+	if (unlikely(!s))
+		return false;
+	/*
+	 * Drain objects in the per cpu slab, while disabling local
+	 * IRQs, which protects against PREEMPT and interrupts
+	 * handlers invoking normal fastpath.
+	 */
+	local_irq_disable();
+	c = this_cpu_ptr(s->cpu_slab);
+
+	for (i = 0; i < size; i++) {
+		void *object = c->freelist;
+
+		if (unlikely(!object)) {
+			/*
+			 * Invoking slow path likely have side-effect
+			 * of re-populating per CPU c->freelist
+			 */
+			p[i] = ___slab_alloc(s, flags, _RET_IP_, c);
+			if (unlikely(!p[i]))
+				goto error;
+
+			c = this_cpu_ptr(s->cpu_slab);
+			continue; /* goto for-loop */
+		}
+		c->freelist = get_freepointer(s, object);
+		p[i] = object;
+	}
+	c->tid = next_tid(c->tid);
+	local_irq_enable();
+
+	/* Clear memory outside IRQ disabled fastpath loop */
+	if (unlikely(flags & __GFP_ZERO)) {
+		int j;
+
+		for (j = 0; j < i; j++)
+			memset(p[j], 0, s->object_size);
+	}
+
+	return i;
+error:
+	local_irq_enable();
+	if (i)
+		kmem_cache_free_bulk(s, i, p);
+	return 0;
+}
+
 static void free_kmem_cache_nodes(struct kmem_cache *s)
 {
 	struct kmem_cache_node *n = s->node;
@@ -1205,6 +1644,8 @@ static inline void __flush_cpu_slab(struct kmem_cache *s, int cpu)
 
 	if (c->page)
 		flush_slab(s, c);
+
+	unfreeze_partials(s, c);
 }
 
 static struct kmem_cache * __init bootstrap(struct kmem_cache *static_cache)
@@ -1390,3 +1831,141 @@ void *__kmalloc_track_caller(size_t size, gfp_t gfpflags, u64 caller)
 
 	return ret;
 }
+
+static int count_free(struct page *page)
+{
+	return page->objects - page->inuse;
+}
+
+static u64 count_partial(struct kmem_cache_node *n,
+			 int (*get_count)(struct page *))
+{
+	u64 flags;
+	u64 x = 0;
+	struct page *page;
+
+	spin_lock_irqsave(&n->list_lock, flags);
+	list_for_each_entry(page, &n->partial, lru)
+		x += get_count(page);
+	spin_unlock_irqrestore(&n->list_lock, flags);
+	return x;
+}
+
+/*
+ * Objects sitting on a cpu slab's lockless freelist are counted as in use,
+ * as are those on frozen per cpu partial slabs; only the node partial list
+ * is walked.
+ */
+void get_slabinfo(struct kmem_cache *s, struct slabinfo *sinfo)
+{
+	struct kmem_cache_node *n = s->node;
+	u64 nr_slabs = 0;
+	u64 nr_objs = 0;
+	u64 nr_free = 0;
+
+	if (n) {
+		nr_slabs = atomic64_read(&n->nr_slabs);
+		nr_objs = atomic64_read(&n->total_objects);
+		nr_free = count_partial(n, count_free);
+	}
+
+	sinfo->active_objs = nr_objs - nr_free;
+	sinfo->num_objs = nr_objs;
+	sinfo->active_slabs = nr_slabs;
+	sinfo->num_slabs = nr_slabs;
+	sinfo->objects_per_slab = oo_objects(s->oo);
+	sinfo->cache_order = oo_order(s->oo);
+}
+
+#ifdef CONFIG_SLUB_STATS
+static const char * const stat_names[NR_SLUB_STAT_ITEMS] = {
+	[ALLOC_FASTPATH]		= "alloc_fastpath",
+	[ALLOC_SLOWPATH]		= "alloc_slowpath",
+	[FREE_FASTPATH]			= "free_fastpath",
+	[FREE_SLOWPATH]			= "free_slowpath",
+	[FREE_FROZEN]			= "free_frozen",
+	[FREE_ADD_PARTIAL]		= "free_add_partial",
+	[FREE_REMOVE_PARTIAL]		= "free_remove_partial",
+	[ALLOC_FROM_PARTIAL]		= "alloc_from_partial",
+	[ALLOC_SLAB]			= "alloc_slab",
+	[ALLOC_REFILL]			= "alloc_refill",
+	[FREE_SLAB]			= "free_slab",
+	[CPUSLAB_FLUSH]			= "cpuslab_flush",
+	[DEACTIVATE_FULL]		= "deactivate_full",
+	[DEACTIVATE_EMPTY]		= "deactivate_empty",
+	[DEACTIVATE_TO_HEAD]		= "deactivate_to_head",
+	[DEACTIVATE_TO_TAIL]		= "deactivate_to_tail",
+	[DEACTIVATE_REMOTE_FREES]	= "deactivate_remote_frees",
+	[DEACTIVATE_BYPASS]		= "deactivate_bypass",
+	[ORDER_FALLBACK]		= "order_fallback",
+	[CMPXCHG_DOUBLE_CPU_FAIL]	= "cmpxchg_double_cpu_fail",
+	[CMPXCHG_DOUBLE_FAIL]		= "cmpxchg_double_fail",
+	[CPU_PARTIAL_ALLOC]		= "cpu_partial_alloc",
+	[CPU_PARTIAL_FREE]		= "cpu_partial_free",
+	[CPU_PARTIAL_NODE]		= "cpu_partial_node",
+	[CPU_PARTIAL_DRAIN]		= "cpu_partial_drain",
+};
+
+static u64 sum_stat(struct kmem_cache *s, enum stat_item si)
+{
+	u64 sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu_ptr(s->cpu_slab, cpu)->stat[si];
+
+	return sum;
+}
+#endif
+
+/**
+ * kmem_cache_stats_snapshot - take a snapshot of a cache's counters
+ * @s: the cache
+ * @st: filled in with the layout, occupancy and summed per cpu counters
+ *
+ * The per cpu counters are read without synchronisation, so the snapshot
+ * is only approximate while the cache is in use.
+ */
+void kmem_cache_stats_snapshot(struct kmem_cache *s,
+			       struct kmem_cache_stats *st)
+{
+	struct kmem_cache_node *n = s->node;
+	struct slabinfo sinfo;
+	int i;
+
+	get_slabinfo(s, &sinfo);
+
+	st->name = s->name;
+	st->object_size = s->object_size;
+	st->size = s->size;
+	st->order = sinfo.cache_order;
+	st->objects_per_slab = sinfo.objects_per_slab;
+	st->cpu_partial = slub_cpu_partial(s);
+	st->min_partial = s->min_partial;
+	st->active_objs = sinfo.active_objs;
+	st->num_objs = sinfo.num_objs;
+	st->num_slabs = sinfo.num_slabs;
+	st->partial_slabs = n ? n->nr_partial : 0;
+
+	for (i = 0; i < NR_SLUB_STAT_ITEMS; i++) {
+#ifdef CONFIG_SLUB_STATS
+		st->stat[i] = sum_stat(s, i);
+#else
+		st->stat[i] = 0;
+#endif
+	}
+}
+
+void slabinfo_show_stats(struct kmem_cache *s)
+{
+#ifdef CONFIG_SLUB_STATS
+	int i;
+
+	for (i = 0; i < NR_SLUB_STAT_ITEMS; i++) {
+		u64 sum = sum_stat(s, i);
+
+		if (sum)
+			pr_info("  %-24s %llu\n", stat_names[i], sum);
+	}
+#endif
+}
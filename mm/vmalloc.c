@@ -19,15 +19,19 @@
 #include <linux/atomic.h>
 #include <linux/compiler.h>
 #include <linux/llist.h>
+#include <linux/percpu_counter.h>
 #include <linux/bitops.h>
 #include <linux/mutex.h>
 #include <linux/radix-tree.h>
 #include <linux/sched.h>
 
 #include <asm/tlbflush.h>
+#include <asm/tlb.h>
 #include <asm/cacheflush.h>
 #include <asm/pgtable.h>
 
+#include "internal.h"
+
 static void __vunmap(const void *, int);
 static void __insert_vmap_area(struct vmap_area *va);
 static void purge_vmap_area_lazy(void);
@@ -56,52 +60,33 @@ static bool vmap_initialized __read_mostly = false;
 
 struct page *vmalloc_to_page(const void *vmalloc_addr)
 {
-#if 0 /* TODO */
 	u64 addr = (u64) vmalloc_addr;
 	struct page *page = NULL;
 	pgd_t *pgd = pgd_offset_k(addr);
-	p4d_t *p4d;
 	pud_t *pud;
 	pmd_t *pmd;
 	pte_t *ptep, pte;
 
-	/*
-	 * XXX we might need to change this if we add VIRTUAL_BUG_ON for
-	 * architectures that do not vmalloc module space
-	 */
-	VIRTUAL_BUG_ON(!is_vmalloc_or_module_addr(vmalloc_addr));
-
-	if (pgd_none(*pgd))
-		return NULL;
-	p4d = p4d_offset(pgd, addr);
-	if (p4d_none(*p4d))
+	if (pgd_none(READ_ONCE(*pgd)))
 		return NULL;
-	pud = pud_offset(p4d, addr);
+	pud = pud_offset(pgd, addr);
 
 	/*
-	 * Don't dereference bad PUD or PMD (below) entries. This will also
-	 * identify huge mappings, which we may encounter on architectures
-	 * that define CONFIG_HAVE_ARCH_HUGE_VMAP=y. Such regions will be
-	 * identified as vmalloc addresses by is_vmalloc_addr(), but are
-	 * not [unambiguously] associated with a struct page, so there is
-	 * no correct value to return for them.
+	 * Don't dereference section entries: vmalloc only installs pages, so
+	 * a block mapping here is not associated with a struct page that
+	 * the caller could want.
 	 */
-	WARN_ON_ONCE(pud_bad(*pud));
-	if (pud_none(*pud) || pud_bad(*pud))
+	if (pud_none(READ_ONCE(*pud)) || pud_sect(READ_ONCE(*pud)))
 		return NULL;
 	pmd = pmd_offset(pud, addr);
-	WARN_ON_ONCE(pmd_bad(*pmd));
-	if (pmd_none(*pmd) || pmd_bad(*pmd))
+	if (pmd_none(READ_ONCE(*pmd)) || pmd_sect(READ_ONCE(*pmd)))
 		return NULL;
 
-	ptep = pte_offset_map(pmd, addr);
-	pte = *ptep;
+	ptep = pte_offset_kernel(pmd, addr);
+	pte = READ_ONCE(*ptep);
 	if (pte_present(pte))
 		page = pte_page(pte);
-	pte_unmap(ptep);
 	return page;
-#endif
-	return NULL;
 }
 
 /*
@@ -161,9 +146,70 @@ static struct vmap_area *find_vmap_area(u64 addr)
 	return va;
 }
 
-static void vunmap_page_range(u64 addr, u64 end)
+static void vunmap_pte_range(struct mmu_gather *tlb, pmd_t *pmd,
+			     u64 addr, u64 end)
+{
+	pte_t *pte;
+
+	pte = pte_offset_kernel(pmd, addr);
+	do {
+		pte_t ptent = ptep_get_and_clear(&init_mm, addr, pte);
+		WARN_ON(!pte_none(ptent) && !pte_present(ptent));
+		if (tlb && !pte_none(ptent))
+			tlb_flush_pte_range(tlb, addr, PAGE_SIZE);
+	} while (pte++, addr += PAGE_SIZE, addr != end);
+}
+
+static void vunmap_pmd_range(struct mmu_gather *tlb, pud_t *pud,
+			     u64 addr, u64 end)
+{
+	pmd_t *pmd;
+	u64 next;
+
+	pmd = pmd_offset(pud, addr);
+	do {
+		next = pmd_addr_end(addr, end);
+		if (pmd_none(READ_ONCE(*pmd)))
+			continue;
+		if (pmd_sect(READ_ONCE(*pmd))) {
+			pmd_clear(pmd);
+			if (tlb)
+				tlb_flush_pmd_range(tlb, addr, next - addr);
+			continue;
+		}
+		vunmap_pte_range(tlb, pmd, addr, next);
+	} while (pmd++, addr = next, addr != end);
+}
+
+static void vunmap_pud_range(struct mmu_gather *tlb, pgd_t *pgd,
+			     u64 addr, u64 end)
+{
+	pud_t *pud;
+	u64 next;
+
+	pud = pud_offset(pgd, addr);
+	do {
+		next = pud_addr_end(addr, end);
+		if (pud_none(READ_ONCE(*pud)))
+			continue;
+		if (pud_sect(READ_ONCE(*pud))) {
+			pud_clear(pud);
+			if (tlb)
+				tlb_flush_pud_range(tlb, addr, next - addr);
+			continue;
+		}
+		vunmap_pmd_range(tlb, pud, addr, next);
+	} while (pud++, addr = next, addr != end);
+}
+
+/*
+ * Clear the kernel page table entries in [addr, end). When @tlb is given,
+ * every cleared entry is recorded in it so that the caller can invalidate
+ * the whole range with a single, correctly strided flush; lazy callers pass
+ * NULL and flush later from __purge_vmap_area_lazy().
+ */
+static void vunmap_page_range(struct mmu_gather *tlb, u64 addr, u64 end)
 {
-#if 0 /* TODO */
 	pgd_t *pgd;
 	u64 next;
 
@@ -171,11 +217,10 @@ static void vunmap_page_range(u64 addr, u64 end)
 	pgd = pgd_offset_k(addr);
 	do {
 		next = pgd_addr_end(addr, end);
-		if (pgd_none_or_clear_bad(pgd))
+		if (pgd_none(READ_ONCE(*pgd)))
 			continue;
-		vunmap_p4d_range(pgd, addr, next);
+		vunmap_pud_range(tlb, pgd, addr, next);
 	} while (pgd++, addr = next, addr != end);
-#endif
 }
 
 /*
@@ -183,7 +228,7 @@ static void vunmap_page_range(u64 addr, u64 end)
  */
 static void unmap_vmap_area(struct vmap_area *va)
 {
-	vunmap_page_range(va->va_start, va->va_end);
+	vunmap_page_range(NULL, va->va_start, va->va_end);
 }
 
 static void __free_vmap_area(struct vmap_area *va)
@@ -246,7 +291,13 @@ static u64 lazy_max_pages(void)
 	return log * (32UL * 1024 * 1024 / PAGE_SIZE);
 }
 
-static atomic_t vmap_lazy_nr = ATOMIC_INIT(0);
+/*
+ * Pages of lazily freed areas awaiting a purge. Every vfree() adds to it,
+ * so it is kept per cpu; the purge threshold only needs the approximate
+ * value. vmalloc_init() sets it up, which start_kernel() runs after
+ * setup_per_cpu_areas() and before anything can vfree().
+ */
+static struct percpu_counter vmap_lazy_nr;
 
 static DEFINE_MUTEX(vmap_purge_lock);
 
@@ -256,7 +307,7 @@ static DEFINE_MUTEX(vmap_purge_lock);
  */
 void set_iounmap_nonlazy(void)
 {
-	atomic_set(&vmap_lazy_nr, lazy_max_pages()+1);
+	percpu_counter_set(&vmap_lazy_nr, lazy_max_pages()+1);
 }
 
 /*
@@ -267,6 +318,7 @@ static bool __purge_vmap_area_lazy(u64 start, u64 end)
 	struct llist_node *valist;
 	struct vmap_area *va;
 	struct vmap_area *n_va;
+	struct mmu_gather tlb;
 	bool do_free = false;
 
 	valist = llist_del_all(&vmap_purge_list);
@@ -281,14 +333,22 @@ static bool __purge_vmap_area_lazy(u64 start, u64 end)
 	if (!do_free)
 		return false;
 
-	flush_tlb_kernel_range(start, end);
+	/*
+	 * All the lazily unmapped areas are invalidated together: the gather
+	 * covers their union, so a burst of vfree()s costs one broadcast
+	 * invalidation (or one full flush, if the span is too large to walk
+	 * by VA) rather than one per area.
+	 */
+	tlb_gather_mmu(&tlb, &init_mm, start, end);
+	tlb_flush_pte_range(&tlb, start, end - start);
+	tlb_finish_mmu(&tlb);
 
 	spin_lock(&vmap_area_lock);
 	llist_for_each_entry_safe(va, n_va, valist, purge_list) {
 		int nr = (va->va_end - va->va_start) >> PAGE_SHIFT;
 
 		__free_vmap_area(va);
-		atomic_sub(nr, &vmap_lazy_nr);
+		percpu_counter_sub(&vmap_lazy_nr, nr);
 		cond_resched_lock(&vmap_area_lock);
 	}
 	spin_unlock(&vmap_area_lock);
@@ -314,10 +374,11 @@ static void try_purge_vmap_area_lazy(void)
  */
 static void free_vmap_area_noflush(struct vmap_area *va)
 {
-	int nr_lazy;
+	s64 nr_lazy;
 
-	nr_lazy = atomic_add_return((va->va_end - va->va_start) >> PAGE_SHIFT,
-				    &vmap_lazy_nr);
+	percpu_counter_add(&vmap_lazy_nr,
+			   (va->va_end - va->va_start) >> PAGE_SHIFT);
+	nr_lazy = percpu_counter_read(&vmap_lazy_nr);
 
 	/* After this point, we may free va at any time */
 	llist_add(&va->purge_list, &vmap_purge_list);
@@ -554,23 +615,78 @@ struct vm_struct *get_vm_area_caller(u64 size, u64 flags,
 				GFP_KERNEL, caller);
 }
 
-#if 0 /* TODO */
-static int f(pte_t *pte, pgtable_t table, u64 addr, void *data)
+static int vmap_pte_range(pmd_t *pmd, u64 addr, u64 end,
+			  pgprot_t prot, struct page **pages, int *nr)
 {
-	pte_t ***p = data;
+	pte_t *pte;
 
-	if (p) {
-		*(*p) = pte;
-		(*p)++;
-	}
+	/*
+	 * nr is a running index into the array which helps higher level
+	 * callers keep track of where we're up to.
+	 */
+	if (pmd_none(READ_ONCE(*pmd)) && __pte_alloc(&init_mm, pmd))
+		return -ENOMEM;
+	pte = pte_offset_kernel(pmd, addr);
+	do {
+		struct page *page = pages[*nr];
+
+		if (WARN_ON(!pte_none(READ_ONCE(*pte))))
+			return -EBUSY;
+		if (WARN_ON(!page))
+			return -ENOMEM;
+		set_pte_at(&init_mm, addr, pte, mk_pte(page, prot));
+		(*nr)++;
+	} while (pte++, addr += PAGE_SIZE, addr != end);
+	return 0;
+}
+
+static int vmap_pmd_range(pud_t *pud, u64 addr, u64 end,
+			  pgprot_t prot, struct page **pages, int *nr)
+{
+	pmd_t *pmd;
+	u64 next;
+	int err;
+
+	if (pud_none(READ_ONCE(*pud)) && __pmd_alloc(&init_mm, pud))
+		return -ENOMEM;
+	pmd = pmd_offset(pud, addr);
+	do {
+		next = pmd_addr_end(addr, end);
+		err = vmap_pte_range(pmd, addr, next, prot, pages, nr);
+		if (err)
+			return err;
+	} while (pmd++, addr = next, addr != end);
+	return 0;
+}
+
+static int vmap_pud_range(pgd_t *pgd, u64 addr, u64 end,
+			  pgprot_t prot, struct page **pages, int *nr)
+{
+	pud_t *pud;
+	u64 next;
+	int err;
+
+	if (pgd_none(READ_ONCE(*pgd)) && __pud_alloc(&init_mm, pgd))
+		return -ENOMEM;
+	pud = pud_offset(pgd, addr);
+	do {
+		next = pud_addr_end(addr, end);
+		err = vmap_pmd_range(pud, addr, next, prot, pages, nr);
+		if (err)
+			return err;
+	} while (pud++, addr = next, addr != end);
 	return 0;
 }
-#endif
 
+/*
+ * Set up page tables in kva (addr, end). The ptes shall have prot "prot", and
+ * will have pfns corresponding to the "pages" array.
+ *
+ * Ie. pte at addr+N*PAGE_SIZE shall point to pfn corresponding to pages[N]
+ */
 static int vmap_page_range_noflush(u64 start, u64 end,
 				   pgprot_t prot, struct page **pages)
 {
-#if 0 /* TODO */
 	pgd_t *pgd;
 	u64 next;
 	u64 addr = start;
@@ -581,14 +697,12 @@ static int vmap_page_range_noflush(u64 start, u64 end,
 	pgd = pgd_offset_k(addr);
 	do {
 		next = pgd_addr_end(addr, end);
-		err = vmap_p4d_range(pgd, addr, next, prot, pages, &nr);
+		err = vmap_pud_range(pgd, addr, next, prot, pages, &nr);
 		if (err)
 			return err;
 	} while (pgd++, addr = next, addr != end);
 
 	return nr;
-#endif
-	return 0;
 }
 
 static int vmap_page_range(u64 start, u64 end,
@@ -623,16 +737,34 @@ int map_kernel_range_noflush(u64 addr, u64 size,
  */
 void unmap_kernel_range_noflush(u64 addr, u64 size)
 {
-	vunmap_page_range(addr, addr + size);
+	vunmap_page_range(NULL, addr, addr + size);
+}
+
+/**
+ * unmap_kernel_range_gather - unmap kernel VM area into an mmu_gather
+ * @tlb: gather started with tlb_gather_mmu() on &init_mm
+ * @addr: start of the VM area to unmap
+ * @size: size of the VM area to unmap
+ *
+ * Like unmap_kernel_range_noflush(), but records the cleared entries in
+ * @tlb so that several areas can be torn down under a single invalidation
+ * issued by tlb_finish_mmu(). Pages queued with tlb_remove_page() on the
+ * same gather are only freed after that invalidation.
+ */
+void unmap_kernel_range_gather(struct mmu_gather *tlb, u64 addr, u64 size)
+{
+	vunmap_page_range(tlb, addr, addr + size);
 }
 
 void unmap_kernel_range(u64 addr, u64 size)
 {
+	struct mmu_gather tlb;
 	u64 end = addr + size;
 
 	flush_cache_vunmap(addr, end);
-	vunmap_page_range(addr, end);
-	flush_tlb_kernel_range(addr, end);
+	tlb_gather_mmu(&tlb, &init_mm, addr, end);
+	vunmap_page_range(&tlb, addr, end);
+	tlb_finish_mmu(&tlb);
 }
 
 int map_vm_area(struct vm_struct *area, pgprot_t prot, struct page **pages)
@@ -652,7 +784,15 @@ static void *__vmalloc_area_node(struct vm_struct *area, gfp_t gfp_mask,
 	struct page **pages;
 	unsigned int nr_pages, array_size, i;
 	const gfp_t nested_gfp = (gfp_mask) | __GFP_ZERO;
-	const gfp_t alloc_mask = gfp_mask | __GFP_NOWARN;
+	/*
+	 * Zero a writable area in one go once it is mapped, rather than page
+	 * by page, so that large areas are cleared without going through the
+	 * caches.
+	 */
+	const bool zero_mapped = (gfp_mask & __GFP_ZERO) &&
+				 pgprot_val(prot) == pgprot_val(PAGE_KERNEL);
+	const gfp_t alloc_mask = (zero_mapped ? gfp_mask & ~__GFP_ZERO :
+				  gfp_mask) | __GFP_NOWARN;
 
 	nr_pages = get_vm_area_size(area) >> PAGE_SHIFT;
 	array_size = (nr_pages * sizeof(struct page *));
@@ -687,6 +827,9 @@ static void *__vmalloc_area_node(struct vm_struct *area, gfp_t gfp_mask,
 
 	if (map_vm_area(area, prot, pages))
 		goto fail;
+
+	if (zero_mapped)
+		clear_pages(area->addr, area->nr_pages);
 	return area->addr;
 
 fail:
@@ -1403,6 +1546,9 @@ void __init vmalloc_init(void)
 	struct vm_struct *tmp;
 	int i;
 
+	if (percpu_counter_init(&vmap_lazy_nr, 0, GFP_KERNEL))
+		panic("vmalloc: cannot allocate lazy page counter\n");
+
 	for_each_possible_cpu(i) {
 		struct vmap_block_queue *vbq;
 		struct vfree_deferred *p;